@@ -6,6 +6,8 @@
 #include "QueryResult.h"
 #include "QueryCommand.h"
 
+#include <chrono>
+
 namespace RabidSQL {
 
 class DatabaseConnectionManager;
@@ -16,15 +18,21 @@ class DatabaseConnection: virtual public Thread
 public:
     enum Constants
     {
-        EXECUTED = 10
+        EXECUTED = 10,
+        ROWS_FETCHED = 20
     };
 
+    static const size_t STREAM_BATCH_ROWS = 8192;
+    static const int STREAM_INTERVAL = 100;
+
     DatabaseConnection(ConnectionSettings *settings);
     DatabaseConnection(DatabaseConnection *mainConnection,
                        DatabaseConnectionManager *manager);
     virtual void disconnect() = 0;
     virtual QueryResult connect() = 0;
     virtual QueryResult execute(VariantVector arguments) = 0;
+    virtual std::vector<QueryResult> executeBatch(
+            const std::vector<VariantVector> &statements, bool multiStatement);
     virtual QueryResult getDatabases(
             std::vector<std::string> filter = std::vector<std::string>()) = 0;
     virtual QueryResult getTables(std::string database) = 0;
@@ -42,11 +50,29 @@ protected:
         VariantVector arguments = VariantVector());
     virtual void run();
     DatabaseConnection *getDatabaseConnection(std::string uuid);
+    bool isStreaming() const;
+    virtual bool inTransaction() const;
+    virtual QueryResult beginTransaction();
+    virtual QueryResult endTransaction(bool commit);
+    const std::string &getDatabase() const;
+    void streamRows(QueryResult &result);
 
 private:
+    QueryResult query(const QueryCommand &command);
+    QueryResult stream(const QueryCommand &command);
+    QueryResult batch(const QueryCommand &command, VariantVector &results);
+    void queueRows(QueryResult &result);
+
     std::queue<QueryCommand> commands;
     DatabaseConnection *mainConnection;
     bool busy;
+    bool streaming;
+    std::string database;
+    std::vector<std::string> transactionWrites;
+    Variant streamUid;
+    size_t streamedRows;
+    std::vector<ColumnStats> streamStats;
+    std::chrono::steady_clock::time_point lastBatch;
 };
 
 } // namespace RabidSQL
@@ -3,9 +3,18 @@
 
 #include "../../DatabaseConnection.h"
 
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 namespace sql {
 class Connection;
 class Driver;
+class PreparedStatement;
+class ResultSet;
+class Statement;
 }
 
 namespace RabidSQL {
@@ -24,24 +33,94 @@ public:
 
     QueryResult connect();
     QueryResult execute(VariantVector arguments);
+    std::vector<QueryResult> executeBatch(
+            const std::vector<VariantVector> &statements, bool multiStatement);
     QueryResult getDatabases(
             std::vector<std::string> filter = std::vector<std::string>());
     QueryResult getTables(std::string database);
     QueryResult selectDatabase(std::string database);
     QueryResult killQuery(std::string uuid);
     void disconnect();
+    unsigned long long getStatementCacheHits() const;
+    unsigned long long getStatementCacheMisses() const;
     virtual ~DatabaseConnection();
 
+    // Prepared statements kept per connection when the "statement_cache_size"
+    // setting is unset
+    static const size_t DEFAULT_STATEMENT_CACHE_SIZE = 64;
+
 protected:
     int connection_id;
+    bool inTransaction() const;
+    QueryResult beginTransaction();
+    QueryResult endTransaction(bool commit);
 
 private:
+    typedef std::list<std::pair<std::string, sql::PreparedStatement *>>
+            Statements;
+    typedef void (*CellReader)(sql::ResultSet *sqlResult, unsigned int index,
+                               ResultColumn &column);
+
+    QueryResult reconnect();
+    void closeConnection();
+    void trackTransaction(const std::string &sql);
+    sql::PreparedStatement *prepare(const std::string &sql);
+    static void bind(sql::PreparedStatement *sqlStatement, unsigned int index,
+                     const Variant &value,
+                     std::vector<std::unique_ptr<std::istream>> &blobs);
+    void release(const std::string &sql, sql::PreparedStatement *statement,
+                 bool failed);
+    void clearStatements();
+    void readResult(sql::ResultSet *sqlResult, bool unbuffered,
+                    QueryResult &result);
+    void skipResults(sql::Statement *sqlStatement, QueryResult &result);
+    void executeScript(const std::vector<VariantVector> &statements,
+                       size_t first, size_t last,
+                       std::vector<QueryResult> &results);
+    void readRows(sql::ResultSet *sqlResult,
+                  const std::vector<CellReader> &readers, QueryResult &result);
+    static CellReader readerFor(int sqlType, bool isSigned, DataType &type);
+    static void readString(sql::ResultSet *sqlResult, unsigned int index,
+                           ResultColumn &column);
+    static void readBlob(sql::ResultSet *sqlResult, unsigned int index,
+                         ResultColumn &column);
+    static void readDate(sql::ResultSet *sqlResult, unsigned int index,
+                         ResultColumn &column);
+    static void readDecimal(sql::ResultSet *sqlResult, unsigned int index,
+                            ResultColumn &column);
+    static void readLongLong(sql::ResultSet *sqlResult, unsigned int index,
+                             ResultColumn &column);
+    static void readULongLong(sql::ResultSet *sqlResult, unsigned int index,
+                              ResultColumn &column);
+    static void readDouble(sql::ResultSet *sqlResult, unsigned int index,
+                           ResultColumn &column);
+    static void readFloat(sql::ResultSet *sqlResult, unsigned int index,
+                          ResultColumn &column);
+    static void readNull(sql::ResultSet *sqlResult, unsigned int index,
+                         ResultColumn &column);
+    static void readInt(sql::ResultSet *sqlResult, unsigned int index,
+                        ResultColumn &column);
+    static void readUInt(sql::ResultSet *sqlResult, unsigned int index,
+                         ResultColumn &column);
+    static void readYear(sql::ResultSet *sqlResult, unsigned int index,
+                         ResultColumn &column);
+
     sql::Driver *driver;
     sql::Connection *connection;
     std::string hostname;
     std::string username;
     std::string password;
     unsigned int port;
+    bool unbuffered;
+    bool multiStatements;
+    bool transaction;
+    bool autocommit;
+    size_t resultMemoryLimit;
+    size_t statementCacheSize;
+    Statements statements;
+    std::unordered_map<std::string, Statements::iterator> statementIndex;
+    unsigned long long statementHits;
+    unsigned long long statementMisses;
 };
 
 } // namespace MySQLDriver
@@ -4,16 +4,57 @@
 #include "SettingsField.h"
 #include "../include/DatabaseConnection.h"
 
+#include <connection.h>
 #include <driver.h>
 #include <resultset.h>
 #include <statement.h>
 #include <prepared_statement.h>
 
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
 using namespace sql;
 
 namespace RabidSQL {
 namespace MySQLDriver {
 
+const size_t DatabaseConnection::DEFAULT_STATEMENT_CACHE_SIZE;
+
+// Client and server errors for a connection that has been dropped
+static const int SERVER_GONE_ERROR = 2006;
+static const int SERVER_LOST = 2013;
+static const int CLIENT_INTERACTION_TIMEOUT = 4031;
+
+/**
+ *
+ * Returns true if an error means the connection has been dropped
+ *
+ * @param code The error code
+ * @return bool
+ */
+static bool isConnectionLost(int code)
+{
+    return code == SERVER_GONE_ERROR || code == SERVER_LOST
+            || code == CLIENT_INTERACTION_TIMEOUT;
+}
+
+/**
+ *
+ * Returns true if words starts with the whole words of prefix
+ *
+ * @param words Upper case words separated by single spaces
+ * @param prefix The words to look for
+ * @return bool
+ */
+static bool startsWith(const std::string &words, const char *prefix)
+{
+    size_t length = strlen(prefix);
+
+    return words.compare(0, length, prefix) == 0
+            && (words.size() == length || words[length] == ' ');
+}
+
 /**
  *
  * Constructs the database connection
@@ -26,11 +67,25 @@ DatabaseConnection::DatabaseConnection(ConnectionSettings *settings):
     connection = nullptr;
     driver = nullptr;
     connection_id = 0;
+    transaction = false;
+    autocommit = true;
 
     hostname = settings->get("hostname").toString();
     username = settings->get("username").toString();
     port = settings->get("port").toUInt();
     password = settings->get("password").toString();
+    unbuffered = settings->get("unbuffered").toBool();
+    multiStatements = settings->get("multi_statements").toBool();
+
+    // Megabytes of result rows to keep in memory before spilling to disk
+    resultMemoryLimit = static_cast<size_t>(
+        settings->get("result_memory_limit").toULongLong()) * 1024 * 1024;
+
+    Variant cacheSize = settings->get("statement_cache_size");
+    statementCacheSize = cacheSize.isNull() ? DEFAULT_STATEMENT_CACHE_SIZE
+                                            : cacheSize.toUInt();
+    statementHits = 0;
+    statementMisses = 0;
 }
 
 /**
@@ -48,11 +103,19 @@ DatabaseConnection::DatabaseConnection(DatabaseConnection *mainConnection,
     connection = nullptr;
     driver = nullptr;
     connection_id = 0;
+    transaction = false;
+    autocommit = true;
 
     hostname = mainConnection->hostname;
     username = mainConnection->username;
     port = mainConnection->port;
     password = mainConnection->password;
+    unbuffered = mainConnection->unbuffered;
+    multiStatements = mainConnection->multiStatements;
+    resultMemoryLimit = mainConnection->resultMemoryLimit;
+    statementCacheSize = mainConnection->statementCacheSize;
+    statementHits = 0;
+    statementMisses = 0;
 }
 
 /**
@@ -78,34 +141,49 @@ QueryResult DatabaseConnection::connect()
     }
 
     if (connection == nullptr) {
+        Statement *sqlStatement = nullptr;
+        ResultSet *sqlResult = nullptr;
+
+        // Statements prepared on an earlier connection are gone with it
+        clearStatements();
 
         try {
 
-            connection = driver->connect(hostname, username,
-                                                        password);
+            ConnectOptionsMap options;
+            options["hostName"] = SQLString(hostname);
+            options["userName"] = SQLString(username);
+            options["password"] = SQLString(password);
+
+            if (multiStatements) {
+
+                // Lets a batch send several statements in one round trip.
+                // Only set when asked for, since it also lets a plain
+                // statement carry more statements after a ';'.
+                options["CLIENT_MULTI_STATEMENTS"] = true;
+            }
+
+            connection = driver->connect(options);
+
+            // KILL QUERY needs the id while this connection is busy, so it
+            // can't be fetched later. A plain statement takes one round trip
+            // where a prepared one takes three.
+            sqlStatement = connection->createStatement();
+            sqlResult = sqlStatement->executeQuery("SELECT CONNECTION_ID()");
+            connection_id = sqlResult->next() ? sqlResult->getUInt(1) : 0;
         } catch (SQLException &e) {
 
             result.error.isError = true;
             result.error.code = e.getErrorCode();
             result.error.string = e.getSQLState() + ": " + e.what();
-
-            return result;
         }
 
-        // Reset result
-        result = QueryResult();
-
-        // Get connection id
-        result = this->execute(VariantVector() << "SELECT CONNECTION_ID()");
-        if (result.rows.size() == 0 || result.error.isError) {
+        // Free memory
+        delete sqlResult;
+        delete sqlStatement;
 
-            // No row returned
-            return result;
+        if (result.error.isError) {
+            closeConnection();
         }
-        connection_id = result.rows.front().front().toUInt();
-
-        // Reset result
-        result = QueryResult();
 
         return result;
     }
@@ -128,6 +206,12 @@ QueryResult DatabaseConnection::killQuery(std::string uuid)
     connection = dynamic_cast<DatabaseConnection *>(
                 getDatabaseConnection(uuid));
 
+    if (connection->connection_id == 0) {
+
+        // Never connected, so not running anything
+        return QueryResult();
+    }
+
     return execute(VariantVector() << "KILL QUERY "
                    + Variant(connection->connection_id).toString());
 }
@@ -221,147 +305,540 @@ QueryResult DatabaseConnection::getTables(std::string database)
  *
  * Executes a query and returns the result
  *
+ * Results are normally buffered: Connector/C++ reads the whole result from
+ * the server before the first row is handed over. Unbuffered results (the
+ * "unbuffered" connection setting, an "unbuffered" query option, or any
+ * streamed query) are read from the server row by row instead, so the client
+ * never holds a second copy of the result. Connector/C++ always buffers the
+ * results of prepared statements, so only queries without bind parameters can
+ * be unbuffered. They are sent as plain statements; queries with parameters
+ * are buffered whatever the setting.
+ *
+ * An unbuffered result ties up the server connection until every row has been
+ * read. KILL_QUERY from another connection still works mid-result: the server
+ * stops sending rows, and the result comes back with the rows read so far and
+ * the interruption as its error. Streamed batches already queued stay valid.
+ * A buffered result is killed while the server is still sending it, so it
+ * comes back with the error and no rows.
+ *
+ * Other statements are prepared once per connection and kept in a cache of
+ * the "statement_cache_size" most recently used, so running the same SQL
+ * again skips the prepare round trip.
+ *
+ * If the server has dropped the connection, it is made again and, if the
+ * statement can't have run, the statement is run again. Session state such as
+ * variables and temporary tables is lost; the selected database is kept.
+ * Inside a transaction (after START TRANSACTION or BEGIN, or with autocommit
+ * off) the statement isn't run again: the error is returned, and the next
+ * statement starts a new session.
+ *
  * @param VariantVector arguments The query arguments. The first argument should
- * be the query and any subsequent arguments are the bind parameters
+ * be the query and any subsequent arguments are the bind parameters, sent as
+ * their own types rather than as text (see bind()). A
+ * trailing VariantMap holds query options rather than a parameter; the only
+ * option is "unbuffered", overriding the connection setting.
  *
  * @return The results from the query
  */
 QueryResult DatabaseConnection::execute(VariantVector arguments)
 {
-    int i;
-    int count;
     QueryResult result;
     ResultSet *sqlResult;
-    ResultSetMetaData *sqlMetadata;
+    bool unbuffered = this->unbuffered || isStreaming();
 
-    result = connect();
-    if (result.error.isError) {
+    if (arguments.size() > 1 && arguments.back().getType() == D_VARIANTMAP) {
 
-        // There was an error connecting. Return the result.
-        return result;
+        // Query options
+        VariantMap options = arguments.back().toVariantMap();
+        arguments.pop_back();
+
+        auto it = options.find("unbuffered");
+        if (it != options.end()) {
+            unbuffered = it->second.toBool() || isStreaming();
+        }
+    }
+
+    if (connection == nullptr) {
+
+        // Never connected, or closed after an error. Either way the selected
+        // database is selected again.
+        result = reconnect();
+
+        if (result.error.isError) {
+
+            // There was an error connecting. Return the result.
+            return result;
+        }
     }
 
+    std::string sql = arguments.front().toString();
     PreparedStatement *sqlStatement = nullptr;
+    Statement *plainStatement = nullptr;
+    bool sent = false;
 
-    try {
+    // Blob parameters are read from these when the statement executes
+    std::vector<std::unique_ptr<std::istream>> blobs;
+
+    for (int attempt = 0; ; attempt++) {
+        try {
+
+            if (unbuffered && arguments.size() == 1) {
+
+                // Only plain statements read rows as the server sends them
+                plainStatement = connection->createStatement();
+                plainStatement->setResultSetType(ResultSet::TYPE_FORWARD_ONLY);
+
+                sent = true;
+
+                if (plainStatement->execute(sql)) {
+                    sqlResult = plainStatement->getResultSet();
+                } else {
+                    sqlResult = nullptr;
+                    result.affected_rows = static_cast<int>(
+                        plainStatement->getUpdateCount());
+                    skipResults(plainStatement, result);
+                }
+
+                break;
+            }
+
+            // Prepare query
+            sqlStatement = prepare(sql);
+
+            if (arguments.size() > 1) {
+
+                // Bind arguments
+                int i = 1;
+                for (auto it = arguments.begin() + 1; it != arguments.end();
+                     ++it) {
+
+                    bind(sqlStatement, i, *it, blobs);
+
+                    i++;
+                }
+            }
+
+            // Execute query
+            sent = true;
+
+            if (sqlStatement->execute()) {
+
+                // Fetch results
+                sqlResult = sqlStatement->getResultSet();
+            } else {
+
+                // Prepared statements don't report the rows they changed
+                std::unique_ptr<Statement> countStatement(
+                    connection->createStatement());
+                std::unique_ptr<ResultSet> count(
+                    countStatement->executeQuery("SELECT ROW_COUNT()"));
+
+                sqlResult = nullptr;
+                result.affected_rows = count->next() ? count->getInt(1) : 0;
+            }
+
+            break;
+        } catch (SQLException &e) {
+            int code = e.getErrorCode();
+
+            delete plainStatement;
+            plainStatement = nullptr;
+
+            if (sqlStatement != nullptr) {
+
+                // Don't keep a statement that failed
+                release(sql, sqlStatement, true);
+                sqlStatement = nullptr;
+            }
 
-        // Prepare query
-        sqlStatement = connection->prepareStatement(
-            arguments.front().toString());
+            if (isConnectionLost(code)) {
 
-        if (arguments.size() > 1) {
+                // The connection is no use any more. It is only reported gone
+                // before a statement is sent, so the statement can be run
+                // again unless the connection was lost while it ran. Not in a
+                // transaction though: the server has rolled back what ran of
+                // it, and the rest would be committed on their own.
+                if (attempt == 0 && (!sent || code != SERVER_LOST)
+                        && !inTransaction()) {
+                    result = reconnect();
 
-            // Bind arguments
-            int i = 1;
-            for (auto it = arguments.begin() + 1; it != arguments.end(); ++it) {
+                    if (result.error.isError) {
+                        return result;
+                    }
 
-                sqlStatement->setString(i, it->toString());
+                    blobs.clear();
+                    sent = false;
+                    continue;
+                }
 
-                i++;
+                closeConnection();
             }
+
+            result.error.isError = true;
+            result.error.code = code;
+            result.error.string = e.getSQLState() + ": " + e.what();
+
+            return result;
         }
+    }
 
-        // Execute query
-        sqlStatement->execute();
+    trackTransaction(sql);
 
-        // Fetch results
-        sqlResult = sqlStatement->getResultSet();
-    } catch (SQLException &e) {
+    if (sqlResult == nullptr) {
 
         if (sqlStatement != nullptr) {
+            release(sql, sqlStatement, false);
+        }
+
+        delete plainStatement;
+
+        return result;
+    }
+
+    readResult(sqlResult, plainStatement != nullptr, result);
+
+    // Free memory
+    delete sqlResult;
+
+    if (plainStatement != nullptr && !result.error.isError) {
+        skipResults(plainStatement, result);
+    }
+
+    if (sqlStatement != nullptr) {
+        release(sql, sqlStatement, result.error.isError);
+    }
+
+    delete plainStatement;
+
+    if (result.error.isError && isConnectionLost(result.error.code.toInt())) {
+
+        // The next query connects again
+        closeConnection();
+    }
+
+    return result;
+}
+
+/**
+ *
+ * Describes the columns of a result and reads its rows
+ *
+ * @param sqlResult The result to read
+ * @param unbuffered True if the rows haven't been buffered on the client
+ * @param result The result to add the columns and rows to
+ * @return void
+ */
+void DatabaseConnection::readResult(ResultSet *sqlResult, bool unbuffered,
+                                    QueryResult &result)
+{
+    ResultSetMetaData *sqlMetadata = sqlResult->getMetaData();
+    unsigned int count = sqlMetadata->getColumnCount();
+
+    // Describe the columns and pick how each one is read, once for the result
+    // rather than once per cell
+    std::vector<CellReader> readers;
+    readers.reserve(count);
+
+    for (unsigned int i = 1; i <= count; i++) {
+        ColumnInfo info;
+
+        info.name = sqlMetadata->getColumnName(i).asStdString();
+        info.table = sqlMetadata->getTableName(i).asStdString();
+        info.database = sqlMetadata->getSchemaName(i).asStdString();
+        info.sqlType = sqlMetadata->getColumnTypeName(i).asStdString();
+        info.nullable = sqlMetadata->isNullable(i) != 0;
+        info.length = sqlMetadata->getColumnDisplaySize(i);
+        info.decimals = sqlMetadata->getScale(i);
+        info.charset = sqlMetadata->getColumnCharset(i).asStdString();
+
+        readers.push_back(readerFor(sqlMetadata->getColumnType(i),
+                                    sqlMetadata->isSigned(i), info.type));
+
+        // Add to collection
+        result.columns.push_back(info.name);
+        result.columnInfo.push_back(std::move(info));
+    }
+
+    // Cells are appended straight to their column, so strings are copied once
+    // into the column's buffer instead of into a variant each
+    result.rows.setColumnCount(count);
+    result.rows.setMemoryLimit(resultMemoryLimit);
+
+    if (isStreaming()) {
+        result.rows.reserve(STREAM_BATCH_ROWS);
+    } else if (!unbuffered) {
+
+        // Unbuffered results can't be counted until they've been read
+        result.rows.reserve(sqlResult->rowsCount());
+    }
+
+    try {
+        readRows(sqlResult, readers, result);
+    } catch (SQLException &e) {
+
+        // The result was cut short, most likely by KILL QUERY. Keep the rows
+        // read so far.
+        result.error.isError = true;
+        result.error.code = e.getErrorCode();
+        result.error.string = e.getSQLState() + ": " + e.what();
+    }
+
+    if (!isStreaming()) {
+        result.columnStats = result.rows.statistics();
+    }
+}
+
+/**
+ *
+ * Reads and drops the results of any statements that followed the first in a
+ * plain statement's SQL. Left unread, they would put the connection out of
+ * step with the server. Only connections with the "multi_statements" setting
+ * can send more than one statement.
+ *
+ * @param sqlStatement The statement, its first result read
+ * @param result Receives the error of a later statement that failed
+ * @return void
+ */
+void DatabaseConnection::skipResults(Statement *sqlStatement,
+                                     QueryResult &result)
+{
+    if (!multiStatements) {
+        return;
+    }
+
+    try {
+
+        for (;;) {
 
-            // Free memory
-            delete sqlStatement;
+            if (sqlStatement->getMoreResults()) {
+                delete sqlStatement->getResultSet();
+            } else if (sqlStatement->getUpdateCount()
+                       == static_cast<uint64_t>(-1)) {
+                break;
+            }
         }
+    } catch (SQLException &e) {
 
         result.error.isError = true;
         result.error.code = e.getErrorCode();
         result.error.string = e.getSQLState() + ": " + e.what();
+    }
+}
 
-        return result;
+/**
+ *
+ * Runs statements one after another, stopping at the first that fails. With
+ * multiStatement and the "multi_statements" connection setting, statements
+ * without parameters that follow one another are sent together in one round
+ * trip. They then aren't prepared.
+ *
+ * @param statements The statements. Each holds the query followed by its
+ * bind parameters, as execute() takes them.
+ * @param multiStatement True to send statements together where possible
+ * @return The result of each statement run
+ */
+std::vector<QueryResult> DatabaseConnection::executeBatch(
+        const std::vector<VariantVector> &statements, bool multiStatement)
+{
+    std::vector<QueryResult> results;
+    size_t first = 0;
+
+    while (first < statements.size()) {
+        size_t last = first;
+
+        while (multiStatement && multiStatements && last < statements.size()
+               && statements[last].size() == 1) {
+            last++;
+        }
+
+        if (last - first > 1) {
+            executeScript(statements, first, last, results);
+            first = last;
+        } else {
+            results.push_back(execute(statements[first]));
+            first++;
+        }
+
+        if (results.back().error.isError) {
+            break;
+        }
     }
 
-    sqlMetadata = sqlResult->getMetaData();
+    return results;
+}
 
-    count = sqlMetadata->getColumnCount();
+/**
+ *
+ * Sends statements without parameters to the server together and reads each
+ * one's result. The server stops at the first that fails. The connection is
+ * closed after any error, since unread results of the script would leave it
+ * unusable; its session state, such as an open transaction, goes with it.
+ *
+ * @param statements The statements
+ * @param first The index of the first statement to send
+ * @param last The index past the last statement to send
+ * @param results Receives the result of each statement run
+ * @return void
+ */
+void DatabaseConnection::executeScript(
+        const std::vector<VariantVector> &statements, size_t first,
+        size_t last, std::vector<QueryResult> &results)
+{
+    Statement *sqlStatement = nullptr;
+    std::string script;
 
-    for (i = 1; i <= count; i++) {
+    for (size_t i = first; i < last; i++) {
+        std::string sql = statements[i].front().toString();
 
-        // Add to collection
-        result.columns.push_back(sqlMetadata->getColumnName(i).asStdString());
+        // An empty statement between two separators is an error
+        size_t end = sql.find_last_not_of("; \t\r\n");
+        script.append(sql, 0, end == std::string::npos ? 0 : end + 1);
+        script += ";\n";
     }
 
-    // Read rows
-    while (sqlResult->next()) {
-        VariantVector row;
-        for (i = 1; i <= count; i++) {
-            Variant column;
-
-            switch (sqlMetadata->getColumnType(i)) {
-            default:
-            case ::DataType::UNKNOWN:
-            case ::DataType::CHAR:
-            case ::DataType::VARCHAR:
-            case ::DataType::LONGVARCHAR:
-            case ::DataType::BINARY:
-            case ::DataType::VARBINARY:
-            case ::DataType::LONGVARBINARY:
-            case ::DataType::TIMESTAMP:
-            case ::DataType::DATE:
-            case ::DataType::GEOMETRY:
-            case ::DataType::ENUM:
-            case ::DataType::SET:
-            case ::DataType::BIGINT:
-            case ::DataType::REAL:
-            case ::DataType::DOUBLE:
-            case ::DataType::DECIMAL:
-                // @TODO: store binary, timestamp, date, & geometry differently
-                // Also numeric types (need to be added to Variant class)
-                column = sqlResult->getString(i).asStdString();
-                break;
-            case ::DataType::SQLNULL:
-                column = Variant();
-                break;
-            case ::DataType::BIT:
-            case ::DataType::TINYINT:
-            case ::DataType::SMALLINT:
-            case ::DataType::MEDIUMINT:
-            case ::DataType::INTEGER:
-            case ::DataType::NUMERIC:
-                column = sqlResult->getInt(i);
-                break;
-            case ::DataType::YEAR:
-                column = static_cast<unsigned short>(sqlResult->getUInt(i));
+    if (connection == nullptr) {
+        QueryResult result = reconnect();
+
+        if (result.error.isError) {
+            results.push_back(std::move(result));
+            return;
+        }
+    }
+
+    try {
+        sqlStatement = connection->createStatement();
+        bool hasRows = sqlStatement->execute(script);
+
+        for (size_t i = first; i < last; i++) {
+            QueryResult result;
+
+            if (hasRows) {
+                ResultSet *sqlResult = sqlStatement->getResultSet();
+                readResult(sqlResult, false, result);
+                delete sqlResult;
+            } else {
+                result.affected_rows = static_cast<int>(
+                    sqlStatement->getUpdateCount());
+            }
+
+            results.push_back(std::move(result));
+            trackTransaction(statements[i].front().toString());
+
+            if (results.back().error.isError) {
                 break;
             }
 
-            // Add column to collection
-            row.push_back(column);
+            if (i + 1 < last) {
+                hasRows = sqlStatement->getMoreResults();
+            }
         }
+    } catch (SQLException &e) {
+        QueryResult result;
 
-        // Add row to collection
-        result.rows.push_back(row);
+        // Reported for the statement that failed
+        result.error.isError = true;
+        result.error.code = e.getErrorCode();
+        result.error.string = e.getSQLState() + ": " + e.what();
+        results.push_back(std::move(result));
     }
 
     // Free memory
-    delete sqlResult;
     delete sqlStatement;
 
+    if (results.back().error.isError) {
+
+        // Results of the rest of the script may still be waiting to be read,
+        // which would put the connection out of step with the server. The
+        // next query connects again.
+        closeConnection();
+    }
+}
+
+/**
+ *
+ * Reads every row of a result
+ *
+ * @param sqlResult The result to read
+ * @param readers The reader for each column
+ * @param result The result to add the rows to. Its column info must be set.
+ * @return void
+ */
+void DatabaseConnection::readRows(ResultSet *sqlResult,
+                                  const std::vector<CellReader> &readers,
+                                  QueryResult &result)
+{
+    size_t i;
+    size_t count = readers.size();
+
+    while (sqlResult->next()) {
+        result.rows.addRow();
+
+        for (i = 0; i < count; i++) {
+            ResultColumn &column = result.rows.appendTo(i);
+
+            if (result.columnInfo[i].nullable && sqlResult->isNull(i + 1)) {
+                column.appendNull();
+            } else {
+                readers[i](sqlResult, i + 1, column);
+            }
+        }
+
+        // Hand off a batch if one is due
+        streamRows(result);
+    }
+}
+
+/**
+ *
+ * Connects again after the server has dropped the connection, selecting the
+ * database that was selected before
+ *
+ * @return A QueryResult. error.isError will be false on success.
+ */
+QueryResult DatabaseConnection::reconnect()
+{
+    QueryResult result;
+
+    closeConnection();
+    result = connect();
+
+    if (result.error.isError || getDatabase().empty()) {
+        return result;
+    }
+
+    try {
+        connection->setSchema(getDatabase());
+    } catch (SQLException &e) {
+        result.error.isError = true;
+        result.error.code = e.getErrorCode();
+        result.error.string = e.getSQLState() + ": " + e.what();
+    }
+
     return result;
 }
 
 /**
  *
- * Disconnects from the database
+ * Frees the connection and its statements, without ending the driver's thread
+ * state
  *
  * @return void
  */
-void DatabaseConnection::disconnect()
+void DatabaseConnection::closeConnection()
 {
+    // Statements must go before the connection they were prepared on
+    clearStatements();
+
     if (connection != nullptr) {
 
-        // Close connection
-        connection->close();
+        try {
+
+            // Close connection
+            connection->close();
+        } catch (SQLException &) {
+
+            // Already closed by the server
+        }
 
         // Free memory
         delete connection;
@@ -369,13 +846,648 @@ void DatabaseConnection::disconnect()
         connection = nullptr;
     }
 
-    if (driver != nullptr) {
+    // A new session starts outside any transaction
+    connection_id = 0;
+    transaction = false;
+    autocommit = true;
+}
 
-        // End the thread in the MySQL driver's internals
-        driver->threadEnd();
+/**
+ *
+ * Follows the statements that open and close transactions, so that a dropped
+ * connection isn't replaced in the middle of one. Statements that commit
+ * implicitly are only recognised by their first word.
+ *
+ * @param sql A statement that has been run
+ * @return void
+ */
+void DatabaseConnection::trackTransaction(const std::string &sql)
+{
+    std::string words;
 
-        driver = nullptr;
+    // The start of the statement, upper case with single spaces
+    for (size_t i = 0; i < sql.size() && words.size() < 64; i++) {
+        char c = sql[i];
+
+        if (::isspace(static_cast<unsigned char>(c)) || c == '(') {
+
+            if (!words.empty() && words.back() != ' ') {
+                words += ' ';
+            }
+        } else {
+            words += static_cast<char>(::toupper(static_cast<unsigned char>(
+                c)));
+        }
     }
+
+    while (!words.empty() && (words.back() == ' ' || words.back() == ';')) {
+        words.pop_back();
+    }
+
+    if (startsWith(words, "START TRANSACTION") || words == "BEGIN"
+            || words == "BEGIN WORK") {
+        transaction = true;
+    } else if (startsWith(words, "COMMIT")
+               || (startsWith(words, "ROLLBACK")
+                   && words.find(" TO ") == std::string::npos)) {
+        transaction = false;
+    } else if (startsWith(words, "SET") && words.find("AUTOCOMMIT")
+               != std::string::npos) {
+        size_t value = words.find_first_not_of(" =:",
+                                               words.find("AUTOCOMMIT") + 10);
+
+        if (value != std::string::npos) {
+            autocommit = words[value] != '0'
+                    && words.compare(value, 3, "OFF") != 0;
+        }
+
+        if (autocommit) {
+            transaction = false;
+        }
+    } else if (startsWith(words, "CREATE") || startsWith(words, "ALTER")
+               || startsWith(words, "DROP") || startsWith(words, "TRUNCATE")
+               || startsWith(words, "RENAME") || startsWith(words, "LOCK")) {
+
+        // These commit the open transaction
+        transaction = false;
+    }
+}
+
+/**
+ *
+ * Returns true if statements run now belong to a transaction that a new
+ * connection wouldn't continue
+ *
+ * @return bool
+ */
+bool DatabaseConnection::inTransaction() const
+{
+    return transaction || !autocommit;
+}
+
+/**
+ *
+ * Starts the transaction a batch runs in. START TRANSACTION can't be
+ * prepared, so it is sent as a plain statement.
+ *
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::beginTransaction()
+{
+    QueryResult result;
+    Statement *sqlStatement = nullptr;
+
+    if (connection == nullptr) {
+        result = reconnect();
+
+        if (result.error.isError) {
+            return result;
+        }
+    }
+
+    try {
+        sqlStatement = connection->createStatement();
+        sqlStatement->execute("START TRANSACTION");
+        transaction = true;
+    } catch (SQLException &e) {
+
+        result.error.isError = true;
+        result.error.code = e.getErrorCode();
+        result.error.string = e.getSQLState() + ": " + e.what();
+    }
+
+    // Free memory
+    delete sqlStatement;
+
+    if (result.error.isError && isConnectionLost(result.error.code.toInt())) {
+
+        // The next query connects again
+        closeConnection();
+    }
+
+    return result;
+}
+
+/**
+ *
+ * Commits or rolls back the transaction started by beginTransaction(). If
+ * that fails the connection is closed, which makes the server roll back
+ * whatever is left of the transaction.
+ *
+ * @param commit True to commit it, false to roll it back
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::endTransaction(bool commit)
+{
+    QueryResult result;
+
+    if (connection == nullptr) {
+
+        // The transaction was rolled back when its connection was lost
+        if (commit) {
+            result.error.isError = true;
+            result.error.code = SERVER_LOST;
+            result.error.string = "The connection was lost and the "
+                                  "transaction rolled back";
+        }
+
+        return result;
+    }
+
+    try {
+
+        if (commit) {
+            connection->commit();
+        } else {
+            connection->rollback();
+        }
+
+        transaction = false;
+    } catch (SQLException &e) {
+
+        result.error.isError = true;
+        result.error.code = e.getErrorCode();
+        result.error.string = e.getSQLState() + ": " + e.what();
+
+        closeConnection();
+    }
+
+    return result;
+}
+
+/**
+ *
+ * Returns a prepared statement for sql, from the cache if it was prepared
+ * before on this connection. The least recently used statement is closed when
+ * the cache is full.
+ *
+ * @param sql The SQL to prepare
+ * @return PreparedStatement*
+ */
+PreparedStatement *DatabaseConnection::prepare(const std::string &sql)
+{
+    auto it = statementIndex.find(sql);
+
+    if (it != statementIndex.end()) {
+        statementHits++;
+        statements.splice(statements.begin(), statements, it->second);
+
+        PreparedStatement *statement = it->second->second;
+        statement->clearParameters();
+
+        return statement;
+    }
+
+    statementMisses++;
+    PreparedStatement *statement = connection->prepareStatement(sql);
+
+    if (statementCacheSize == 0) {
+        return statement;
+    }
+
+    statements.emplace_front(sql, statement);
+    statementIndex[sql] = statements.begin();
+
+    while (statements.size() > statementCacheSize) {
+        statementIndex.erase(statements.back().first);
+        delete statements.back().second;
+        statements.pop_back();
+    }
+
+    return statement;
+}
+
+/**
+ *
+ * Binds a parameter as the type of its value, so numbers reach the server as
+ * numbers and can be compared with numeric columns without conversion. Dates,
+ * decimals and strings are sent as text.
+ *
+ * @param sqlStatement The statement to bind to
+ * @param index The index of the parameter, from 1
+ * @param value The value to bind
+ * @param blobs Receives the streams blobs are read from. They must outlive the
+ * statement's execution.
+ * @return void
+ */
+void DatabaseConnection::bind(PreparedStatement *sqlStatement,
+                              unsigned int index, const Variant &value,
+                              std::vector<std::unique_ptr<std::istream>> &blobs)
+{
+    size_t length;
+    const unsigned char *data;
+
+    switch (value.getType()) {
+    case D_NULL:
+        sqlStatement->setNull(index, ::DataType::SQLNULL);
+        break;
+    case D_BOOLEAN:
+        sqlStatement->setBoolean(index, value.toBool());
+        break;
+    case D_SHORT:
+    case D_USHORT:
+    case D_INT:
+        sqlStatement->setInt(index, value.toInt());
+        break;
+    case D_UINT:
+        sqlStatement->setUInt(index, value.toUInt());
+        break;
+    case D_LONG:
+    case D_LONGLONG:
+        sqlStatement->setInt64(index, value.toLongLong());
+        break;
+    case D_ULONG:
+    case D_ULONGLONG:
+        sqlStatement->setUInt64(index, value.toULongLong());
+        break;
+    case D_FLOAT:
+    case D_DOUBLE:
+        sqlStatement->setDouble(index, value.toDouble());
+        break;
+    case D_BLOB:
+        data = value.asBlob(&length);
+        blobs.emplace_back(new std::istringstream(std::string(
+            reinterpret_cast<const char *>(data), length)));
+        sqlStatement->setBlob(index, blobs.back().get());
+        break;
+    default:
+        sqlStatement->setString(index, value.toString());
+        break;
+    }
+}
+
+/**
+ *
+ * Hands back a statement from prepare() once its result has been read.
+ * Statements that aren't cached are freed, as are cached ones that failed.
+ *
+ * @param sql The SQL the statement was prepared from
+ * @param statement The statement
+ * @param failed True if the statement failed
+ * @return void
+ */
+void DatabaseConnection::release(const std::string &sql,
+                                 PreparedStatement *statement, bool failed)
+{
+    auto it = statementIndex.find(sql);
+
+    if (it != statementIndex.end() && it->second->second == statement) {
+
+        if (!failed) {
+            return;
+        }
+
+        statements.erase(it->second);
+        statementIndex.erase(it);
+    }
+
+    delete statement;
+}
+
+/**
+ *
+ * Frees every cached statement
+ *
+ * @return void
+ */
+void DatabaseConnection::clearStatements()
+{
+    for (auto &statement : statements) {
+        delete statement.second;
+    }
+
+    statements.clear();
+    statementIndex.clear();
+}
+
+/**
+ *
+ * Picks how cells of a column are read
+ *
+ * @param sqlType The column's type, as reported by the connector
+ * @param isSigned True if the column is signed
+ * @param type Receives the type the cells are stored as
+ * @return CellReader
+ */
+DatabaseConnection::CellReader DatabaseConnection::readerFor(int sqlType,
+                                                             bool isSigned,
+                                                             DataType &type)
+{
+    switch (sqlType) {
+    default:
+    case ::DataType::UNKNOWN:
+    case ::DataType::CHAR:
+    case ::DataType::VARCHAR:
+    case ::DataType::LONGVARCHAR:
+    case ::DataType::GEOMETRY:
+    case ::DataType::ENUM:
+    case ::DataType::SET:
+        // @TODO: store geometry differently
+        type = D_STRING;
+        return readString;
+    case ::DataType::BINARY:
+    case ::DataType::VARBINARY:
+    case ::DataType::LONGVARBINARY:
+        type = D_BLOB;
+        return readBlob;
+    case ::DataType::TIMESTAMP:
+    case ::DataType::DATE:
+        type = D_DATETIME;
+        return readDate;
+    case ::DataType::DECIMAL:
+    case ::DataType::NUMERIC:
+        type = D_DECIMAL;
+        return readDecimal;
+    case ::DataType::BIGINT:
+        if (isSigned) {
+            type = D_LONGLONG;
+            return readLongLong;
+        }
+        type = D_ULONGLONG;
+        return readULongLong;
+    case ::DataType::REAL:
+
+        // FLOAT columns. Kept single precision, so 0.1 still reads as 0.1.
+        type = D_FLOAT;
+        return readFloat;
+    case ::DataType::DOUBLE:
+        type = D_DOUBLE;
+        return readDouble;
+    case ::DataType::SQLNULL:
+        type = D_NULL;
+        return readNull;
+    case ::DataType::BIT:
+
+        // Up to 64 bits
+        type = D_ULONGLONG;
+        return readULongLong;
+    case ::DataType::INTEGER:
+        if (!isSigned) {
+            type = D_UINT;
+            return readUInt;
+        }
+        type = D_INT;
+        return readInt;
+    case ::DataType::TINYINT:
+    case ::DataType::SMALLINT:
+    case ::DataType::MEDIUMINT:
+
+        // Signed or not, these fit an int
+        type = D_INT;
+        return readInt;
+    case ::DataType::YEAR:
+        type = D_USHORT;
+        return readYear;
+    }
+}
+
+/**
+ *
+ * Reads a text cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readString(ResultSet *sqlResult, unsigned int index,
+                                    ResultColumn &column)
+{
+    SQLString text = sqlResult->getString(index);
+    auto &data = text.asStdString();
+    column.appendString(data.data(), data.size());
+}
+
+/**
+ *
+ * Reads a binary cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readBlob(ResultSet *sqlResult, unsigned int index,
+                                  ResultColumn &column)
+{
+    SQLString text = sqlResult->getString(index);
+    auto &data = text.asStdString();
+    column.appendBlob(reinterpret_cast<const unsigned char *>(data.data()),
+                      data.size());
+}
+
+/**
+ *
+ * Reads a date or timestamp cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readDate(ResultSet *sqlResult, unsigned int index,
+                                  ResultColumn &column)
+{
+    SQLString text = sqlResult->getString(index);
+    auto &data = text.asStdString();
+    DateTime date;
+
+    if (DateTime::parse(data.data(), data.size(), date)) {
+        column.append(date);
+    } else {
+
+        // Not a date we can represent. Keep the text.
+        column.appendString(data.data(), data.size());
+    }
+}
+
+/**
+ *
+ * Reads a decimal cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readDecimal(ResultSet *sqlResult, unsigned int index,
+                                     ResultColumn &column)
+{
+    SQLString text = sqlResult->getString(index);
+    auto &data = text.asStdString();
+    Decimal decimal;
+
+    if (Decimal::parse(data.data(), data.size(), decimal)) {
+        column.append(decimal);
+    } else {
+
+        // Too many digits for a Decimal. Keep the text.
+        column.appendString(data.data(), data.size());
+    }
+}
+
+/**
+ *
+ * Reads a signed BIGINT cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readLongLong(ResultSet *sqlResult, unsigned int index,
+                                      ResultColumn &column)
+{
+    column.append(static_cast<long long>(sqlResult->getInt64(index)));
+}
+
+/**
+ *
+ * Reads an unsigned BIGINT cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readULongLong(ResultSet *sqlResult,
+                                       unsigned int index,
+                                       ResultColumn &column)
+{
+    column.append(static_cast<unsigned long long>(
+        sqlResult->getUInt64(index)));
+}
+
+/**
+ *
+ * Reads a floating point cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readDouble(ResultSet *sqlResult, unsigned int index,
+                                    ResultColumn &column)
+{
+    column.append(static_cast<double>(sqlResult->getDouble(index)));
+}
+
+/**
+ *
+ * Reads a single precision floating point cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readFloat(ResultSet *sqlResult, unsigned int index,
+                                   ResultColumn &column)
+{
+    column.append(static_cast<float>(sqlResult->getDouble(index)));
+}
+
+/**
+ *
+ * Reads a cell of a column that only holds NULL
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readNull(ResultSet *, unsigned int,
+                                  ResultColumn &column)
+{
+    column.appendNull();
+}
+
+/**
+ *
+ * Reads an integer cell of up to 32 bits
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readInt(ResultSet *sqlResult, unsigned int index,
+                                 ResultColumn &column)
+{
+    column.append(sqlResult->getInt(index));
+}
+
+/**
+ *
+ * Reads an unsigned INT cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readUInt(ResultSet *sqlResult, unsigned int index,
+                                  ResultColumn &column)
+{
+    column.append(static_cast<unsigned int>(sqlResult->getUInt(index)));
+}
+
+/**
+ *
+ * Reads a YEAR cell
+ *
+ * @param sqlResult The result to read from
+ * @param index The index of the column, from 1
+ * @param column The column to append to
+ * @return void
+ */
+void DatabaseConnection::readYear(ResultSet *sqlResult, unsigned int index,
+                                  ResultColumn &column)
+{
+    column.append(static_cast<unsigned short>(sqlResult->getUInt(index)));
+}
+
+/**
+ *
+ * Disconnects from the database
+ *
+ * @return void
+ */
+void DatabaseConnection::disconnect()
+{
+    closeConnection();
+
+    if (driver != nullptr) {
+
+        // End the thread in the MySQL driver's internals
+        driver->threadEnd();
+
+        driver = nullptr;
+    }
+}
+
+/**
+ *
+ * Returns how many queries used a statement prepared before on this
+ * connection
+ *
+ * @return unsigned long long
+ */
+unsigned long long DatabaseConnection::getStatementCacheHits() const
+{
+    return statementHits;
+}
+
+/**
+ *
+ * Returns how many queries had to prepare their statement
+ *
+ * @return unsigned long long
+ */
+unsigned long long DatabaseConnection::getStatementCacheMisses() const
+{
+    return statementMisses;
 }
 
 /**
@@ -395,6 +1507,22 @@ std::vector<SettingsField> DatabaseConnection::getSettingsFields()
     fields.push_back(SettingsField("password", "Password", "Password", 2));
     fields.push_back(SettingsField("save_password", "Save Password", "Save Password", 2, D_BOOLEAN));
     fields.push_back(SettingsField("database", "Database(s)", "Database(s)", 4));
+    fields.push_back(SettingsField("unbuffered", "Unbuffered Results",
+        "Read results of queries without parameters from the server as they "
+        "are fetched", 5, D_BOOLEAN));
+    fields.push_back(SettingsField("multi_statements", "Multi-Statement Batches",
+        "Send batch statements without parameters to the server together",
+        5, D_BOOLEAN));
+    fields.push_back(SettingsField("result_memory_limit",
+        "Result Memory Limit (MB)",
+        "Larger results are kept in a temporary file. 0 for no limit.", 5,
+        D_UINT));
+    fields.push_back(SettingsField("statement_cache_size",
+        "Statement Cache Size",
+        "Prepared statements to keep per connection. 0 to prepare every "
+        "query.", 5, D_UINT, VariantVector()
+        << static_cast<unsigned int>(DEFAULT_STATEMENT_CACHE_SIZE) << 0
+        << 4096));
 
     return fields;
 }
@@ -5,6 +5,9 @@
 
 namespace RabidSQL {
 
+class ResultColumn;
+struct QueryResult;
+
 class BinaryFileStream : virtual public FileStream {
 public:
     bool open(std::string filename, unsigned int mode);
@@ -16,6 +19,11 @@ public:
     FileStream &operator>>(Variant &value);
 private:
     std::string readString();
+    void writeString(const std::string &string);
+    void writeResult(const QueryResult &result);
+    bool readResult(QueryResult &result);
+    void writeColumn(const ResultColumn &column);
+    bool readColumn(ResultColumn &column);
 };
 
 }
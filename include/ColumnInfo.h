@@ -0,0 +1,30 @@
+#ifndef RABIDSQL_COLUMNINFO_H
+#define RABIDSQL_COLUMNINFO_H
+
+#include "NSEnums.h"
+
+#include <string>
+
+namespace RabidSQL {
+
+// Describes one column of a query result, as reported by the server
+struct ColumnInfo {
+    std::string name = "";
+    std::string table = "";
+    std::string database = "";
+
+    // The type as the server names it, e.g. "VARCHAR"
+    std::string sqlType = "";
+
+    // The type cells of this column are stored as
+    DataType type = D_NULL;
+
+    bool nullable = true;
+    unsigned int length = 0;
+    unsigned int decimals = 0;
+    std::string charset = "";
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_COLUMNINFO_H
@@ -0,0 +1,46 @@
+#ifndef RABIDSQL_COLUMNSTATS_H
+#define RABIDSQL_COLUMNSTATS_H
+
+#include "Variant.h"
+
+#include <vector>
+
+namespace RabidSQL {
+
+class ResultColumn;
+
+// Summary statistics of one column of a result: how many cells and nulls it
+// has, its least and greatest values and an estimate of how many distinct
+// values it holds. The estimate is a HyperLogLog sketch, within about 2% of
+// the true count. Statistics of separate parts of a column can be merged.
+class ColumnStats {
+public:
+    // The sketch uses 2^PRECISION one-byte registers
+    static const int PRECISION = 12;
+
+    ColumnStats();
+    void add(const ResultColumn &column);
+    void merge(const ColumnStats &stats);
+    size_t count() const;
+    size_t nullCount() const;
+    Variant minimum() const;
+    Variant maximum() const;
+    size_t distinctCount() const;
+    size_t memoryUsage() const;
+
+private:
+    void addRange(const Variant &least, const Variant &greatest,
+                  DataType type);
+    void addHash(unsigned long long hash);
+
+    size_t cells;
+    size_t nulls;
+    Variant least;
+    Variant greatest;
+    bool ordered;
+    std::vector<unsigned char> registers;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_COLUMNSTATS_H
@@ -2,7 +2,6 @@
 #define RABIDSQL_CONNECTIONSETTINGS_H
 
 #include <string>
-#include <map>
 
 #include "ArbitraryPointer.h"
 #include "NSEnums.h"
@@ -41,7 +40,7 @@ private:
     static void reparentChildren(
             std::vector<ConnectionSettings *> &connectionList,
             ConnectionSettings *currentSettings);
-    typedef std::map<std::string, Variant> Settings;
+    typedef VariantMap Settings;
     Settings settings;
 };
 
@@ -1,6 +1,7 @@
 #ifndef RABIDSQL_DATABASECONNECTIONMANAGER_H
 #define RABIDSQL_DATABASECONNECTIONMANAGER_H
 
+#include "ResultCache.h"
 #include "Variant.h"
 
 #include <map>
@@ -24,6 +25,8 @@ public:
     void call(std::string uuid, Variant uid, QueryEvent event,
         VariantVector arguments = VariantVector(), bool blocking = false);
     void killQuery(std::string uuid);
+    void setResultCache(size_t memoryLimit, unsigned int ttl);
+    void clearResultCache();
     ConnectionType getType();
     virtual ~DatabaseConnectionManager();
 
@@ -52,6 +55,7 @@ private:
     Connections connections;
     DisconnectingConnections disconnectingConnections;
     unsigned int maxConnections;
+    ResultCache resultCache;
 };
 
 } // namespace RabidSQL
@@ -0,0 +1,40 @@
+#ifndef RABIDSQL_DATETIME_H
+#define RABIDSQL_DATETIME_H
+
+#include <cstddef>
+
+namespace RabidSQL {
+
+// A calendar date and time of day with microsecond precision, as stored by
+// DATE, DATETIME and TIMESTAMP columns. Variants store it packed into a single
+// 64 bit integer whose ordering matches chronological ordering.
+struct DateTime {
+    enum Constants {
+        // Large enough for "YYYY-MM-DD hh:mm:ss.ffffff"
+        BUFFER_SIZE = 32
+    };
+
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int microsecond = 0;
+
+    // False for plain dates. Only affects formatting.
+    bool hasTime = true;
+
+    long long pack() const;
+    static DateTime unpack(long long packed);
+    static bool parse(const char *string, size_t length, DateTime &value);
+    size_t format(char *buffer) const;
+    long long toNumber() const;
+    bool operator==(const DateTime &value) const;
+    bool operator<(const DateTime &value) const;
+    bool operator>(const DateTime &value) const;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_DATETIME_H
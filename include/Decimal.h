@@ -0,0 +1,31 @@
+#ifndef RABIDSQL_DECIMAL_H
+#define RABIDSQL_DECIMAL_H
+
+#include <cstddef>
+
+namespace RabidSQL {
+
+// A fixed-point number: value / 10^scale. Holds DECIMAL columns of up to 18
+// digits exactly. It has no constructor so that variants can store it inline;
+// use Decimal() for zero.
+struct Decimal {
+    enum Constants {
+        MAX_DIGITS = 18,
+
+        // Large enough for 18 digits, a sign, a point and a leading zero
+        BUFFER_SIZE = 32
+    };
+
+    long long value;
+    int scale;
+
+    static bool parse(const char *string, size_t length, Decimal &value);
+    size_t format(char *buffer) const;
+    double toDouble() const;
+    long long truncate() const;
+    int compare(const Decimal &value) const;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_DECIMAL_H
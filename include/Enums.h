@@ -18,6 +18,8 @@ typedef enum {
     DISCONNECT,
     CLEAN_STATE,
     SELECT_DATABASE,
+    STREAM_QUERY,
+    EXECUTE_BATCH,
 } QueryEvent;
 
 typedef enum {
@@ -44,8 +46,12 @@ typedef enum {
     D_DOUBLE = 150,
     D_BOOLEAN = 160,
     D_POINTER = 170,
+    D_DATETIME = 180,
+    D_DECIMAL = 190,
+    D_BLOB = 200,
+    D_VARIANTHASHMAP = 210,
     _FIRST = D_NULL,
-    _LAST = D_BOOLEAN,
+    _LAST = D_VARIANTHASHMAP,
 } DataType;
 
 typedef enum {
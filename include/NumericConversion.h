@@ -0,0 +1,38 @@
+#ifndef RABIDSQL_NUMERICCONVERSION_H
+#define RABIDSQL_NUMERICCONVERSION_H
+
+#include <cstddef>
+
+namespace RabidSQL {
+
+// Locale independent number <-> text conversion that works on caller provided
+// buffers and never allocates. Output matches what std::ostream produces with
+// its default flags, and parsing follows std::istream's rules (leading spaces,
+// optional sign, stop at the first character that doesn't fit).
+class NumericConversion {
+public:
+    enum Constants {
+        // Large enough for any integer or double formatted by this class
+        BUFFER_SIZE = 32
+    };
+
+    static size_t formatInteger(char *buffer, long long value);
+    static size_t formatUnsigned(char *buffer, unsigned long long value);
+    static size_t formatDouble(char *buffer, double value);
+
+    static bool parseInteger(const char *string, size_t length,
+                             long long &value);
+    static bool parseUnsigned(const char *string, size_t length,
+                              unsigned long long &value);
+    static bool parseDouble(const char *string, size_t length, double &value,
+                            size_t *end = nullptr);
+
+private:
+    static size_t skipSpace(const char *string, size_t length);
+    static bool readDigits(const char *string, size_t length,
+                           size_t &position, unsigned long long &value);
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_NUMERICCONVERSION_H
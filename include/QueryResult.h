@@ -1,10 +1,14 @@
 #ifndef RABIDSQL_QUERYRESULT_H
 #define RABIDSQL_QUERYRESULT_H
 
-#include <list>
+#include <string>
+#include <vector>
+#include "ColumnInfo.h"
+#include "ColumnStats.h"
 #include "NSEnums.h"
 #include "Variant.h"
 #include "QueryError.h"
+#include "ResultRows.h"
 
 namespace RabidSQL {
 
@@ -13,10 +17,12 @@ struct QueryResult {
     bool is_valid = false;
     int affected_rows = 0;
     int num_rows = 0;
-    QueryEvent event;
+    QueryEvent event = NO_EVENT;
     QueryError error = QueryError();
-    std::list<std::string> columns = std::list<std::string>();
-    std::list<VariantVector> rows = std::list<VariantVector>();
+    std::vector<std::string> columns = std::vector<std::string>();
+    std::vector<ColumnInfo> columnInfo = std::vector<ColumnInfo>();
+    ResultRows rows = ResultRows();
+    std::vector<ColumnStats> columnStats = std::vector<ColumnStats>();
 };
 
 } // namespace RabidSQL
@@ -0,0 +1,94 @@
+#ifndef RABIDSQL_RESULTCACHE_H
+#define RABIDSQL_RESULTCACHE_H
+
+#include "QueryResult.h"
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RabidSQL {
+
+// Results of read-only commands, kept by a connection manager so repeated
+// queries can be answered without a round trip. Entries are keyed by the
+// command, the whitespace-normalized SQL, the bound parameters and the current
+// database. Each entry expires after its TTL, and the least recently used
+// entries are evicted to stay within the memory limit. A write through the
+// same manager drops the entries of the tables it touches; schema changes
+// also drop database, table and column listings, and writes the cache can't
+// attribute to tables drop everything. Only the tables a statement names are
+// known: writes through views, triggers or foreign key cascades, and writes by
+// other clients, aren't seen, and the results they change stay until their
+// TTL expires. The cache is disabled until a memory limit is set, and is safe
+// to use from any thread.
+class ResultCache {
+public:
+    enum StatementType {
+        READ,
+        SESSION,
+        WRITE,
+        SCHEMA,
+        OTHER
+    };
+
+    struct Statement {
+        StatementType type = OTHER;
+        bool cacheable = false;
+        bool metadata = false;
+        std::vector<std::string> tables;
+        std::string database;
+    };
+
+    ResultCache();
+    void setLimits(size_t memoryLimit, unsigned int ttl);
+    bool isEnabled() const;
+    std::string makeKey(QueryEvent event, const VariantVector &arguments,
+                        const std::string &database) const;
+    unsigned long long generation() const;
+    bool find(const std::string &key, QueryResult &result);
+    void insert(const std::string &key, QueryEvent event,
+                const VariantVector &arguments, const QueryResult &result,
+                unsigned long long generation);
+    void invalidate(const std::string &sql);
+    void clear();
+    size_t size() const;
+    size_t memoryUsage() const;
+
+    static std::string normalize(const std::string &sql);
+    static Statement parse(const std::string &sql);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::string key;
+        QueryResult result;
+        std::vector<std::string> tables;
+        bool metadata;
+        size_t bytes;
+        Clock::time_point expiry;
+    };
+
+    typedef std::list<Entry> Entries;
+
+    ResultCache(const ResultCache &) = delete;
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    void erase(Entries::iterator entry);
+
+    // Most recently used first
+    Entries entries;
+    std::unordered_map<std::string, Entries::iterator> index;
+    size_t memoryLimit;
+    size_t usedBytes;
+    unsigned int ttl;
+    unsigned long long invalidations;
+    mutable std::mutex mutex;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_RESULTCACHE_H
@@ -0,0 +1,110 @@
+#ifndef RABIDSQL_RESULTCOLUMN_H
+#define RABIDSQL_RESULTCOLUMN_H
+
+#include "NSEnums.h"
+#include "Variant.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RabidSQL {
+
+class BinaryFileStream;
+class ResultSpillFile;
+
+// One column of a query result, stored contiguously. Integers (including
+// booleans and dates) and floating point numbers are kept in typed arrays and
+// strings and blobs in a single byte buffer indexed by offsets. Nulls are
+// tracked in a bitmap. A column whose cells don't all share one type falls
+// back to storing variants.
+//
+// String columns start out dictionary-encoded: each distinct value is stored
+// once and rows hold its code. Once more than half the values are distinct the
+// column switches to storing every value.
+//
+// The typed arrays of a finished column can be spilled to a ResultSpillFile
+// and read back from a mapping of it. Appending to a spilled column loads it
+// back into memory first.
+class ResultColumn {
+    friend class BinaryFileStream;
+public:
+    ResultColumn();
+    void append(const Variant &value);
+    void appendNull();
+    void appendString(const char *value, size_t length);
+    void appendBlob(const unsigned char *value, size_t length);
+    Variant at(size_t row) const;
+    bool isNull(size_t row) const;
+    size_t size() const;
+    DataType getType() const;
+    const long long *integers() const;
+    const double *doubles() const;
+    const char *asString(size_t row, size_t *length = nullptr) const;
+    const unsigned int *codes() const;
+    size_t dictionarySize() const;
+    const char *dictionaryValue(size_t code, size_t *length = nullptr) const;
+    void reserve(size_t rows);
+    void finish();
+    size_t memoryUsage() const;
+    size_t dictionarySavings() const;
+    bool spill(ResultSpillFile &file) const;
+    size_t useMapping(const std::shared_ptr<const char> &mapping,
+                      const char *data);
+    bool isSpilled() const;
+
+private:
+    enum Storage {
+        S_NONE,
+        S_INTEGER,
+        S_DOUBLE,
+        S_STRING,
+        S_VARIANT,
+        S_DICTIONARY
+    };
+
+    static Storage storageFor(DataType type);
+    void prepare(DataType type);
+    void appendBytes(DataType type, const char *value, size_t length);
+    unsigned int encode(const char *value, size_t length);
+    void indexCode(unsigned int code, size_t hash);
+    void rebuildIndex();
+    void convertToStrings();
+    void markRow(bool null);
+    long long toInteger(const Variant &value) const;
+    Variant fromInteger(long long value) const;
+    void convertToVariants();
+    void unmap();
+    const unsigned long long *nullWords() const;
+    const long long *integerData() const;
+    const double *doubleData() const;
+    const size_t *offsetData() const;
+    const char *byteData() const;
+    const unsigned int *codeData() const;
+
+    Storage storage;
+    DataType type;
+    size_t count;
+    size_t reservedRows;
+    std::vector<unsigned long long> nulls;
+    std::vector<long long> integerValues;
+    std::vector<double> doubleValues;
+    std::vector<size_t> offsets;
+    std::vector<char> bytes;
+    std::vector<Variant> variantValues;
+    std::vector<unsigned int> codeValues;
+    std::vector<unsigned int> dictionaryIndex;
+    size_t entries;
+    size_t plainBytes;
+    std::shared_ptr<const char> mapping;
+    const unsigned long long *mappedNulls;
+    const long long *mappedIntegers;
+    const double *mappedDoubles;
+    const size_t *mappedOffsets;
+    const char *mappedBytes;
+    const unsigned int *mappedCodes;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_RESULTCOLUMN_H
@@ -0,0 +1,113 @@
+#ifndef RABIDSQL_RESULTROWS_H
+#define RABIDSQL_RESULTROWS_H
+
+#include "ColumnStats.h"
+#include "ResultColumn.h"
+#include "Variant.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace RabidSQL {
+
+class BinaryFileStream;
+class ResultSpillFile;
+
+// The rows of a query result. Rows are kept in blocks of BLOCK_ROWS, and within
+// a block cells are stored column by column (see ResultColumn). Rows are
+// assembled into VariantVectors when they are read, so callers that work a row
+// at a time keep working; scans over a single column should go through
+// column(block, index) instead.
+//
+// Finding a row is a division, and appending never moves the data of a block
+// that is already full, so pointers from its columns (integers(), asString()
+// and so on) stay valid while the rest of the result is read. When the row
+// count is reserved up front the typed arrays of the block being filled don't
+// move either.
+//
+// With a memory limit set, blocks filled once the limit is reached are
+// spilled to a temporary file and read back through mmap(), so a result far
+// larger than memory can still be held. Spilled blocks are read exactly like
+// the others.
+//
+// Statistics of each column (see ColumnStats) are gathered as blocks fill,
+// while their cells are still in cache.
+class ResultRows {
+    friend class BinaryFileStream;
+public:
+    static const size_t BLOCK_ROWS = 16384;
+
+    ResultRows();
+    ResultRows(const ResultRows &value);
+    ResultRows(ResultRows &&value);
+    ResultRows &operator=(const ResultRows &value);
+    ResultRows &operator=(ResultRows &&value);
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef VariantVector value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const VariantVector *pointer;
+        typedef VariantVector reference;
+
+        const_iterator(const ResultRows *rows, size_t row);
+        VariantVector operator*() const;
+        const_iterator &operator++();
+        const_iterator operator++(int);
+        bool operator==(const const_iterator &value) const;
+        bool operator!=(const const_iterator &value) const;
+
+    private:
+        const ResultRows *rows;
+        size_t row;
+    };
+
+    size_t size() const;
+    bool empty() const;
+    VariantVector at(size_t row) const;
+    Variant at(size_t row, size_t column) const;
+    VariantVector operator[](size_t row) const;
+    VariantVector front() const;
+    VariantVector back() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    void push_back(const VariantVector &row);
+    void addRow();
+    ResultColumn &appendTo(size_t column);
+    size_t columnCount() const;
+    void setColumnCount(size_t count);
+    size_t blockCount() const;
+    const ResultColumn &column(size_t block, size_t index) const;
+    void reserve(size_t rows);
+    void clear();
+    size_t memoryUsage() const;
+    size_t dictionarySavings() const;
+    std::vector<ColumnStats> statistics() const;
+    void setMemoryLimit(size_t bytes);
+    size_t getMemoryLimit() const;
+
+private:
+    typedef std::vector<ResultColumn> Block;
+
+    size_t blockRows(size_t block) const;
+    void reserveBlock(size_t block);
+    void sealBlock(size_t block);
+    bool spillBlock(size_t block);
+
+    std::vector<Block> blocks;
+    size_t columns = 0;
+    size_t rows = 0;
+    size_t reservedRows = 0;
+    size_t memoryLimit = 0;
+    size_t residentBytes = 0;
+    std::shared_ptr<ResultSpillFile> spillFile;
+    std::vector<ColumnStats> blockStats;
+    size_t statsBlocks = 0;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_RESULTROWS_H
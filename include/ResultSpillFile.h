@@ -0,0 +1,36 @@
+#ifndef RABIDSQL_RESULTSPILLFILE_H
+#define RABIDSQL_RESULTSPILLFILE_H
+
+#include <cstddef>
+#include <memory>
+
+namespace RabidSQL {
+
+// An anonymous temporary file that result blocks are written to once a result
+// outgrows its memory limit. The file is unlinked as soon as it is created, so
+// it disappears with the process. Written regions are read back through
+// mmap(); a mapping stays valid for as long as a reference to it is held, even
+// after the file itself is closed.
+class ResultSpillFile {
+public:
+    ResultSpillFile();
+    ~ResultSpillFile();
+    bool isOpen() const;
+    size_t size() const;
+    bool write(const void *data, size_t length);
+    bool align(size_t alignment);
+    std::shared_ptr<const char> map(size_t offset, size_t length);
+
+    static size_t pageSize();
+
+private:
+    ResultSpillFile(const ResultSpillFile &) = delete;
+    ResultSpillFile &operator=(const ResultSpillFile &) = delete;
+
+    int descriptor;
+    size_t length;
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_RESULTSPILLFILE_H
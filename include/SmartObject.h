@@ -36,6 +36,7 @@ public:
 
 protected:
     void queueData(int id, const VariantVector &arguments);
+    void queueData(int id, VariantVector &&arguments);
     virtual void processQueueItem(const int id, const VariantVector &arguments);
 
 private:
@@ -45,6 +46,7 @@ private:
     class Data {
     public:
         Data(int id, const VariantVector &arguments);
+        Data(int id, VariantVector &&arguments);
         int id;
         VariantVector arguments;
     };
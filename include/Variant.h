@@ -1,10 +1,16 @@
 #ifndef RABIDSQL_VARIANT_H
 #define RABIDSQL_VARIANT_H
 
+#include "DateTime.h"
+#include "Decimal.h"
 #include "NSEnums.h"
 
+#include <initializer_list>
 #include <map>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace RabidSQL {
@@ -15,6 +21,7 @@ class BinaryFileStream;
 class JsonFileStream;
 class VariantVector;
 class VariantMap;
+class VariantHashMap;
 class Variant
 {
     friend class FileStream;
@@ -24,12 +31,19 @@ public:
     Variant();
     Variant(const std::nullptr_t &value);
     Variant(const Variant &value);
+    Variant(Variant &&value);
     Variant(const std::string &value);
     Variant(const char *value);
+    Variant(const char *value, size_t length);
     Variant(ArbitraryPointer *value, bool manage);
     Variant(const std::vector<std::string> &value);
+    Variant(std::vector<std::string> &&value);
     Variant(const VariantVector &value);
+    Variant(VariantVector &&value);
     Variant(const VariantMap &value);
+    Variant(VariantMap &&value);
+    Variant(const VariantHashMap &value);
+    Variant(VariantHashMap &&value);
     Variant(const long &value);
     Variant(const long long &value);
     Variant(const unsigned long &value);
@@ -41,13 +55,18 @@ public:
     Variant(const bool &value);
     Variant(const double &value);
     Variant(const float &value);
+    Variant(const DateTime &value);
+    Variant(const Decimal &value);
+    Variant(const unsigned char *value, size_t length);
     Variant(const QueryResult &value);
+    Variant(QueryResult &&value);
     ~Variant();
     ArbitraryPointer *toPointer() const;
     const std::string toString() const;
     const std::vector<std::string> toStringVector() const;
     const VariantVector toVariantVector() const;
     const VariantMap toVariantMap() const;
+    const VariantHashMap toVariantHashMap() const;
     const long toLong() const;
     const long long toLongLong() const;
     const unsigned long toULong() const;
@@ -59,9 +78,24 @@ public:
     const bool toBool() const;
     const float toFloat() const;
     const double toDouble() const;
+    const DateTime toDateTime() const;
+    const Decimal toDecimal() const;
+    const std::vector<unsigned char> toBlob() const;
     const bool isNull() const;
     const QueryResult toQueryResult() const;
+    const char *asString(size_t *length = nullptr) const;
+    const unsigned char *asBlob(size_t *length = nullptr) const;
+    const std::vector<std::string> *asStringVector() const;
+    const VariantVector *asVariantVector() const;
+    const VariantMap *asVariantMap() const;
+    const VariantHashMap *asVariantHashMap() const;
+    const QueryResult *asQueryResult() const;
+    size_t size() const;
+    Variant at(size_t index) const;
+    size_t hash() const;
+    int compare(const Variant &value) const;
     void operator=(const Variant &value);
+    void operator=(Variant &&value);
     bool operator!=(const Variant &value) const;
     bool operator==(const Variant &value) const;
     bool operator>(const Variant &value) const;
@@ -71,24 +105,209 @@ public:
     const DataType getType() const;
 
 private:
+    enum Constants {
+        // Strings and blobs shorter than this (including the null terminator)
+        // are stored inline rather than on the heap
+        SMALL_STRING_SIZE = 16
+    };
+
+    // Reference counted heap payloads for long strings and containers. Copies
+    // share the payload; it is freed when the last variant releases it.
+    struct Payload;
+    template<typename T>
+    struct SharedPayload;
+    struct StringPayload;
+
+    // Three-way comparison between every pair of types
+    struct Comparison;
+
+    // Scalars and short strings live inside the variant itself. Everything
+    // else is allocated on the heap and referenced through pointer. Dates are
+    // kept packed in longLongValue.
+    union Data {
+        void *pointer;
+        bool boolean;
+        short shortValue;
+        unsigned short ushortValue;
+        int intValue;
+        unsigned int uintValue;
+        long longValue;
+        unsigned long ulongValue;
+        long long longLongValue;
+        unsigned long long ulongLongValue;
+        float floatValue;
+        double doubleValue;
+        Decimal decimalValue;
+        char string[SMALL_STRING_SIZE];
+    };
+
     template<typename T>
     T numericCast() const;
+    template<typename T>
+    static T parseNumber(const char *string, size_t length);
     void init(DataType type);
+    void copy(const Variant &value);
     void deinit();
+    void setString(const char *value, size_t length);
+    bool isSmallString() const;
+    const char *bytes(size_t *length) const;
+    int compareString(const Variant &value) const;
+    static size_t hashInteger(long long value);
+    static size_t hashNumber(double value);
+    static size_t hashString(const char *string, size_t length);
+    static size_t combineHash(size_t hash, size_t value);
+    template<typename T>
+    const T &sharedValue() const;
+    void release();
 
-    void *data;
-    bool deleteData;
+    Data data;
     DataType type;
+    bool deleteData;
+    unsigned char smallStringSize;
 };
 
 class VariantVector : public std::vector<Variant> {
 
 public:
-    VariantVector &operator<<(const Variant &value);
+    VariantVector &operator<<(const Variant &value) &;
+    VariantVector &operator<<(Variant &&value) &;
+    VariantVector &&operator<<(const Variant &value) &&;
+    VariantVector &&operator<<(Variant &&value) &&;
+    template<typename... Args>
+    VariantVector &append(Args&&... args);
     const Variant toVariant();
 };
 
-class VariantMap : public std::map<std::string, Variant> {
+/**
+ *
+ * Constructs a variant in place at the end of the list from the provided
+ * arguments
+ *
+ * @param args The arguments to construct the variant from
+ * @return The list
+ */
+template<typename... Args>
+VariantVector &VariantVector::append(Args&&... args)
+{
+    emplace_back(std::forward<Args>(args)...);
+
+    return *this;
+}
+
+// An ordered string-keyed map stored as a sorted vector. Most maps are small
+// (settings records, JSON objects), where one contiguous allocation beats a
+// node per key. The interface and iteration order match std::map, but
+// inserting or erasing invalidates iterators and references.
+class VariantMap {
+
+public:
+    typedef std::string key_type;
+    typedef Variant mapped_type;
+    typedef std::pair<std::string, Variant> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef std::vector<value_type>::size_type size_type;
+
+    VariantMap();
+    VariantMap(std::initializer_list<value_type> values);
+    Variant &operator[](const std::string &key);
+    Variant &operator[](std::string &&key);
+    Variant &at(const std::string &key);
+    const Variant &at(const std::string &key) const;
+    iterator find(const std::string &key);
+    const_iterator find(const std::string &key) const;
+    size_type count(const std::string &key) const;
+    std::pair<iterator, bool> insert(const value_type &value);
+    std::pair<iterator, bool> insert(value_type &&value);
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(const std::string &key,
+                                      Args&&... args);
+    iterator erase(const_iterator position);
+    size_type erase(const std::string &key);
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    size_type size() const;
+    bool empty() const;
+    void clear();
+    void reserve(size_type count);
+    bool operator==(const VariantMap &value) const;
+    bool operator!=(const VariantMap &value) const;
+    bool operator<(const VariantMap &value) const;
+    bool operator>(const VariantMap &value) const;
+
+private:
+    enum Constants {
+        // Up to this size find() scans rather than bisects
+        LINEAR_SEARCH_LIMIT = 16
+    };
+
+    iterator lowerBound(const std::string &key);
+    const_iterator lowerBound(const std::string &key) const;
+
+    std::vector<value_type> elements;
+};
+
+/**
+ *
+ * Inserts a value constructed from args under key, unless key is already
+ * present
+ *
+ * @param key The key to insert under
+ * @param args The arguments to construct the value from
+ * @return The element for key and whether it was inserted
+ */
+template<typename... Args>
+std::pair<VariantMap::iterator, bool> VariantMap::emplace(
+        const std::string &key, Args&&... args)
+{
+    auto it = lowerBound(key);
+
+    if (it != elements.end() && it->first == key) {
+
+        // Already present
+        return std::make_pair(it, false);
+    }
+
+    it = elements.emplace(it, std::piecewise_construct,
+                          std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+
+    return std::make_pair(it, true);
+}
+
+} // namespace RabidSQL
+
+namespace std {
+
+template<>
+struct hash<RabidSQL::Variant> {
+    size_t operator()(const RabidSQL::Variant &value) const
+    {
+        return value.hash();
+    }
+};
+
+} // namespace std
+
+namespace RabidSQL {
+
+// Key equality for unordered containers of variants. Comparing values of
+// different types converts one of them, which can lose information (true ==
+// 5, 0 == "abc"), so keys must also hash equally to be the same key.
+struct VariantKeyEqual {
+    bool operator()(const Variant &left, const Variant &right) const
+    {
+        return left.hash() == right.hash() && left == right;
+    }
+};
+
+class VariantHashMap : public std::unordered_map<Variant, Variant,
+                                                 std::hash<Variant>,
+                                                 VariantKeyEqual> {
 
 public:
 };
@@ -1,6 +1,8 @@
 #include "App.h"
 #include "BinaryFileStream.h"
 #include "QueryResult.h"
+#include "ResultColumn.h"
+#include "ResultRows.h"
 
 namespace RabidSQL {
 
@@ -173,6 +175,347 @@ std::string BinaryFileStream::readString()
     return string;
 }
 
+/**
+ *
+ * Writes a string to the open binary stream, in the form readString() reads
+ *
+ * @param string The string to write
+ * @return void
+ */
+void BinaryFileStream::writeString(const std::string &string)
+{
+    size_t size = string.size();
+    write(reinterpret_cast<char *>(&size), sizeof(size));
+    write(string.data(), size);
+}
+
+/**
+ *
+ * Writes a query result to the open binary stream. Rows are written a block
+ * and a column at a time, each column's arrays in one go.
+ *
+ * @param result The result to write
+ * @return void
+ */
+void BinaryFileStream::writeResult(const QueryResult &result)
+{
+    int event = result.event;
+    size_t count;
+
+    *this << result.uid;
+    write(reinterpret_cast<const char *>(&result.is_valid),
+          sizeof(result.is_valid));
+    write(reinterpret_cast<const char *>(&result.affected_rows),
+          sizeof(result.affected_rows));
+    write(reinterpret_cast<const char *>(&result.num_rows),
+          sizeof(result.num_rows));
+    write(reinterpret_cast<char *>(&event), sizeof(event));
+
+    // Error
+    write(reinterpret_cast<const char *>(&result.error.isError),
+          sizeof(result.error.isError));
+    *this << result.error.code;
+    writeString(result.error.string);
+
+    // Column names
+    count = result.columns.size();
+    write(reinterpret_cast<char *>(&count), sizeof(count));
+    for (auto &name : result.columns) {
+        writeString(name);
+    }
+
+    // Column info
+    count = result.columnInfo.size();
+    write(reinterpret_cast<char *>(&count), sizeof(count));
+    for (auto &info : result.columnInfo) {
+        int type = info.type;
+
+        writeString(info.name);
+        writeString(info.table);
+        writeString(info.database);
+        writeString(info.sqlType);
+        write(reinterpret_cast<char *>(&type), sizeof(type));
+        write(reinterpret_cast<const char *>(&info.nullable),
+              sizeof(info.nullable));
+        write(reinterpret_cast<const char *>(&info.length),
+              sizeof(info.length));
+        write(reinterpret_cast<const char *>(&info.decimals),
+              sizeof(info.decimals));
+        writeString(info.charset);
+    }
+
+    // Rows
+    const ResultRows &rows = result.rows;
+    count = rows.blocks.size();
+    write(reinterpret_cast<const char *>(&rows.columns), sizeof(rows.columns));
+    write(reinterpret_cast<char *>(&count), sizeof(count));
+
+    for (auto &block : rows.blocks) {
+        for (auto &column : block) {
+            writeColumn(column);
+        }
+    }
+}
+
+/**
+ *
+ * Reads a query result written by writeResult()
+ *
+ * @param result The result to read into
+ * @return False if the data is invalid
+ */
+bool BinaryFileStream::readResult(QueryResult &result)
+{
+    int event = 0;
+    size_t count = 0;
+
+    *this >> result.uid;
+    read(reinterpret_cast<char *>(&result.is_valid), sizeof(result.is_valid));
+    read(reinterpret_cast<char *>(&result.affected_rows),
+         sizeof(result.affected_rows));
+    read(reinterpret_cast<char *>(&result.num_rows), sizeof(result.num_rows));
+    read(reinterpret_cast<char *>(&event), sizeof(event));
+    result.event = static_cast<QueryEvent>(event);
+
+    // Error
+    read(reinterpret_cast<char *>(&result.error.isError),
+         sizeof(result.error.isError));
+    *this >> result.error.code;
+    result.error.string = readString();
+
+    // Column names
+    read(reinterpret_cast<char *>(&count), sizeof(count));
+    for (size_t i = 0; i < count && !eof(); i++) {
+        result.columns.push_back(readString());
+    }
+
+    // Column info
+    read(reinterpret_cast<char *>(&count), sizeof(count));
+    for (size_t i = 0; i < count && !eof(); i++) {
+        ColumnInfo info;
+        int type = 0;
+
+        info.name = readString();
+        info.table = readString();
+        info.database = readString();
+        info.sqlType = readString();
+        read(reinterpret_cast<char *>(&type), sizeof(type));
+        read(reinterpret_cast<char *>(&info.nullable), sizeof(info.nullable));
+        read(reinterpret_cast<char *>(&info.length), sizeof(info.length));
+        read(reinterpret_cast<char *>(&info.decimals), sizeof(info.decimals));
+        info.charset = readString();
+
+        if (type < _FIRST || type > _LAST) {
+            return false;
+        }
+
+        info.type = static_cast<DataType>(type);
+        result.columnInfo.push_back(std::move(info));
+    }
+
+    // Rows
+    ResultRows &rows = result.rows;
+    size_t columns = 0;
+    read(reinterpret_cast<char *>(&columns), sizeof(columns));
+    read(reinterpret_cast<char *>(&count), sizeof(count));
+
+    if (eof()) {
+        return false;
+    }
+
+    rows.setColumnCount(columns);
+
+    for (size_t i = 0; i < count; i++) {
+        rows.blocks.emplace_back();
+
+        for (size_t j = 0; j < columns; j++) {
+            rows.blocks.back().emplace_back();
+
+            if (!readColumn(rows.blocks.back().back())) {
+                return false;
+            }
+        }
+
+        size_t blockRows = columns > 0 ? rows.blocks.back().front().size() : 0;
+
+        for (auto &column : rows.blocks.back()) {
+
+            // Every column of a block holds the same rows, and every block
+            // but the last is full
+            if (column.size() != blockRows) {
+                return false;
+            }
+        }
+
+        if (blockRows == 0 || (i + 1 < count
+                               && blockRows != ResultRows::BLOCK_ROWS)) {
+            return false;
+        }
+
+        rows.rows += blockRows;
+    }
+
+    // Statistics aren't stored; they're cheap to gather again
+    result.columnStats = rows.statistics();
+
+    return !fail();
+}
+
+/**
+ *
+ * Writes a column of a result block
+ *
+ * @param column The column to write
+ * @return void
+ */
+void BinaryFileStream::writeColumn(const ResultColumn &column)
+{
+    int storage = column.storage;
+    int type = column.type;
+    size_t count = column.count;
+
+    write(reinterpret_cast<char *>(&storage), sizeof(storage));
+    write(reinterpret_cast<char *>(&type), sizeof(type));
+    write(reinterpret_cast<char *>(&count), sizeof(count));
+    write(reinterpret_cast<const char *>(column.nullWords()),
+          (count + 63) / 64 * sizeof(unsigned long long));
+
+    switch (column.storage) {
+    case ResultColumn::S_INTEGER:
+        write(reinterpret_cast<const char *>(column.integerData()),
+              count * sizeof(long long));
+        break;
+    case ResultColumn::S_DOUBLE:
+        write(reinterpret_cast<const char *>(column.doubleData()),
+              count * sizeof(double));
+        break;
+    case ResultColumn::S_STRING:
+        write(reinterpret_cast<const char *>(column.offsetData()),
+              (count + 1) * sizeof(size_t));
+        write(column.byteData(), column.offsetData()[count]);
+        break;
+    case ResultColumn::S_VARIANT:
+        for (auto &value : column.variantValues) {
+            *this << value;
+        }
+        break;
+    case ResultColumn::S_DICTIONARY:
+        write(reinterpret_cast<const char *>(&column.entries),
+              sizeof(column.entries));
+        write(reinterpret_cast<const char *>(column.codeData()),
+              count * sizeof(unsigned int));
+        write(reinterpret_cast<const char *>(column.offsetData()),
+              (column.entries + 1) * sizeof(size_t));
+        write(column.byteData(), column.offsetData()[column.entries]);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ *
+ * Reads a column written by writeColumn()
+ *
+ * @param column An empty column to read into
+ * @return False if the data is invalid
+ */
+bool BinaryFileStream::readColumn(ResultColumn &column)
+{
+    int storage = 0;
+    int type = 0;
+    size_t count = 0;
+
+    read(reinterpret_cast<char *>(&storage), sizeof(storage));
+    read(reinterpret_cast<char *>(&type), sizeof(type));
+    read(reinterpret_cast<char *>(&count), sizeof(count));
+
+    if (eof() || storage < ResultColumn::S_NONE
+            || storage > ResultColumn::S_DICTIONARY || type < _FIRST
+            || type > _LAST || count > ResultRows::BLOCK_ROWS) {
+        return false;
+    }
+
+    column.storage = static_cast<ResultColumn::Storage>(storage);
+    column.type = static_cast<DataType>(type);
+    column.count = count;
+    column.nulls.resize((count + 63) / 64);
+    read(reinterpret_cast<char *>(column.nulls.data()),
+         column.nulls.size() * sizeof(unsigned long long));
+
+    switch (column.storage) {
+    case ResultColumn::S_INTEGER:
+        column.integerValues.resize(count);
+        read(reinterpret_cast<char *>(column.integerValues.data()),
+             count * sizeof(long long));
+        break;
+    case ResultColumn::S_DOUBLE:
+        column.doubleValues.resize(count);
+        read(reinterpret_cast<char *>(column.doubleValues.data()),
+             count * sizeof(double));
+        break;
+    case ResultColumn::S_DICTIONARY:
+        read(reinterpret_cast<char *>(&column.entries),
+             sizeof(column.entries));
+
+        if (eof() || column.entries == 0 || column.entries > count + 1) {
+            return false;
+        }
+
+        column.codeValues.resize(count);
+        read(reinterpret_cast<char *>(column.codeValues.data()),
+             count * sizeof(unsigned int));
+
+        for (auto code : column.codeValues) {
+
+            if (code >= column.entries) {
+                return false;
+            }
+        }
+        // The dictionary's values follow, stored as for S_STRING
+        // fall through
+    case ResultColumn::S_STRING:
+    {
+        size_t strings = column.storage == ResultColumn::S_DICTIONARY
+                ? column.entries : count;
+
+        column.offsets.resize(strings + 1);
+        read(reinterpret_cast<char *>(column.offsets.data()),
+             (strings + 1) * sizeof(size_t));
+
+        if (eof() || column.offsets.front() != 0) {
+            return false;
+        }
+
+        for (size_t i = 0; i < strings; i++) {
+
+            if (column.offsets[i] > column.offsets[i + 1]) {
+                return false;
+            }
+        }
+
+        column.bytes.resize(column.offsets.back());
+        read(column.bytes.data(), column.bytes.size());
+
+        for (auto code : column.codeValues) {
+            column.plainBytes += column.offsets[code + 1]
+                    - column.offsets[code];
+        }
+        break;
+    }
+    case ResultColumn::S_VARIANT:
+        column.variantValues.resize(count);
+        for (auto &value : column.variantValues) {
+            *this >> value;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return !fail();
+}
+
 /**
  *
  * Reads a variant from the open binary stream
@@ -238,7 +581,7 @@ FileStream &BinaryFileStream::operator>>(Variant &value)
                     vector.push_back(readString());
                 }
 
-                value = vector;
+                value = std::move(vector);
             }
             break;
         case D_VARIANTVECTOR:
@@ -256,10 +599,10 @@ FileStream &BinaryFileStream::operator>>(Variant &value)
                     *this >> value;
 
                     // Read a string and push it into the vector
-                    vector.push_back(value);
+                    vector.push_back(std::move(value));
                 }
 
-                value = vector;
+                value = std::move(vector);
             }
             break;
         case D_VARIANTMAP:
@@ -279,12 +622,38 @@ FileStream &BinaryFileStream::operator>>(Variant &value)
                     *this >> value;
 
                     // Read a string and push it into the vector
-                    map[key.toString()] = value;
+                    map[key.toString()] = std::move(value);
                 }
 
-                value = map;
+                value = std::move(map);
+            }
+            break;
+        case D_VARIANTHASHMAP:
+        {
+            // Get number of elements
+            read(reinterpret_cast<char *>(&count), sizeof(count));
+
+            VariantHashMap map;
+
+            if (count > 0) {
+                map.reserve(count);
+            }
+
+            for (auto i = 0; i < count; i++) {
+
+                Variant key;
+                Variant value;
+
+                // Read from stream
+                *this >> key;
+                *this >> value;
+
+                map.emplace(std::move(key), std::move(value));
             }
+
+            value = std::move(map);
             break;
+        }
         case D_LONG:
         {
             long data = 0;
@@ -373,13 +742,60 @@ FileStream &BinaryFileStream::operator>>(Variant &value)
             value = data;
             break;
         }
+        case D_DATETIME:
+        {
+            long long data = 0;
+            read(reinterpret_cast<char *>(&data), sizeof(data));
+
+            value = DateTime::unpack(data);
+            break;
+        }
+        case D_DECIMAL:
+        {
+            Decimal data = Decimal();
+            read(reinterpret_cast<char *>(&data.value), sizeof(data.value));
+            read(reinterpret_cast<char *>(&data.scale), sizeof(data.scale));
+
+            if (data.scale < 0 || data.scale > Decimal::MAX_DIGITS) {
+
+                // Invalid data
+                data = Decimal();
+            }
+
+            value = data;
+            break;
+        }
+        case D_BLOB:
+        {
+            size_t size = 0;
+            read(reinterpret_cast<char *>(&size), sizeof(size));
+
+            if (eof()) {
+
+                // Invalid data
+                value = nullptr;
+                break;
+            }
+
+            std::vector<unsigned char> data(size);
+            read(reinterpret_cast<char *>(data.data()), size);
+
+            value = Variant(data.data(), static_cast<size_t>(gcount()));
+            break;
+        }
         case D_QUERYRESULT:
-            #ifdef DEBUG
-            rDebug << "QueryResult binary loading not implemented!";
-            #endif
+        {
+            QueryResult result;
 
-            value = QueryResult();
+            if (!readResult(result)) {
+
+                // Invalid data
+                result = QueryResult();
+            }
+
+            value = std::move(result);
             break;
+        }
     }
 
     return *this;
@@ -404,45 +820,43 @@ FileStream &BinaryFileStream::operator<<(const Variant &value)
             break;
         case D_STRING:
         {
-            std::string data = value.toString();
-            auto size = data.size();
+            size_t size;
+            auto data = value.asString(&size);
             write(reinterpret_cast<char *>(&size), sizeof(size));
-            write(data.c_str(), size);
+            write(data, size);
             break;
         }
         case D_STRINGVECTOR:
         {
-            auto vector(value.toStringVector());
+            auto &vector = *value.asStringVector();
             auto count = vector.size();
 
             write(reinterpret_cast<char *>(&count), sizeof(count));
             if (count > 0) {
                 for (auto it = vector.begin(); it != vector.end(); ++it) {
-                    auto data = *it;
-                    auto size = data.size();
+                    auto size = it->size();
                     write(reinterpret_cast<char *>(&size), sizeof(size));
-                    write(data.c_str(), size);
+                    write(it->data(), size);
                 }
             }
             break;
         }
         case D_VARIANTVECTOR:
         {
-            auto vector(value.toVariantVector());
+            auto &vector = *value.asVariantVector();
             auto count = vector.size();
 
             write(reinterpret_cast<char *>(&count), sizeof(count));
             if (count > 0) {
                 for (auto it = vector.begin(); it != vector.end(); ++it) {
-                    Variant data = *it;
-                    *this << data;
+                    *this << *it;
                 }
             }
             break;
         }
         case D_VARIANTMAP:
         {
-            auto map(value.toVariantMap());
+            auto &map = *value.asVariantMap();
             auto count = map.size();
 
             write(reinterpret_cast<char *>(&count), sizeof(count));
@@ -454,11 +868,20 @@ FileStream &BinaryFileStream::operator<<(const Variant &value)
             }
             break;
         }
+        case D_VARIANTHASHMAP:
+        {
+            auto &map = *value.asVariantHashMap();
+            auto count = map.size();
+
+            write(reinterpret_cast<char *>(&count), sizeof(count));
+            for (auto it = map.cbegin(); it != map.cend(); ++it) {
+                *this << it->first;
+                *this << it->second;
+            }
+            break;
+        }
         case D_QUERYRESULT:
-            #ifdef DEBUG
-            rDebug << "Attempting to write QueryResult to stream. WARNING: This"
-                << "will write/return only an empty QueryResult structure!";
-            #endif
+            writeResult(*value.asQueryResult());
             break;
         case D_LONG:
         {
@@ -472,6 +895,18 @@ FileStream &BinaryFileStream::operator<<(const Variant &value)
             write((char *)(&data), sizeof(data));
             break;
         }
+        case D_LONGLONG:
+        {
+            auto data = value.toLongLong();
+            write((char *)(&data), sizeof(data));
+            break;
+        }
+        case D_ULONGLONG:
+        {
+            auto data = value.toULongLong();
+            write((char *)(&data), sizeof(data));
+            break;
+        }
         case D_INT:
         {
             auto data = value.toInt();
@@ -514,6 +949,27 @@ FileStream &BinaryFileStream::operator<<(const Variant &value)
             write((char *)(&data), sizeof(data));
             break;
         }
+        case D_DATETIME:
+        {
+            auto data = value.toDateTime().pack();
+            write((char *)(&data), sizeof(data));
+            break;
+        }
+        case D_DECIMAL:
+        {
+            auto data = value.toDecimal();
+            write((char *)(&data.value), sizeof(data.value));
+            write((char *)(&data.scale), sizeof(data.scale));
+            break;
+        }
+        case D_BLOB:
+        {
+            size_t size;
+            auto data = value.asBlob(&size);
+            write(reinterpret_cast<char *>(&size), sizeof(size));
+            write(reinterpret_cast<const char *>(data), size);
+            break;
+        }
     }
 
     return *this;
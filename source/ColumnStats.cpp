@@ -0,0 +1,462 @@
+#include "App.h"
+#include "ColumnStats.h"
+#include "ResultColumn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace RabidSQL {
+
+/**
+ *
+ * Spreads the bits of value over the whole hash (the splitmix64 finalizer)
+ *
+ * @param value The value to hash
+ * @return unsigned long long
+ */
+static unsigned long long mix(unsigned long long value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+
+    return value;
+}
+
+/**
+ *
+ * Hashes the bytes of a string
+ *
+ * @param value The bytes to hash
+ * @param length The number of bytes in value
+ * @return unsigned long long
+ */
+static unsigned long long hashBytes(const char *value, size_t length)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(value[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return mix(hash);
+}
+
+/**
+ *
+ * Compares two strings byte by byte
+ *
+ * @param left The first string
+ * @param leftLength The number of bytes in left
+ * @param right The second string
+ * @param rightLength The number of bytes in right
+ * @return Less than, equal to or greater than 0 if left is less than, equal to
+ * or greater than right
+ */
+static int compareBytes(const char *left, size_t leftLength, const char *right,
+                        size_t rightLength)
+{
+    size_t length = std::min(leftLength, rightLength);
+    int result = length == 0 ? 0 : std::memcmp(left, right, length);
+
+    if (result != 0) {
+        return result;
+    }
+
+    return leftLength < rightLength ? -1 : (leftLength > rightLength ? 1 : 0);
+}
+
+/**
+ *
+ * Creates statistics of an empty column
+ *
+ */
+ColumnStats::ColumnStats() :
+    cells(0),
+    nulls(0),
+    ordered(true)
+{
+}
+
+/**
+ *
+ * Adds the cells of column. Typed columns are scanned through their arrays;
+ * only columns of variants are read cell by cell.
+ *
+ * @param column The column to add
+ * @return void
+ */
+void ColumnStats::add(const ResultColumn &column)
+{
+    size_t size = column.size();
+    DataType type = column.getType();
+    size_t first = size;
+    size_t last = size;
+    size_t length;
+
+    cells += size;
+
+    if (registers.empty()) {
+        registers.assign(1 << PRECISION, 0);
+    }
+
+    if (const long long *values = column.integers()) {
+        bool isUnsigned = type == D_ULONG || type == D_ULONGLONG;
+
+        for (size_t row = 0; row < size; row++) {
+
+            if (column.isNull(row)) {
+                nulls++;
+                continue;
+            }
+
+            long long value = values[row];
+            addHash(mix(static_cast<unsigned long long>(value)));
+
+            if (first == size) {
+                first = last = row;
+            } else if (isUnsigned) {
+                auto unsignedValue = static_cast<unsigned long long>(value);
+
+                if (unsignedValue
+                        < static_cast<unsigned long long>(values[first])) {
+                    first = row;
+                } else if (unsignedValue
+                           > static_cast<unsigned long long>(values[last])) {
+                    last = row;
+                }
+            } else if (value < values[first]) {
+                first = row;
+            } else if (value > values[last]) {
+                last = row;
+            }
+        }
+    } else if (const double *values = column.doubles()) {
+
+        for (size_t row = 0; row < size; row++) {
+
+            if (column.isNull(row)) {
+                nulls++;
+                continue;
+            }
+
+            // -0.0 and 0.0 are the same value
+            double value = values[row] == 0 ? 0 : values[row];
+            unsigned long long bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            addHash(mix(bits));
+
+            if (first == size) {
+                first = last = row;
+            } else if (value < values[first]) {
+                first = row;
+            } else if (value > values[last]) {
+                last = row;
+            }
+        }
+    } else if (const unsigned int *codes = column.codes()) {
+        std::vector<bool> used(column.dictionarySize());
+        size_t leastLength = 0;
+        size_t greatestLength = 0;
+        const char *leastValue = nullptr;
+        const char *greatestValue = nullptr;
+
+        for (size_t row = 0; row < size; row++) {
+
+            if (column.isNull(row)) {
+                nulls++;
+            } else {
+                used[codes[row]] = true;
+            }
+        }
+
+        // Each distinct value only needs looking at once
+        for (size_t code = 0; code < used.size(); code++) {
+
+            if (!used[code]) {
+                continue;
+            }
+
+            const char *value = column.dictionaryValue(code, &length);
+            addHash(hashBytes(value, length));
+
+            if (leastValue == nullptr
+                    || compareBytes(value, length, leastValue,
+                                    leastLength) < 0) {
+                leastValue = value;
+                leastLength = length;
+            }
+
+            if (greatestValue == nullptr
+                    || compareBytes(value, length, greatestValue,
+                                    greatestLength) > 0) {
+                greatestValue = value;
+                greatestLength = length;
+            }
+        }
+
+        if (leastValue != nullptr) {
+            addRange(Variant(leastValue, leastLength),
+                     Variant(greatestValue, greatestLength), type);
+        }
+
+        return;
+    } else if (type == D_STRING || type == D_BLOB) {
+        size_t leastLength = 0;
+        size_t greatestLength = 0;
+        const char *leastValue = nullptr;
+        const char *greatestValue = nullptr;
+
+        for (size_t row = 0; row < size; row++) {
+
+            if (column.isNull(row)) {
+                nulls++;
+                continue;
+            }
+
+            const char *value = column.asString(row, &length);
+            addHash(hashBytes(value, length));
+
+            if (first == size) {
+                first = last = row;
+                leastValue = greatestValue = value;
+                leastLength = greatestLength = length;
+            } else if (compareBytes(value, length, leastValue,
+                                    leastLength) < 0) {
+                first = row;
+                leastValue = value;
+                leastLength = length;
+            } else if (compareBytes(value, length, greatestValue,
+                                    greatestLength) > 0) {
+                last = row;
+                greatestValue = value;
+                greatestLength = length;
+            }
+        }
+    } else {
+        Variant leastValue;
+        Variant greatestValue;
+
+        for (size_t row = 0; row < size; row++) {
+
+            if (column.isNull(row)) {
+                nulls++;
+                continue;
+            }
+
+            Variant value = column.at(row);
+            addHash(mix(value.hash()));
+
+            if (type == D_NULL) {
+
+                // Cells of different types have no meaningful order
+                ordered = false;
+            } else if (first == size || value < leastValue) {
+                first = row;
+                leastValue = value;
+            }
+
+            if (type != D_NULL && (last == size || value > greatestValue)) {
+                last = row;
+                greatestValue = value;
+            }
+        }
+    }
+
+    if (first != size) {
+        addRange(column.at(first), column.at(last), type);
+    }
+}
+
+/**
+ *
+ * Adds the statistics of another part of the same column
+ *
+ * @param stats The statistics to add
+ * @return void
+ */
+void ColumnStats::merge(const ColumnStats &stats)
+{
+    cells += stats.cells;
+    nulls += stats.nulls;
+
+    if (!stats.ordered) {
+        ordered = false;
+        least = Variant();
+        greatest = Variant();
+    } else if (!stats.least.isNull()) {
+        addRange(stats.least, stats.greatest, stats.least.getType());
+    }
+
+    if (registers.empty()) {
+        registers = stats.registers;
+    } else if (!stats.registers.empty()) {
+
+        for (size_t i = 0; i < registers.size(); i++) {
+            registers[i] = std::max(registers[i], stats.registers[i]);
+        }
+    }
+}
+
+/**
+ *
+ * Returns the number of cells, including nulls
+ *
+ * @return size_t
+ */
+size_t ColumnStats::count() const
+{
+    return cells;
+}
+
+/**
+ *
+ * Returns the number of null cells
+ *
+ * @return size_t
+ */
+size_t ColumnStats::nullCount() const
+{
+    return nulls;
+}
+
+/**
+ *
+ * Returns the least value, or null if every cell is null or the cells differ
+ * in type. Strings and blobs are ordered by their bytes.
+ *
+ * @return Variant
+ */
+Variant ColumnStats::minimum() const
+{
+    return least;
+}
+
+/**
+ *
+ * Returns the greatest value, or null if every cell is null or the cells
+ * differ in type. Strings and blobs are ordered by their bytes.
+ *
+ * @return Variant
+ */
+Variant ColumnStats::maximum() const
+{
+    return greatest;
+}
+
+/**
+ *
+ * Returns an estimate of the number of distinct non-null values
+ *
+ * @return size_t
+ */
+size_t ColumnStats::distinctCount() const
+{
+    if (registers.empty()) {
+        return 0;
+    }
+
+    double size = static_cast<double>(registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+
+    for (auto rank : registers) {
+        sum += std::ldexp(1.0, -rank);
+
+        if (rank == 0) {
+            zeros++;
+        }
+    }
+
+    double estimate = 0.7213 / (1 + 1.079 / size) * size * size / sum;
+
+    if (estimate <= 2.5 * size && zeros != 0) {
+
+        // Few values. Count the empty registers instead.
+        estimate = size * std::log(size / zeros);
+    }
+
+    return std::min(static_cast<size_t>(std::llround(estimate)),
+                    cells - nulls);
+}
+
+/**
+ *
+ * Returns the approximate number of bytes the statistics occupy
+ *
+ * @return size_t
+ */
+size_t ColumnStats::memoryUsage() const
+{
+    return sizeof(ColumnStats) + registers.capacity();
+}
+
+/**
+ *
+ * Widens the range of values to take in least and greatest
+ *
+ * @param least The least value to add
+ * @param greatest The greatest value to add
+ * @param type The type of the values, or D_NULL if they differ in type
+ * @return void
+ */
+void ColumnStats::addRange(const Variant &least, const Variant &greatest,
+                           DataType type)
+{
+    if (!ordered) {
+        return;
+    }
+
+    if (type == D_NULL || (!this->least.isNull()
+                           && this->least.getType() != least.getType())) {
+        ordered = false;
+        this->least = Variant();
+        this->greatest = Variant();
+    } else if (this->least.isNull()) {
+        this->least = least;
+        this->greatest = greatest;
+    } else {
+
+        if (least < this->least) {
+            this->least = least;
+        }
+
+        if (greatest > this->greatest) {
+            this->greatest = greatest;
+        }
+    }
+}
+
+/**
+ *
+ * Adds a value's hash to the distinct value sketch
+ *
+ * @param hash The hash of the value
+ * @return void
+ */
+void ColumnStats::addHash(unsigned long long hash)
+{
+    size_t index = static_cast<size_t>(hash >> (64 - PRECISION));
+
+    // The bit past the end bounds the rank
+    unsigned long long rest = (hash << PRECISION) | (1ULL << (PRECISION - 1));
+
+#if defined(__GNUC__)
+    auto rank = static_cast<unsigned char>(__builtin_clzll(rest) + 1);
+#else
+    unsigned char rank = 1;
+
+    while ((rest & (1ULL << 63)) == 0) {
+        rest <<= 1;
+        rank++;
+    }
+#endif
+
+    registers[index] = std::max(registers[index], rank);
+}
+
+} // namespace RabidSQL
@@ -192,7 +192,7 @@ std::vector<ConnectionSettings *> ConnectionSettings::load(
 
     if (data.getType() == D_VARIANTVECTOR) {
 
-        auto connections = data.toVariantVector();
+        auto &connections = *data.asVariantVector();
 
         for (auto it = connections.begin(); it != connections.end(); ++it) {
 
@@ -201,7 +201,7 @@ std::vector<ConnectionSettings *> ConnectionSettings::load(
                 connectionSettings = new ConnectionSettings();
 
                 // Load from map
-                *connectionSettings << it->toVariantMap();
+                *connectionSettings << *it->asVariantMap();
 
                 // Add to collection
                 connectionList.push_back(connectionSettings);
@@ -244,20 +244,30 @@ void ConnectionSettings::reparentChildren(
         return;
     }
 
-    // Get children for the current connection settings
-    auto children = currentSettings->get("children").toVariantVector();
+    // Get children for the current connection settings. This shares the
+    // stored vector, so it stays valid after removing it from the settings
+    auto childrenData = currentSettings->get("children");
+    auto children = childrenData.asVariantVector();
 
     // Remove children vector
     currentSettings->remove("children");
 
+    if (children == nullptr) {
+
+        // Children are not stored as a list. Nothing to reparent.
+        return;
+    }
+
     // Iterate collection
-    for (auto it = children.begin(); it != children.end(); ++it) {
+    for (auto it = children->begin(); it != children->end(); ++it) {
 
         // Initialize settings
         auto connectionSettings = new ConnectionSettings();
 
         // Load from map
-        *connectionSettings << it->toVariantMap();
+        if (it->getType() == D_VARIANTMAP) {
+            *connectionSettings << *it->asVariantMap();
+        }
 
         // Set the parent for this connection to the correct parent
         connectionSettings->setParent(currentSettings);
@@ -325,6 +335,9 @@ VariantMap ConnectionSettings::toVariantMap()
 {
     VariantMap map;
 
+    // Room for every setting plus the children
+    map.reserve(settings.size() + 1);
+
     // Ensure UUID is generated already in the event this is a new
     // connection
     get("uuid");
@@ -5,6 +5,9 @@
 
 namespace RabidSQL {
 
+const size_t DatabaseConnection::STREAM_BATCH_ROWS;
+const int DatabaseConnection::STREAM_INTERVAL;
+
 /**
  *
  * Constructs the database class, applying settings from the provided connection
@@ -20,6 +23,8 @@ DatabaseConnection::DatabaseConnection(ConnectionSettings *settings): Thread()
 
     mainConnection = nullptr;
     manager = nullptr;
+
+    streaming = false;
 }
 
 /**
@@ -42,6 +47,7 @@ DatabaseConnection::DatabaseConnection(DatabaseConnection *mainConnection,
     this->manager = manager;
 
     busy = false;
+    streaming = false;
 }
 
 /**
@@ -93,7 +99,7 @@ void DatabaseConnection::run()
         if (!commands.empty()) {
 
             // Get the next command on the queue.
-            command = commands.front();
+            command = std::move(commands.front());
 
             // Remove from queue
             commands.pop();
@@ -135,32 +141,43 @@ void DatabaseConnection::run()
             }
             break;
         case LIST_DATABASES:
-            queueData(EXECUTED, VariantVector()
-                                << command.uid
-                                << command.event
-                                << getDatabases(command.arguments.front()
-                                       .toStringVector()));
-            break;
         case LIST_TABLES:
+        case EXECUTE_QUERY:
+        case STREAM_QUERY:
             queueData(EXECUTED, VariantVector()
                                 << command.uid
                                 << command.event
-                                <<
-                                getTables(command.arguments.front().toString()));
+                                << query(command));
             break;
-        case EXECUTE_QUERY:
+        case EXECUTE_BATCH:
+        {
+            VariantVector results;
+            QueryResult summary = batch(command, results);
+
             queueData(EXECUTED, VariantVector()
                                 << command.uid
                                 << command.event
-                                << execute(command.arguments));
+                                << std::move(summary)
+                                << std::move(results));
             break;
+        }
         case SELECT_DATABASE:
+        {
+            std::string name = command.arguments.front().toString();
+            QueryResult selected = selectDatabase(name);
+
+            if (!selected.error.isError) {
+
+                // Cached results are keyed by the current database
+                database = name;
+            }
+
             queueData(EXECUTED, VariantVector()
                                 << command.uid
                                 << command.event
-                                << selectDatabase(
-                    command.arguments.front().toString()));
+                                << std::move(selected));
             break;
+        }
         case KILL_QUERY:
             queueData(EXECUTED, VariantVector()
                                 << command.uid
@@ -207,7 +224,7 @@ void DatabaseConnection::call(Variant uid, QueryEvent event,
     // Configure command
     command.uid = uid;
     command.event = event;
-    command.arguments = arguments;
+    command.arguments = std::move(arguments);
 
     // Lock mutex
     mutex.lock();
@@ -218,12 +235,401 @@ void DatabaseConnection::call(Variant uid, QueryEvent event,
     this->busy = true;
 
     // Add to queue
-    this->commands.push(command);
+    this->commands.push(std::move(command));
 
     // Unlock mutex
     mutex.unlock();
 }
 
+/**
+ *
+ * Returns true while statements run in a transaction that hasn't been
+ * committed. Results read then aren't shared through the result cache, since
+ * other connections can't see the rows they reflect. Drivers that can run
+ * transactions should override this.
+ *
+ * @return bool
+ */
+bool DatabaseConnection::inTransaction() const
+{
+    return false;
+}
+
+/**
+ *
+ * Starts the transaction a batch runs in. Drivers whose execute() can't run
+ * START TRANSACTION, COMMIT and ROLLBACK should override this and
+ * endTransaction().
+ *
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::beginTransaction()
+{
+    return execute(VariantVector() << "START TRANSACTION");
+}
+
+/**
+ *
+ * Ends the transaction started by beginTransaction()
+ *
+ * @param commit True to commit it, false to roll it back
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::endTransaction(bool commit)
+{
+    return execute(VariantVector() << (commit ? "COMMIT" : "ROLLBACK"));
+}
+
+/**
+ *
+ * Returns the database selected by SELECT_DATABASE or a USE statement, or an
+ * empty string if none has been. Drivers select it again when they reconnect.
+ *
+ * @return const std::string&
+ */
+const std::string &DatabaseConnection::getDatabase() const
+{
+    return database;
+}
+
+/**
+ *
+ * Returns true while a STREAM_QUERY command is executing. Drivers should then
+ * read rows as the server sends them rather than buffering the whole result,
+ * and call streamRows() after each row.
+ *
+ * @return bool
+ */
+bool DatabaseConnection::isStreaming() const
+{
+    return streaming;
+}
+
+/**
+ *
+ * Called by drivers after each row is added to result. While streaming, queues
+ * the rows read so far as a ROWS_FETCHED batch once STREAM_BATCH_ROWS rows or
+ * STREAM_INTERVAL milliseconds have accumulated, and empties result.rows.
+ * Does nothing otherwise.
+ *
+ * @param result The result being read
+ * @return void
+ */
+void DatabaseConnection::streamRows(QueryResult &result)
+{
+    if (!streaming) {
+        return;
+    }
+
+    size_t count = result.rows.size();
+
+    if (count < STREAM_BATCH_ROWS) {
+
+        // Only look at the clock every so often; it's slow next to a row
+        if (count % 64 != 0
+                || std::chrono::steady_clock::now() - lastBatch
+                   < std::chrono::milliseconds(STREAM_INTERVAL)) {
+            return;
+        }
+    }
+
+    queueRows(result);
+}
+
+/**
+ *
+ * Runs a LIST_DATABASES, LIST_TABLES, EXECUTE_QUERY or STREAM_QUERY command.
+ * When the manager's result cache is enabled, cacheable commands are answered
+ * from it where possible and their results added to it otherwise, and other
+ * statements drop the cached results they may have changed. Inside a
+ * transaction nothing is read from or added to the cache, and the writes made
+ * in it drop their results again when it ends, since other connections may
+ * have cached the old rows meanwhile.
+ *
+ * @param command The command to run
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::query(const QueryCommand &command)
+{
+    ResultCache *cache = manager != nullptr && manager->resultCache.isEnabled()
+            ? &manager->resultCache : nullptr;
+    unsigned long long generation = 0;
+    std::string key;
+    QueryResult result;
+
+    if (cache != nullptr && !inTransaction()) {
+        key = cache->makeKey(command.event, command.arguments, database);
+        generation = cache->generation();
+
+        if (!key.empty() && cache->find(key, result)) {
+            return result;
+        }
+    }
+
+    switch (command.event) {
+    case LIST_DATABASES:
+        result = getDatabases(command.arguments.front().toStringVector());
+        break;
+    case LIST_TABLES:
+        result = getTables(command.arguments.front().toString());
+        break;
+    case EXECUTE_QUERY:
+        result = execute(command.arguments);
+        break;
+    case STREAM_QUERY:
+        result = stream(command);
+        break;
+    default:
+        break;
+    }
+
+    if (command.event == EXECUTE_QUERY || command.event == STREAM_QUERY) {
+        std::string sql = command.arguments.front().toString();
+        ResultCache::Statement statement = ResultCache::parse(sql);
+
+        if (statement.type == ResultCache::SESSION
+                && !statement.database.empty() && !result.error.isError) {
+
+            // USE changes which tables unqualified names refer to
+            database = statement.database;
+        }
+
+        if (cache != nullptr && key.empty()) {
+            cache->invalidate(sql);
+        }
+
+        if (inTransaction()) {
+
+            if (statement.type != ResultCache::READ
+                    && statement.type != ResultCache::SESSION) {
+                transactionWrites.push_back(sql);
+            }
+        } else if (!transactionWrites.empty()) {
+
+            // Committed or rolled back
+            if (cache != nullptr) {
+
+                for (auto &write : transactionWrites) {
+                    cache->invalidate(write);
+                }
+            }
+
+            transactionWrites.clear();
+        }
+    }
+
+    if (cache != nullptr && !key.empty()) {
+        cache->insert(key, command.event, command.arguments, result,
+                      generation);
+    }
+
+    return result;
+}
+
+/**
+ *
+ * Executes statements one after another, stopping at the first that fails.
+ * Drivers that can send several statements in one round trip should do so
+ * when multiStatement is true; this runs each through execute().
+ *
+ * @param statements The statements. Each holds the query followed by its
+ * bind parameters, as execute() takes them.
+ * @param multiStatement True to send statements together where possible
+ * @return The result of each statement run
+ */
+std::vector<QueryResult> DatabaseConnection::executeBatch(
+        const std::vector<VariantVector> &statements, bool)
+{
+    std::vector<QueryResult> results;
+
+    for (auto &statement : statements) {
+        results.push_back(execute(statement));
+
+        if (results.back().error.isError) {
+            break;
+        }
+    }
+
+    return results;
+}
+
+/**
+ *
+ * Runs an EXECUTE_BATCH command. Its arguments are the statements, each a
+ * VariantVector of the query and its bind parameters, optionally followed by
+ * a VariantMap of options:
+ *
+ * "transaction": run the statements in one transaction, rolled back if any
+ * fails
+ * "multi_statement": let the driver send statements without parameters
+ * together (see executeBatch())
+ *
+ * Statements after one that fails aren't run. Cached results the statements
+ * may have changed are dropped, and dropped again when the transaction ends.
+ * A failed rollback is reported after the error that caused it.
+ *
+ * @param command The command to run
+ * @param results Receives the QueryResult of each statement run
+ * @return A summary: the first error, if any, and the total affected rows
+ */
+QueryResult DatabaseConnection::batch(const QueryCommand &command,
+                                      VariantVector &results)
+{
+    std::vector<VariantVector> statements;
+    bool transaction = false;
+    bool multiStatement = false;
+    QueryResult summary;
+
+    for (auto &argument : command.arguments) {
+
+        if (argument.getType() == D_VARIANTMAP) {
+            VariantMap options = argument.toVariantMap();
+            transaction = options["transaction"].toBool();
+            multiStatement = options["multi_statement"].toBool();
+        } else if (argument.getType() == D_VARIANTVECTOR) {
+            statements.push_back(argument.toVariantVector());
+        }
+    }
+
+    if (transaction) {
+        summary = beginTransaction();
+
+        if (summary.error.isError) {
+            return summary;
+        }
+    }
+
+    std::vector<QueryResult> executed = executeBatch(statements,
+                                                     multiStatement);
+    ResultCache *cache = manager != nullptr && manager->resultCache.isEnabled()
+            ? &manager->resultCache : nullptr;
+
+    summary = QueryResult();
+    summary.uid = command.uid;
+    summary.event = EXECUTE_BATCH;
+    summary.is_valid = executed.size() == statements.size();
+
+    for (size_t i = 0; i < executed.size(); i++) {
+        std::string sql = statements[i].front().toString();
+        ResultCache::Statement statement = ResultCache::parse(sql);
+
+        if (executed[i].error.isError) {
+            summary.is_valid = false;
+            summary.error = executed[i].error;
+        } else if (statement.type == ResultCache::SESSION
+                   && !statement.database.empty()) {
+
+            // USE changes which tables unqualified names refer to
+            database = statement.database;
+        }
+
+        if (cache != nullptr) {
+            cache->invalidate(sql);
+        }
+
+        summary.affected_rows += executed[i].affected_rows;
+        results << std::move(executed[i]);
+    }
+
+    if (transaction) {
+        QueryResult ended = endTransaction(summary.is_valid);
+
+        if (ended.error.isError && summary.is_valid) {
+            summary.is_valid = false;
+            summary.error = ended.error;
+        } else if (ended.error.isError) {
+
+            // The statement's error stays first
+            summary.error.string += "; ROLLBACK failed: " + ended.error.string;
+        }
+
+        if (cache != nullptr) {
+
+            // Other connections may have cached the old rows again meanwhile
+            for (size_t i = 0; i < executed.size(); i++) {
+                cache->invalidate(statements[i].front().toString());
+            }
+        }
+    }
+
+    return summary;
+}
+
+/**
+ *
+ * Executes a STREAM_QUERY command. Rows are queued in ROWS_FETCHED batches as
+ * they arrive, each carrying the uid, event, a QueryResult holding the columns,
+ * the batch's rows and their statistics, and the index of the batch's first
+ * row. The result returned holds no rows; num_rows is the total and
+ * columnStats the statistics of every row.
+ *
+ * @param command The command to execute
+ * @return QueryResult
+ */
+QueryResult DatabaseConnection::stream(const QueryCommand &command)
+{
+    QueryResult result;
+
+    streaming = true;
+    streamUid = command.uid;
+    streamedRows = 0;
+    streamStats.clear();
+    lastBatch = std::chrono::steady_clock::now();
+
+    result = execute(command.arguments);
+
+    if (!result.rows.empty()) {
+
+        // Send the rows after the last full batch
+        queueRows(result);
+    }
+
+    result.num_rows = static_cast<int>(streamedRows);
+    result.columnStats = std::move(streamStats);
+    streaming = false;
+
+    return result;
+}
+
+/**
+ *
+ * Queues the rows of result as a ROWS_FETCHED batch and empties result.rows
+ *
+ * @param result The result being read
+ * @return void
+ */
+void DatabaseConnection::queueRows(QueryResult &result)
+{
+    QueryResult batch;
+    unsigned long long first = streamedRows;
+
+    batch.uid = result.uid;
+    batch.is_valid = result.is_valid;
+    batch.columns = result.columns;
+    batch.columnInfo = result.columnInfo;
+    batch.rows = std::move(result.rows);
+    batch.columnStats = batch.rows.statistics();
+    streamedRows += batch.rows.size();
+
+    streamStats.resize(batch.columnStats.size());
+
+    for (size_t i = 0; i < batch.columnStats.size(); i++) {
+        streamStats[i].merge(batch.columnStats[i]);
+    }
+
+    // Keep filling the same columns
+    result.rows.setColumnCount(batch.rows.columnCount());
+    result.rows.reserve(STREAM_BATCH_ROWS);
+
+    queueData(ROWS_FETCHED, VariantVector()
+                            << streamUid
+                            << STREAM_QUERY
+                            << std::move(batch)
+                            << first);
+
+    lastBatch = std::chrono::steady_clock::now();
+}
+
 /**
  *
  * Kills the current query
@@ -113,6 +113,8 @@ DatabaseConnection *DatabaseConnectionManager::reserveDatabaseConnectionObj(
                         // signals
                         connection->disconnectQueue(
                             DatabaseConnection::EXECUTED);
+                        connection->disconnectQueue(
+                            DatabaseConnection::ROWS_FETCHED);
 
                         // Rollback transaction if applicable
                         connection->call(Variant(),
@@ -143,6 +145,8 @@ DatabaseConnection *DatabaseConnectionManager::reserveDatabaseConnectionObj(
                             // Ensure this connection's signals are disconnected
                             currentConnection->disconnectQueue(
                                 DatabaseConnection::EXECUTED);
+                            currentConnection->disconnectQueue(
+                                DatabaseConnection::ROWS_FETCHED);
 
                             // Connect to ourself. After the disconnect
                             // completes, we need to free the connection
@@ -198,8 +202,9 @@ DatabaseConnection *DatabaseConnectionManager::reserveDatabaseConnectionObj(
         // Lock mutex
         connection->mutex.lock();
 
-        // Connect signal
+        // Connect signals
         connection->connectQueue(DatabaseConnection::EXECUTED, receiver);
+        connection->connectQueue(DatabaseConnection::ROWS_FETCHED, receiver);
 
         // Unlock mutex
         connection->mutex.unlock();
@@ -317,7 +322,7 @@ void DatabaseConnectionManager::call(DatabaseConnection *connection,
                                      QueryEvent event,
                                      VariantVector arguments)
 {
-    connection->call(uid, event, arguments);
+    connection->call(uid, event, std::move(arguments));
 }
 
 /**
@@ -341,7 +346,7 @@ void DatabaseConnectionManager::call(std::string uuid, Variant uid,
         if (it->second.uuid == uuid) {
 
             // Execute query
-            call(it->first, uid, event, arguments);
+            call(it->first, uid, event, std::move(arguments));
 
             while (blocking && it->first->busy) {
 
@@ -412,6 +417,40 @@ void DatabaseConnectionManager::killQuery(std::string uuid)
     }
 }
 
+/**
+ *
+ * Enables caching of read-only query, database and table listing results
+ * across this manager's connections, or disables it if memoryLimit is 0.
+ * Repeated commands are answered from the cache until their results expire or
+ * a write through this manager touches their tables. A query can set its own
+ * TTL, or opt out with 0, through a "cache_ttl" entry in its options map.
+ *
+ * Invalidation only sees the tables a statement names. Changes made by other
+ * clients, or reaching other tables through views, triggers or foreign key
+ * cascades, leave cached results stale until the TTL expires, so pick a TTL
+ * that stale results can be tolerated for.
+ *
+ * @param memoryLimit The most memory cached results may use, in bytes
+ * @param ttl How long results are kept, in milliseconds
+ * @return void
+ */
+void DatabaseConnectionManager::setResultCache(size_t memoryLimit,
+                                               unsigned int ttl)
+{
+    resultCache.setLimits(memoryLimit, ttl);
+}
+
+/**
+ *
+ * Drops every cached result, e.g. after the data was changed by another client
+ *
+ * @return void
+ */
+void DatabaseConnectionManager::clearResultCache()
+{
+    resultCache.clear();
+}
+
 /**
  *
  * Destroys this connection manager
@@ -0,0 +1,264 @@
+#include "App.h"
+#include "DateTime.h"
+
+namespace RabidSQL {
+
+/**
+ *
+ * Reads exactly count digits starting at position
+ *
+ * @param string The characters to read
+ * @param length The number of characters in string
+ * @param position The position to start at. Advanced past the digits.
+ * @param count The number of digits to read
+ * @param value Receives the value of the digits
+ * @return True if count digits were available
+ */
+static bool readField(const char *string, size_t length, size_t &position,
+                      int count, int &value)
+{
+    value = 0;
+
+    for (int i = 0; i < count; i++, position++) {
+
+        if (position >= length || string[position] < '0'
+                || string[position] > '9') {
+            return false;
+        }
+
+        value = value * 10 + (string[position] - '0');
+    }
+
+    return true;
+}
+
+/**
+ *
+ * Writes value as exactly count digits, padding with zeros
+ *
+ * @param buffer The buffer to write to
+ * @param count The number of digits to write
+ * @param value The value to write
+ * @return The number of characters written (count)
+ */
+static size_t writeField(char *buffer, int count, int value)
+{
+    for (int i = count - 1; i >= 0; i--) {
+        buffer[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+
+    return count;
+}
+
+/**
+ *
+ * Packs this date into an integer. From the most significant bit down the
+ * fields are year * 13 + month, day, hour, minute, second, microsecond and
+ * hasTime, so comparing packed values compares the dates.
+ *
+ * @return long long
+ */
+long long DateTime::pack() const
+{
+    long long packed = year * 13LL + month;
+
+    packed = (packed << 5) | day;
+    packed = (packed << 5) | hour;
+    packed = (packed << 6) | minute;
+    packed = (packed << 6) | second;
+    packed = (packed << 20) | microsecond;
+
+    return (packed << 1) | (hasTime ? 1 : 0);
+}
+
+/**
+ *
+ * Unpacks a value created by pack()
+ *
+ * @param packed The packed value
+ * @return DateTime
+ */
+DateTime DateTime::unpack(long long packed)
+{
+    DateTime value;
+
+    value.hasTime = (packed & 1) != 0;
+    packed >>= 1;
+    value.microsecond = static_cast<int>(packed & 0xfffff);
+    packed >>= 20;
+    value.second = static_cast<int>(packed & 0x3f);
+    packed >>= 6;
+    value.minute = static_cast<int>(packed & 0x3f);
+    packed >>= 6;
+    value.hour = static_cast<int>(packed & 0x1f);
+    packed >>= 5;
+    value.day = static_cast<int>(packed & 0x1f);
+    packed >>= 5;
+    value.month = static_cast<int>(packed % 13);
+    value.year = static_cast<int>(packed / 13);
+
+    return value;
+}
+
+/**
+ *
+ * Parses "YYYY-MM-DD", "YYYY-MM-DD hh:mm:ss" or "YYYY-MM-DD hh:mm:ss.ffffff"
+ * (with up to six fractional digits). MySQL's zero dates are accepted. The
+ * whole string must match.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @param value Receives the parsed value
+ * @return True on success
+ */
+bool DateTime::parse(const char *string, size_t length, DateTime &value)
+{
+    size_t position = 0;
+    DateTime result;
+
+    if (!readField(string, length, position, 4, result.year)
+            || position >= length || string[position++] != '-'
+            || !readField(string, length, position, 2, result.month)
+            || position >= length || string[position++] != '-'
+            || !readField(string, length, position, 2, result.day)) {
+        return false;
+    }
+
+    result.hasTime = position < length;
+
+    if (result.hasTime) {
+
+        if ((string[position] != ' ' && string[position] != 'T')
+                || !readField(string, length, ++position, 2, result.hour)
+                || position >= length || string[position++] != ':'
+                || !readField(string, length, position, 2, result.minute)
+                || position >= length || string[position++] != ':'
+                || !readField(string, length, position, 2, result.second)) {
+            return false;
+        }
+
+        if (position < length) {
+
+            // Fractional seconds
+            if (string[position++] != '.' || position == length
+                    || length - position > 6) {
+                return false;
+            }
+
+            int digits = static_cast<int>(length - position);
+
+            if (!readField(string, length, position, digits,
+                           result.microsecond)) {
+                return false;
+            }
+
+            for (; digits < 6; digits++) {
+                result.microsecond *= 10;
+            }
+        }
+    }
+
+    if (result.month > 12 || result.day > 31 || result.hour > 23
+            || result.minute > 59 || result.second > 59) {
+        return false;
+    }
+
+    value = result;
+
+    return true;
+}
+
+/**
+ *
+ * Writes this date the way MySQL does. The time is omitted for plain dates and
+ * the fraction when there are no microseconds. The buffer must hold at least
+ * BUFFER_SIZE characters. The result is not null-terminated.
+ *
+ * @param buffer The buffer to write to
+ * @return The number of characters written
+ */
+size_t DateTime::format(char *buffer) const
+{
+    size_t length = 0;
+
+    length += writeField(buffer + length, 4, year);
+    buffer[length++] = '-';
+    length += writeField(buffer + length, 2, month);
+    buffer[length++] = '-';
+    length += writeField(buffer + length, 2, day);
+
+    if (!hasTime) {
+        return length;
+    }
+
+    buffer[length++] = ' ';
+    length += writeField(buffer + length, 2, hour);
+    buffer[length++] = ':';
+    length += writeField(buffer + length, 2, minute);
+    buffer[length++] = ':';
+    length += writeField(buffer + length, 2, second);
+
+    if (microsecond != 0) {
+        buffer[length++] = '.';
+        length += writeField(buffer + length, 6, microsecond);
+    }
+
+    return length;
+}
+
+/**
+ *
+ * Returns this date as a number the way MySQL does in numeric context, i.e.
+ * YYYYMMDDhhmmss (or YYYYMMDD for plain dates)
+ *
+ * @return long long
+ */
+long long DateTime::toNumber() const
+{
+    long long number = (year * 100LL + month) * 100 + day;
+
+    if (hasTime) {
+        number = ((number * 100 + hour) * 100 + minute) * 100 + second;
+    }
+
+    return number;
+}
+
+/**
+ *
+ * Compares two dates. Whether they have a time part is ignored.
+ *
+ * @param value The value to compare
+ * @return bool
+ */
+bool DateTime::operator==(const DateTime &value) const
+{
+    return (pack() >> 1) == (value.pack() >> 1);
+}
+
+/**
+ *
+ * Returns true if this date is earlier than value
+ *
+ * @param value The value to compare
+ * @return bool
+ */
+bool DateTime::operator<(const DateTime &value) const
+{
+    return (pack() >> 1) < (value.pack() >> 1);
+}
+
+/**
+ *
+ * Returns true if this date is later than value
+ *
+ * @param value The value to compare
+ * @return bool
+ */
+bool DateTime::operator>(const DateTime &value) const
+{
+    return (pack() >> 1) > (value.pack() >> 1);
+}
+
+} // namespace RabidSQL
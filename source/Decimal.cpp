@@ -0,0 +1,198 @@
+#include "App.h"
+#include "Decimal.h"
+#include "NumericConversion.h"
+
+#include <cstring>
+#include <limits>
+
+namespace RabidSQL {
+
+static const long long POWERS_OF_TEN[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+    100000000LL, 1000000000LL, 10000000000LL, 100000000000LL,
+    1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+    1000000000000000000LL
+};
+
+/**
+ *
+ * Parses a plain decimal number ([+-]digits[.digits]), as MySQL returns DECIMAL
+ * columns. The whole string must match and hold no more than MAX_DIGITS digits.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @param value Receives the parsed value
+ * @return True on success
+ */
+bool Decimal::parse(const char *string, size_t length, Decimal &value)
+{
+    size_t position = 0;
+    bool negative = false;
+    bool point = false;
+    bool any = false;
+    int digits = 0;
+    Decimal result = Decimal();
+
+    if (position < length && (string[position] == '-'
+                              || string[position] == '+')) {
+        negative = string[position] == '-';
+        position++;
+    }
+
+    for (; position < length; position++) {
+
+        char character = string[position];
+
+        if (character == '.' && !point) {
+            point = true;
+        } else if (character >= '0' && character <= '9') {
+
+            if (result.value != 0 || character != '0') {
+                digits++;
+            }
+
+            if (digits > MAX_DIGITS || (point && result.scale >= MAX_DIGITS)) {
+
+                // Doesn't fit
+                return false;
+            }
+
+            result.value = result.value * 10 + (character - '0');
+            any = true;
+            if (point) {
+                result.scale++;
+            }
+        } else {
+
+            // Not a decimal
+            return false;
+        }
+    }
+
+    if (!any) {
+
+        // Nothing but a sign or a point
+        return false;
+    }
+
+    if (negative) {
+        result.value = -result.value;
+    }
+
+    value = result;
+
+    return true;
+}
+
+/**
+ *
+ * Writes this number with exactly scale fractional digits, e.g. "-0.50". The
+ * buffer must hold at least BUFFER_SIZE characters. The result is not
+ * null-terminated.
+ *
+ * @param buffer The buffer to write to
+ * @return The number of characters written
+ */
+size_t Decimal::format(char *buffer) const
+{
+    char digits[NumericConversion::BUFFER_SIZE];
+    size_t length = 0;
+    unsigned long long magnitude = value < 0
+            ? 0 - static_cast<unsigned long long>(value)
+            : static_cast<unsigned long long>(value);
+    size_t count = NumericConversion::formatUnsigned(digits, magnitude);
+    size_t fraction = static_cast<size_t>(scale);
+
+    if (value < 0) {
+        buffer[length++] = '-';
+    }
+
+    if (count <= fraction) {
+
+        // No integer part. Pad with zeros, e.g. 5 at scale 3 is 0.005
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        memset(buffer + length, '0', fraction - count);
+        length += fraction - count;
+        memcpy(buffer + length, digits, count);
+
+        return length + count;
+    }
+
+    memcpy(buffer + length, digits, count - fraction);
+    length += count - fraction;
+
+    if (fraction > 0) {
+        buffer[length++] = '.';
+        memcpy(buffer + length, digits + count - fraction, fraction);
+        length += fraction;
+    }
+
+    return length;
+}
+
+/**
+ *
+ * Returns the nearest double to this number
+ *
+ * @return double
+ */
+double Decimal::toDouble() const
+{
+    return static_cast<double>(value) / POWERS_OF_TEN[scale];
+}
+
+/**
+ *
+ * Returns the integer part of this number (rounding towards zero)
+ *
+ * @return long long
+ */
+long long Decimal::truncate() const
+{
+    return value / POWERS_OF_TEN[scale];
+}
+
+/**
+ *
+ * Compares this number with value
+ *
+ * @param value The value to compare
+ * @return Less than, equal to or greater than zero if this number is less
+ *         than, equal to or greater than value
+ */
+int Decimal::compare(const Decimal &value) const
+{
+    long long left = this->value;
+    long long right = value.value;
+    int difference = scale - value.scale;
+
+    // Bring both to the larger scale. If that overflows, the rescaled side has
+    // the larger magnitude so its sign decides.
+    if (difference > 0) {
+
+        if (right > std::numeric_limits<long long>::max()
+                / POWERS_OF_TEN[difference]
+                || right < std::numeric_limits<long long>::min()
+                / POWERS_OF_TEN[difference]) {
+            return right > 0 ? -1 : 1;
+        }
+
+        right *= POWERS_OF_TEN[difference];
+    } else if (difference < 0) {
+
+        if (left > std::numeric_limits<long long>::max()
+                / POWERS_OF_TEN[-difference]
+                || left < std::numeric_limits<long long>::min()
+                / POWERS_OF_TEN[-difference]) {
+            return left > 0 ? 1 : -1;
+        }
+
+        left *= POWERS_OF_TEN[-difference];
+    }
+
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+} // namespace RabidSQL
@@ -49,19 +49,38 @@ FileStream &JsonFileStream::operator<<(const Variant &value)
     switch (value.type) {
         case D_STRING:
         {
-            writer->String(value.toString().c_str());
+            size_t length;
+            auto data = value.asString(&length);
+            writer->String(data, static_cast<rapidjson::SizeType>(length));
             break;
         }
         case D_STRINGVECTOR:
+        {
+            writer->StartArray();
+
+            auto &data = *value.asStringVector();
+
+            rapidjson::SizeType count = 0;
+
+            for (auto it = data.begin(); it != data.end(); ++it) {
+
+                // Write element
+                writer->String(it->data(),
+                               static_cast<rapidjson::SizeType>(it->size()));
+                count++;
+            }
+
+            writer->EndArray(count);
+
+            break;
+        }
         case D_VARIANTVECTOR:
         {
             writer->StartArray();
 
-            // Use variant vector for both string and variant since they will
-            // be stored the same
-            auto data = value.toVariantVector();
+            auto &data = *value.asVariantVector();
 
-            __darwin_size_t count = 0;
+            rapidjson::SizeType count = 0;
 
             for (auto it = data.begin(); it != data.end(); ++it) {
 
@@ -79,14 +98,41 @@ FileStream &JsonFileStream::operator<<(const Variant &value)
 
             writer->StartObject();
 
-            auto map(value.toVariantMap());
+            auto &map = *value.asVariantMap();
+
+            rapidjson::SizeType count = 0;
+
+            for (auto it = map.cbegin(); it != map.cend(); ++it) {
+
+                // Write key
+                writer->String(it->first.data(),
+                               static_cast<rapidjson::SizeType>(
+                                   it->first.size()));
+
+                // Write value
+                *this << it->second;
+                count++;
+            }
+
+            writer->EndObject(count);
+
+            break;
+        }
+        case D_VARIANTHASHMAP:
+        {
+            // JSON keys are always strings. Reading back yields a VariantMap.
+            writer->StartObject();
+
+            auto &map = *value.asVariantHashMap();
 
-            __darwin_size_t count = 0;
+            rapidjson::SizeType count = 0;
 
             for (auto it = map.cbegin(); it != map.cend(); ++it) {
 
-                // Write key. Convert to string
-                writer->String(it->first.c_str());
+                // Write key
+                auto key = it->first.toString();
+                writer->String(key.data(),
+                               static_cast<rapidjson::SizeType>(key.size()));
 
                 // Write value
                 *this << it->second;
@@ -106,9 +152,21 @@ FileStream &JsonFileStream::operator<<(const Variant &value)
         case D_LONG:
         case D_LONGLONG:
         case D_ULONG:
-        case D_ULONGLONG:
             writer->Int64(value.toLongLong());
             break;
+        case D_ULONGLONG:
+            writer->Uint64(value.toULongLong());
+            break;
+        case D_DATETIME:
+        case D_DECIMAL:
+        case D_BLOB:
+        {
+            // No native JSON representation. Store as text.
+            auto data = value.toString();
+            writer->String(data.data(),
+                           static_cast<rapidjson::SizeType>(data.size()));
+            break;
+        }
         case D_BOOLEAN:
             writer->Bool(value.toBool());
             break;
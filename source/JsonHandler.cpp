@@ -22,10 +22,10 @@ bool JsonHandler::set(Variant data) {
         case PRIMITIVE:
 
             // Root is a primitive
-            *stack.top()->primitive() = data;
+            *stack.top()->primitive() = std::move(data);
             break;
         case ARRAY:
-            stack.top()->array()->push_back(data);
+            stack.top()->array()->push_back(std::move(data));
             break;
         case OBJECT:
             if (keys.empty()) {
@@ -34,7 +34,7 @@ bool JsonHandler::set(Variant data) {
                 return false;
             }
 
-            (*top->object())[keys.top()] = data;
+            (*top->object())[keys.top()] = std::move(data);
             keys.pop();
             break;
     }
@@ -58,10 +58,10 @@ Variant JsonHandler::get()
             value = *root->primitive();
             break;
         case JsonHandler::ARRAY:
-            value = *root->array();
+            value = std::move(*root->array());
             break;
         case JsonHandler::OBJECT:
-            value = *root->object();
+            value = std::move(*root->object());
             break;
     }
 
@@ -235,7 +235,7 @@ bool JsonHandler::EndObject(unsigned int memberCount)
             // This is an impossible case. Mark as a parsing error
             return false;
         case ARRAY:
-            top->array()->push_back(*object);
+            top->array()->push_back(std::move(*object));
             break;
         case OBJECT:
             if (keys.empty()) {
@@ -243,7 +243,7 @@ bool JsonHandler::EndObject(unsigned int memberCount)
                 // Empty key
                 return false;
             }
-            (*top->object())[keys.top()] = *object;
+            (*top->object())[keys.top()] = std::move(*object);
             keys.pop();
             break;
     }
@@ -308,7 +308,7 @@ bool JsonHandler::EndArray(unsigned int elementCount)
             // This is an impossible case. Mark as a parsing error
             return false;
         case ARRAY:
-            top->array()->push_back(*array);
+            top->array()->push_back(std::move(*array));
             break;
         case OBJECT:
             if (keys.empty()) {
@@ -316,7 +316,7 @@ bool JsonHandler::EndArray(unsigned int elementCount)
                 // Empty key
                 return false;
             }
-            (*top->object())[keys.top()] = *array;
+            (*top->object())[keys.top()] = std::move(*array);
             keys.pop();
             break;
     }
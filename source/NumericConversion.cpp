@@ -0,0 +1,534 @@
+#include "App.h"
+#include "NumericConversion.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace RabidSQL {
+
+// Powers of ten that are exactly representable as doubles
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+    1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POWER = 22;
+
+// The number of significant digits std::ostream uses by default
+static const int PRECISION = 6;
+
+/**
+ *
+ * Writes the decimal representation of value to buffer. The buffer must hold
+ * at least BUFFER_SIZE characters. The result is not null-terminated.
+ *
+ * @param buffer The buffer to write to
+ * @param value The value to format
+ * @return The number of characters written
+ */
+size_t NumericConversion::formatInteger(char *buffer, long long value)
+{
+    if (value < 0) {
+
+        buffer[0] = '-';
+
+        // Negate as unsigned so that the minimum value doesn't overflow
+        return formatUnsigned(buffer + 1,
+                              0 - static_cast<unsigned long long>(value)) + 1;
+    }
+
+    return formatUnsigned(buffer, static_cast<unsigned long long>(value));
+}
+
+/**
+ *
+ * Writes the decimal representation of value to buffer. The buffer must hold
+ * at least BUFFER_SIZE characters. The result is not null-terminated.
+ *
+ * @param buffer The buffer to write to
+ * @param value The value to format
+ * @return The number of characters written
+ */
+size_t NumericConversion::formatUnsigned(char *buffer,
+                                         unsigned long long value)
+{
+    char digits[BUFFER_SIZE];
+    size_t count = 0;
+
+    // Produce digits in reverse
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (size_t i = 0; i < count; i++) {
+        buffer[i] = digits[count - i - 1];
+    }
+
+    return count;
+}
+
+/**
+ *
+ * Writes value to buffer the way std::ostream does by default (%g with six
+ * significant digits). The buffer must hold at least BUFFER_SIZE characters.
+ * The result is not null-terminated.
+ *
+ * Most values are formatted by scaling into a six digit integer. Values where
+ * that could round differently from an exact conversion (ties, very large or
+ * small exponents, inf and nan) go through snprintf, which doesn't allocate
+ * either.
+ *
+ * @param buffer The buffer to write to
+ * @param value The value to format
+ * @return The number of characters written
+ */
+size_t NumericConversion::formatDouble(char *buffer, double value)
+{
+    size_t length = 0;
+    double magnitude = std::fabs(value);
+
+    if (value == 0) {
+
+        if (std::signbit(value)) {
+            buffer[length++] = '-';
+        }
+        buffer[length++] = '0';
+
+        return length;
+    }
+
+    int exponent = 0;
+    double scaled = 0;
+    bool exact = std::isfinite(value);
+
+    if (exact) {
+
+        exponent = static_cast<int>(std::floor(std::log10(magnitude)));
+
+        // log10 may be off by one right at powers of ten. Correct using the
+        // scaled value.
+        for (int attempt = 0; attempt < 2 && exact; attempt++) {
+            int power = PRECISION - 1 - exponent;
+
+            if (power > MAX_EXACT_POWER || power < -MAX_EXACT_POWER) {
+                exact = false;
+                break;
+            }
+
+            scaled = power >= 0 ? magnitude * POWERS_OF_TEN[power]
+                                : magnitude / POWERS_OF_TEN[-power];
+
+            if (scaled >= 1000000) {
+                exponent++;
+            } else if (scaled < 100000) {
+                exponent--;
+            } else {
+                break;
+            }
+        }
+    }
+
+    unsigned long mantissa = 0;
+
+    if (exact && scaled >= 100000 && scaled < 1000000) {
+
+        mantissa = static_cast<unsigned long>(scaled);
+        double fraction = scaled - mantissa;
+
+        if (std::fabs(fraction - 0.5) < 1e-7) {
+
+            // Too close to call. Leave it to the exact conversion.
+            exact = false;
+        } else if (fraction > 0.5) {
+
+            mantissa++;
+
+            if (mantissa == 1000000) {
+                mantissa = 100000;
+                exponent++;
+            }
+        }
+    } else {
+        exact = false;
+    }
+
+    if (!exact) {
+
+        int written = snprintf(buffer, BUFFER_SIZE, "%g", value);
+
+        return written > 0 ? static_cast<size_t>(written) : 0;
+    }
+
+    // Extract the six digits and drop trailing zeros
+    char digits[PRECISION];
+    int count = PRECISION;
+
+    for (int i = PRECISION - 1; i >= 0; i--) {
+        digits[i] = static_cast<char>('0' + mantissa % 10);
+        mantissa /= 10;
+    }
+
+    while (count > 1 && digits[count - 1] == '0') {
+        count--;
+    }
+
+    if (value < 0) {
+        buffer[length++] = '-';
+    }
+
+    if (exponent < -4 || exponent >= PRECISION) {
+
+        // Scientific notation, e.g. 1.5e+07
+        buffer[length++] = digits[0];
+
+        if (count > 1) {
+            buffer[length++] = '.';
+            memcpy(buffer + length, digits + 1, count - 1);
+            length += count - 1;
+        }
+
+        buffer[length++] = 'e';
+        buffer[length++] = exponent < 0 ? '-' : '+';
+
+        int absolute = exponent < 0 ? -exponent : exponent;
+
+        if (absolute < 10) {
+            buffer[length++] = '0';
+        }
+
+        length += formatUnsigned(buffer + length,
+                                 static_cast<unsigned long long>(absolute));
+    } else if (exponent >= 0) {
+
+        // Fixed notation with an integer part
+        for (int i = 0; i <= exponent; i++) {
+            buffer[length++] = i < count ? digits[i] : '0';
+        }
+
+        if (count > exponent + 1) {
+            buffer[length++] = '.';
+            memcpy(buffer + length, digits + exponent + 1,
+                   count - exponent - 1);
+            length += count - exponent - 1;
+        }
+    } else {
+
+        // Fixed notation below one, e.g. 0.00125
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+
+        for (int i = -1; i > exponent; i--) {
+            buffer[length++] = '0';
+        }
+
+        memcpy(buffer + length, digits, count);
+        length += count;
+    }
+
+    return length;
+}
+
+/**
+ *
+ * Returns the position of the first non-whitespace character in string
+ *
+ * @param string The string to scan
+ * @param length The number of characters in string
+ * @return size_t
+ */
+size_t NumericConversion::skipSpace(const char *string, size_t length)
+{
+    size_t position = 0;
+
+    while (position < length && (string[position] == ' '
+                                 || (string[position] >= '\t'
+                                     && string[position] <= '\r'))) {
+        position++;
+    }
+
+    return position;
+}
+
+/**
+ *
+ * Reads a run of decimal digits starting at position and advances position
+ * past them
+ *
+ * @param string The characters to parse
+ * @param length The number of characters in string
+ * @param position The position to start at. Receives the end of the digits.
+ * @param value Receives the digits' value, clamped to the range of unsigned
+ *              long long
+ * @return True if at least one digit was read
+ */
+bool NumericConversion::readDigits(const char *string, size_t length,
+                                   size_t &position, unsigned long long &value)
+{
+    const unsigned long long maximum =
+            std::numeric_limits<unsigned long long>::max();
+    size_t start = position;
+    value = 0;
+
+    while (position < length && string[position] >= '0'
+           && string[position] <= '9') {
+
+        unsigned digit = string[position] - '0';
+
+        if (value > (maximum - digit) / 10) {
+            value = maximum;
+        } else {
+            value = value * 10 + digit;
+        }
+
+        position++;
+    }
+
+    return position != start;
+}
+
+/**
+ *
+ * Parses a signed integer from the start of string. Values outside the range
+ * of long long are clamped.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @param value Receives the parsed value, or 0 on failure
+ * @return True if at least one digit was read
+ */
+bool NumericConversion::parseInteger(const char *string, size_t length,
+                                     long long &value)
+{
+    size_t position = skipSpace(string, length);
+    bool negative = false;
+    unsigned long long magnitude;
+
+    if (position < length && (string[position] == '-'
+                              || string[position] == '+')) {
+        negative = string[position] == '-';
+        position++;
+    }
+
+    if (!readDigits(string, length, position, magnitude)) {
+        value = 0;
+
+        return false;
+    }
+
+    const unsigned long long limit = static_cast<unsigned long long>(
+                std::numeric_limits<long long>::max());
+
+    if (negative) {
+
+        value = magnitude > limit ? std::numeric_limits<long long>::min()
+                                  : -static_cast<long long>(magnitude);
+    } else {
+
+        value = magnitude > limit ? std::numeric_limits<long long>::max()
+                                  : static_cast<long long>(magnitude);
+    }
+
+    return true;
+}
+
+/**
+ *
+ * Parses an unsigned integer from the start of string. As with std::istream, a
+ * leading minus sign negates the value modulo 2^64. Values that don't fit are
+ * clamped.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @param value Receives the parsed value, or 0 on failure
+ * @return True if at least one digit was read
+ */
+bool NumericConversion::parseUnsigned(const char *string, size_t length,
+                                      unsigned long long &value)
+{
+    size_t position = skipSpace(string, length);
+    bool negative = false;
+
+    if (position < length && (string[position] == '-'
+                              || string[position] == '+')) {
+        negative = string[position] == '-';
+        position++;
+    }
+
+    if (!readDigits(string, length, position, value)) {
+        value = 0;
+
+        return false;
+    }
+
+    if (negative && value != std::numeric_limits<unsigned long long>::max()) {
+        value = 0 - value;
+    }
+
+    return true;
+}
+
+/**
+ *
+ * Parses a floating point number from the start of string. Numbers with up to
+ * 15 significant digits and a small exponent are converted exactly with plain
+ * arithmetic; anything else falls back to strtod.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @param value Receives the parsed value, or 0 on failure
+ * @param end If not null, receives the number of characters consumed
+ * @return True if a number was read
+ */
+bool NumericConversion::parseDouble(const char *string, size_t length,
+                                    double &value, size_t *end)
+{
+    size_t position = skipSpace(string, length);
+    size_t start = position;
+    bool negative = false;
+
+    if (position < length && (string[position] == '-'
+                              || string[position] == '+')) {
+        negative = string[position] == '-';
+        position++;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int significant = 0;
+    int exponent = 0;
+
+    // Integer part
+    while (position < length && string[position] >= '0'
+           && string[position] <= '9') {
+
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (string[position] - '0');
+            if (mantissa != 0) {
+                significant++;
+            }
+        } else {
+            exponent++;
+            significant++;
+        }
+
+        digits++;
+        position++;
+    }
+
+    // Fraction
+    if (position < length && string[position] == '.') {
+        position++;
+
+        while (position < length && string[position] >= '0'
+               && string[position] <= '9') {
+
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (string[position] - '0');
+                if (mantissa != 0) {
+                    significant++;
+                }
+                exponent--;
+            } else {
+                significant++;
+            }
+
+            digits++;
+            position++;
+        }
+    }
+
+    if (end != nullptr) {
+        *end = 0;
+    }
+
+    if (digits == 0) {
+
+        // Not a number
+        value = 0;
+
+        return false;
+    }
+
+    // Exponent. As with std::istream, an exponent marker without digits makes
+    // the whole number invalid.
+    if (position < length && (string[position] == 'e'
+                              || string[position] == 'E')) {
+
+        size_t exponentPosition = position + 1;
+        bool exponentNegative = false;
+
+        if (exponentPosition < length && (string[exponentPosition] == '-'
+                                          || string[exponentPosition] == '+')) {
+            exponentNegative = string[exponentPosition] == '-';
+            exponentPosition++;
+        }
+
+        if (exponentPosition < length && string[exponentPosition] >= '0'
+                && string[exponentPosition] <= '9') {
+
+            int explicitExponent = 0;
+
+            while (exponentPosition < length
+                   && string[exponentPosition] >= '0'
+                   && string[exponentPosition] <= '9') {
+
+                if (explicitExponent < 100000) {
+                    explicitExponent = explicitExponent * 10
+                            + (string[exponentPosition] - '0');
+                }
+                exponentPosition++;
+            }
+
+            exponent += exponentNegative ? -explicitExponent
+                                         : explicitExponent;
+            position = exponentPosition;
+        } else {
+            value = 0;
+
+            return false;
+        }
+    }
+
+    if (end != nullptr) {
+        *end = position;
+    }
+
+    if (significant <= 15 && exponent >= -MAX_EXACT_POWER
+            && exponent <= MAX_EXACT_POWER) {
+
+        // Both the mantissa and the power of ten are exact, so a single
+        // multiplication or division is correctly rounded
+        value = static_cast<double>(mantissa);
+        value = exponent >= 0 ? value * POWERS_OF_TEN[exponent]
+                              : value / POWERS_OF_TEN[-exponent];
+
+        if (negative) {
+            value = -value;
+        }
+
+        return true;
+    }
+
+    // Hand the validated number over to strtod. Copy it so that it is
+    // null-terminated.
+    size_t size = position - start;
+    char buffer[64];
+
+    if (size < sizeof(buffer)) {
+
+        memcpy(buffer, string + start, size);
+        buffer[size] = 0;
+        value = strtod(buffer, nullptr);
+    } else {
+
+        value = strtod(std::string(string + start, size).c_str(), nullptr);
+    }
+
+    return true;
+}
+
+} // namespace RabidSQL
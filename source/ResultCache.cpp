@@ -0,0 +1,800 @@
+#include "App.h"
+#include "ResultCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+
+namespace RabidSQL {
+
+// Functions whose results change between calls or depend on the session
+static const std::set<std::string> VOLATILE_FUNCTIONS = {
+    "connection_id", "curdate", "current_date", "current_time",
+    "current_timestamp", "current_user", "curtime", "found_rows",
+    "get_lock", "is_free_lock", "is_used_lock", "last_insert_id",
+    "localtime", "localtimestamp", "now", "rand", "release_lock",
+    "row_count", "sleep", "sysdate", "unix_timestamp", "utc_date",
+    "utc_time", "utc_timestamp", "uuid", "uuid_short"
+};
+
+// Functions that can also be called without parentheses
+static const std::set<std::string> VOLATILE_KEYWORDS = {
+    "current_date", "current_time", "current_timestamp", "current_user",
+    "localtime", "localtimestamp", "utc_date", "utc_time", "utc_timestamp"
+};
+
+// SHOW statements that report server or session state rather than schema
+static const std::set<std::string> VOLATILE_SHOWS = {
+    "binary", "engine", "errors", "global", "master", "processlist",
+    "profile", "profiles", "replica", "session", "slave", "status",
+    "variables", "warnings"
+};
+
+// Words that end a table list rather than name an alias
+static const std::set<std::string> CLAUSE_WORDS = {
+    "cross", "except", "for", "force", "from", "group", "having", "ignore",
+    "inner", "intersect", "join", "left", "limit", "lock", "natural", "on",
+    "order", "outer", "partition", "procedure", "right", "set",
+    "straight_join", "union", "use", "using", "values", "where", "window",
+    "with"
+};
+
+// Schemas describing the server's own metadata
+static const std::set<std::string> METADATA_SCHEMAS = {
+    "information_schema", "mysql", "performance_schema", "sys"
+};
+
+/**
+ *
+ * Returns true if c can be part of an unquoted word
+ *
+ * @param c The character
+ * @return bool
+ */
+static bool isWordCharacter(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$'
+            || (c & 0x80) != 0;
+}
+
+/**
+ *
+ * Splits sql into lower-cased words and single punctuation characters.
+ * Whitespace and comments are skipped and each quoted string becomes a "'"
+ * token. Backquotes are removed, and dotted names are kept as one word. Table
+ * names are compared without case, which at worst drops extra results.
+ *
+ * @param sql The statement to split
+ * @return The tokens
+ */
+static std::vector<std::string> tokenize(const std::string &sql)
+{
+    std::vector<std::string> tokens;
+    size_t length = sql.size();
+    size_t i = 0;
+
+    while (i < length) {
+        char c = sql[i];
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if (c == '#' || (c == '-' && i + 2 < length
+                                && sql[i + 1] == '-'
+                                && std::isspace(
+                                    static_cast<unsigned char>(sql[i + 2])))) {
+            i = sql.find('\n', i);
+            i = i == std::string::npos ? length : i;
+        } else if (c == '/' && i + 1 < length && sql[i + 1] == '*') {
+            i = sql.find("*/", i + 2);
+            i = i == std::string::npos ? length : i + 2;
+        } else if (c == '\'' || c == '"') {
+
+            // String literal. Quotes are escaped by doubling or a backslash.
+            for (i++; i < length && sql[i] != c; i++) {
+
+                if (sql[i] == '\\') {
+                    i++;
+                }
+            }
+
+            i++;
+            tokens.push_back("'");
+        } else if (c == '`' || isWordCharacter(c)) {
+            std::string word;
+
+            while (i < length) {
+
+                if (sql[i] == '`') {
+                    size_t end = sql.find('`', i + 1);
+                    end = end == std::string::npos ? length : end;
+
+                    for (i++; i < end; i++) {
+                        word += static_cast<char>(
+                            std::tolower(static_cast<unsigned char>(sql[i])));
+                    }
+
+                    i++;
+                } else if (isWordCharacter(sql[i])) {
+                    word += static_cast<char>(
+                        std::tolower(static_cast<unsigned char>(sql[i++])));
+                } else if (sql[i] == '.' && i + 1 < length
+                           && (sql[i + 1] == '`'
+                               || isWordCharacter(sql[i + 1]))) {
+                    word += sql[i++];
+                } else {
+                    break;
+                }
+            }
+
+            tokens.push_back(word);
+        } else {
+            tokens.push_back(std::string(1, c));
+            i++;
+        }
+    }
+
+    return tokens;
+}
+
+/**
+ *
+ * Returns true if token is a word rather than punctuation or a string
+ *
+ * @param token The token
+ * @return bool
+ */
+static bool isWord(const std::string &token)
+{
+    return !token.empty() && (token.size() > 1 || isWordCharacter(token[0]));
+}
+
+/**
+ *
+ * Adds the table named by a possibly qualified name to statement. Names in
+ * the server's metadata schemas mark the statement as reading metadata.
+ *
+ * @param name The table name
+ * @param statement The statement to add to
+ * @return void
+ */
+static void addTable(const std::string &name, ResultCache::Statement &statement)
+{
+    size_t dot = name.rfind('.');
+
+    if (dot != std::string::npos) {
+        size_t schemaDot = name.rfind('.', dot - 1);
+        size_t schemaStart = schemaDot == std::string::npos ? 0 : schemaDot + 1;
+
+        if (METADATA_SCHEMAS.count(name.substr(schemaStart,
+                                               dot - schemaStart))) {
+            statement.metadata = true;
+        }
+    }
+
+    statement.tables.push_back(
+        dot == std::string::npos ? name : name.substr(dot + 1));
+}
+
+/**
+ *
+ * Reads a comma-separated list of tables, each with an optional alias
+ *
+ * @param tokens The statement's tokens
+ * @param position The first token of the list. Advanced past it.
+ * @param statement The statement to add the tables to
+ * @return void
+ */
+static void readTableList(const std::vector<std::string> &tokens,
+                          size_t &position, ResultCache::Statement &statement)
+{
+    while (position < tokens.size() && isWord(tokens[position])
+           && !CLAUSE_WORDS.count(tokens[position])) {
+
+        if (tokens[position] != "dual") {
+            addTable(tokens[position], statement);
+        }
+
+        position++;
+
+        if (position < tokens.size() && tokens[position] == "as") {
+            position += 2;
+        } else if (position < tokens.size() && isWord(tokens[position])
+                   && !CLAUSE_WORDS.count(tokens[position])) {
+            position++;
+        }
+
+        if (position >= tokens.size() || tokens[position] != ",") {
+            break;
+        }
+
+        position++;
+    }
+}
+
+/**
+ *
+ * Adds every table following FROM or JOIN in tokens, starting at position
+ *
+ * @param tokens The statement's tokens
+ * @param position The first token to look at
+ * @param statement The statement to add the tables to
+ * @return void
+ */
+static void readSourceTables(const std::vector<std::string> &tokens,
+                             size_t position, ResultCache::Statement &statement)
+{
+    while (position < tokens.size()) {
+
+        if (tokens[position] == "from" || tokens[position] == "join"
+                || tokens[position] == "straight_join") {
+            readTableList(tokens, ++position, statement);
+        } else {
+            position++;
+        }
+    }
+}
+
+/**
+ *
+ * Initializes a disabled cache
+ *
+ */
+ResultCache::ResultCache() :
+    memoryLimit(0),
+    usedBytes(0),
+    ttl(0),
+    invalidations(0)
+{
+}
+
+/**
+ *
+ * Enables the cache, or disables it if memoryLimit is 0. Entries are evicted
+ * as needed to fit the new limit.
+ *
+ * @param memoryLimit The most memory cached results may use, in bytes
+ * @param ttl How long results are kept, in milliseconds, unless a query's
+ * "cache_ttl" option says otherwise. It bounds how long a result changed by a
+ * write invalidate() can't see stays cached.
+ * @return void
+ */
+void ResultCache::setLimits(size_t memoryLimit, unsigned int ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    this->memoryLimit = memoryLimit;
+    this->ttl = ttl;
+
+    while (usedBytes > memoryLimit) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+/**
+ *
+ * Returns true if a memory limit has been set
+ *
+ * @return bool
+ */
+bool ResultCache::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return memoryLimit > 0;
+}
+
+/**
+ *
+ * Returns the key a command's result is cached under, or an empty string if
+ * it can't be cached. Only LIST_DATABASES, LIST_TABLES and read-only
+ * EXECUTE_QUERY commands are cached, and a query whose trailing options map
+ * sets "cache_ttl" to 0 is not.
+ *
+ * @param event The command's event
+ * @param arguments The command's arguments
+ * @param database The connection's current database
+ * @return std::string
+ */
+std::string ResultCache::makeKey(QueryEvent event,
+                                 const VariantVector &arguments,
+                                 const std::string &database) const
+{
+    size_t count = arguments.size();
+    std::string key;
+
+    if (!isEnabled() || count == 0) {
+        return key;
+    }
+
+    if (count > 1 && arguments.back().getType() == D_VARIANTMAP) {
+        VariantMap options = arguments.back().toVariantMap();
+        auto it = options.find("cache_ttl");
+
+        if (it != options.end() && it->second.toUInt() == 0) {
+            return key;
+        }
+
+        count--;
+    }
+
+    switch (event) {
+    case LIST_DATABASES:
+        key = "databases";
+
+        for (auto &name : arguments.front().toStringVector()) {
+            key += '\n' + std::to_string(name.size()) + ':' + name;
+        }
+        break;
+    case LIST_TABLES:
+        key = "tables\n" + arguments.front().toString();
+        break;
+    case EXECUTE_QUERY:
+    {
+        std::string sql = arguments.front().toString();
+
+        if (!parse(sql).cacheable) {
+            break;
+        }
+
+        key = "query\n" + database + '\n' + normalize(sql);
+
+        // Bound parameters. Drivers bind them as their own types, so null
+        // and "", or 1 and "1", are different queries.
+        for (size_t i = 1; i < count; i++) {
+            std::string value = arguments[i].toString();
+            key += '\n' + std::to_string(arguments[i].getType()) + ':'
+                   + std::to_string(value.size()) + ':' + value;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return key;
+}
+
+/**
+ *
+ * Returns a counter that changes whenever results may have been invalidated.
+ * Take it before running a command and pass it to insert(), so that a write
+ * that finishes while the command runs keeps its result out of the cache.
+ *
+ * @return unsigned long long
+ */
+unsigned long long ResultCache::generation() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return invalidations;
+}
+
+/**
+ *
+ * Looks up a cached result
+ *
+ * @param key The key from makeKey()
+ * @param result Receives a copy of the result
+ * @return True if an unexpired result was found
+ */
+bool ResultCache::find(const std::string &key, QueryResult &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+
+    if (it == index.end()) {
+        return false;
+    }
+
+    if (Clock::now() >= it->second->expiry) {
+        erase(it->second);
+
+        return false;
+    }
+
+    // Most recently used
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->result;
+
+    return true;
+}
+
+/**
+ *
+ * Caches a command's result. Errors, results too large for the memory limit
+ * and results invalidated since generation was taken are not cached. Least
+ * recently used entries are evicted to make room.
+ *
+ * @param key The key from makeKey()
+ * @param event The command's event
+ * @param arguments The command's arguments
+ * @param result The command's result
+ * @param generation The value of generation() before the command ran
+ * @return void
+ */
+void ResultCache::insert(const std::string &key, QueryEvent event,
+                         const VariantVector &arguments,
+                         const QueryResult &result,
+                         unsigned long long generation)
+{
+    unsigned int entryTtl;
+    Entry entry;
+
+    if (key.empty() || result.error.isError) {
+        return;
+    }
+
+    if (event == EXECUTE_QUERY) {
+        Statement statement = parse(arguments.front().toString());
+        entry.tables = std::move(statement.tables);
+        entry.metadata = statement.metadata;
+    } else {
+        entry.metadata = true;
+    }
+
+    entry.bytes = sizeof(Entry) + key.size() * 2 + result.rows.memoryUsage()
+            + entry.tables.size() * sizeof(std::string)
+            + result.columnInfo.size() * sizeof(ColumnInfo);
+
+    for (auto &name : result.columns) {
+        entry.bytes += sizeof(std::string) + name.size();
+    }
+
+    for (auto &stats : result.columnStats) {
+        entry.bytes += stats.memoryUsage();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    entryTtl = ttl;
+
+    if (arguments.size() > 1 && arguments.back().getType() == D_VARIANTMAP) {
+        VariantMap options = arguments.back().toVariantMap();
+        auto it = options.find("cache_ttl");
+
+        if (it != options.end()) {
+            entryTtl = it->second.toUInt();
+        }
+    }
+
+    if (generation != invalidations || entry.bytes > memoryLimit
+            || entryTtl == 0) {
+        return;
+    }
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        erase(it->second);
+    }
+
+    while (usedBytes + entry.bytes > memoryLimit) {
+        erase(std::prev(entries.end()));
+    }
+
+    entry.key = key;
+    entry.result = result;
+    entry.expiry = Clock::now() + std::chrono::milliseconds(entryTtl);
+    usedBytes += entry.bytes;
+    entries.push_front(std::move(entry));
+    index[key] = entries.begin();
+}
+
+/**
+ *
+ * Drops the results a statement may have changed. Reads and session
+ * statements change nothing. Writes drop the results of the tables they touch
+ * and schema changes also drop metadata; either drops everything if the
+ * tables can't be told. Any other statement drops everything.
+ *
+ * @param sql The statement
+ * @return void
+ */
+void ResultCache::invalidate(const std::string &sql)
+{
+    Statement statement = parse(sql);
+
+    if (statement.type == READ || statement.type == SESSION) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    invalidations++;
+
+    if (statement.type == OTHER || statement.tables.empty()) {
+        entries.clear();
+        index.clear();
+        usedBytes = 0;
+
+        return;
+    }
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        auto next = std::next(it);
+        bool stale = statement.type == SCHEMA && it->metadata;
+
+        for (size_t i = 0; i < it->tables.size() && !stale; i++) {
+            stale = std::find(statement.tables.begin(), statement.tables.end(),
+                              it->tables[i]) != statement.tables.end();
+        }
+
+        if (stale) {
+            erase(it);
+        }
+
+        it = next;
+    }
+}
+
+/**
+ *
+ * Drops every cached result
+ *
+ * @return void
+ */
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    invalidations++;
+    entries.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+/**
+ *
+ * Returns the number of cached results, including any that have expired but
+ * not yet been dropped
+ *
+ * @return size_t
+ */
+size_t ResultCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return entries.size();
+}
+
+/**
+ *
+ * Returns the estimated memory used by cached results, in bytes
+ *
+ * @return size_t
+ */
+size_t ResultCache::memoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return usedBytes;
+}
+
+/**
+ *
+ * Collapses each run of whitespace outside quotes into a single space, and
+ * drops leading and trailing whitespace and semicolons
+ *
+ * @param sql The statement to normalize
+ * @return std::string
+ */
+std::string ResultCache::normalize(const std::string &sql)
+{
+    std::string normalized;
+    char quote = 0;
+    bool space = false;
+
+    normalized.reserve(sql.size());
+
+    for (size_t i = 0; i < sql.size(); i++) {
+        char c = sql[i];
+
+        if (quote != 0) {
+            normalized += c;
+
+            if (c == '\\' && quote != '`' && i + 1 < sql.size()) {
+                normalized += sql[++i];
+            } else if (c == quote) {
+                quote = 0;
+            }
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !normalized.empty();
+        } else {
+
+            if (space) {
+                normalized += ' ';
+                space = false;
+            }
+
+            if (c == '\'' || c == '"' || c == '`') {
+                quote = c;
+            }
+
+            normalized += c;
+        }
+    }
+
+    while (!normalized.empty() && (normalized.back() == ';'
+                                   || normalized.back() == ' ')) {
+        normalized.pop_back();
+    }
+
+    return normalized;
+}
+
+/**
+ *
+ * Works out what a statement does: its type, the tables it reads or writes,
+ * whether it reads metadata, whether its result may be cached and, for USE,
+ * the database it selects. Tables are given without their database and in
+ * lower case. This is a scan of the statement's keywords rather than a full
+ * parse, so it errs towards treating statements as uncacheable writes.
+ *
+ * @param sql The statement
+ * @return Statement
+ */
+ResultCache::Statement ResultCache::parse(const std::string &sql)
+{
+    std::vector<std::string> tokens = tokenize(sql);
+    Statement statement;
+    size_t first = 0;
+
+    while (first < tokens.size() && tokens[first] == "(") {
+        first++;
+    }
+
+    if (first == tokens.size()) {
+        return statement;
+    }
+
+    const std::string &verb = tokens[first];
+    const std::string next = first + 1 < tokens.size() ? tokens[first + 1] : "";
+
+    if (verb == "select" || verb == "with") {
+        statement.type = READ;
+        statement.cacheable = true;
+
+        for (size_t i = first; i < tokens.size(); i++) {
+            const std::string &token = tokens[i];
+
+            if (token == "into" || token == "@" || token == "update"
+                    || token == "insert" || token == "delete"
+                    || (token == "lock" && i + 1 < tokens.size()
+                        && tokens[i + 1] == "in")
+                    || VOLATILE_KEYWORDS.count(token)
+                    || (VOLATILE_FUNCTIONS.count(token)
+                        && i + 1 < tokens.size() && tokens[i + 1] == "(")) {
+                statement.cacheable = false;
+            }
+        }
+
+        if (verb == "with" && !statement.cacheable) {
+
+            // Possibly a data-modifying statement
+            statement.type = OTHER;
+            return statement;
+        }
+
+        readSourceTables(tokens, first, statement);
+    } else if (verb == "show" || verb == "describe" || verb == "desc"
+               || verb == "explain") {
+        statement.type = READ;
+        statement.metadata = true;
+        statement.cacheable = verb != "show" || !(VOLATILE_SHOWS.count(next)
+                || (next == "full" && first + 2 < tokens.size()
+                    && tokens[first + 2] == "processlist"));
+
+        if (verb != "show") {
+            readSourceTables(tokens, first, statement);
+        }
+    } else if (verb == "use") {
+        statement.type = SESSION;
+        statement.database = next;
+    } else if (verb == "set" || verb == "begin" || verb == "start"
+               || verb == "rollback" || verb == "savepoint"
+               || verb == "release") {
+        statement.type = SESSION;
+    } else if (verb == "insert" || verb == "replace") {
+        size_t i = first + 1;
+
+        statement.type = WRITE;
+
+        while (i < tokens.size() && (tokens[i] == "low_priority"
+                                     || tokens[i] == "delayed"
+                                     || tokens[i] == "high_priority"
+                                     || tokens[i] == "ignore"
+                                     || tokens[i] == "into")) {
+            i++;
+        }
+
+        if (i < tokens.size() && isWord(tokens[i])) {
+            addTable(tokens[i], statement);
+        }
+    } else if (verb == "update" || verb == "delete") {
+        size_t i = first + 1;
+
+        statement.type = WRITE;
+
+        while (i < tokens.size() && (tokens[i] == "low_priority"
+                                     || tokens[i] == "quick"
+                                     || tokens[i] == "ignore")) {
+            i++;
+        }
+
+        // The updated tables, or the targets of a multiple-table delete
+        readTableList(tokens, i, statement);
+        readSourceTables(tokens, i, statement);
+    } else if (verb == "truncate" || verb == "load") {
+        statement.type = WRITE;
+
+        for (size_t i = first + 1; i < tokens.size(); i++) {
+
+            if (tokens[i] == "table" && i + 1 < tokens.size()
+                    && isWord(tokens[i + 1])) {
+                addTable(tokens[i + 1], statement);
+                break;
+            }
+        }
+
+        if (verb == "truncate" && statement.tables.empty()
+                && isWord(next)) {
+            addTable(next, statement);
+        }
+    } else if (verb == "create" || verb == "drop" || verb == "alter"
+               || verb == "rename") {
+        statement.type = SCHEMA;
+
+        for (size_t i = first + 1; i < tokens.size(); i++) {
+
+            if (tokens[i] == "database" || tokens[i] == "schema") {
+
+                // Drops or changes every table in it
+                statement.tables.clear();
+                break;
+            }
+
+            if (tokens[i] != "table" && tokens[i] != "tables"
+                    && tokens[i] != "view" && tokens[i] != "on") {
+                continue;
+            }
+
+            for (i++; i < tokens.size(); i++) {
+
+                if (tokens[i] == "if" || tokens[i] == "not"
+                        || tokens[i] == "exists" || tokens[i] == "to"
+                        || tokens[i] == ",") {
+                    continue;
+                }
+
+                if (!isWord(tokens[i])) {
+                    break;
+                }
+
+                addTable(tokens[i], statement);
+
+                if (verb != "rename" && (i + 1 >= tokens.size()
+                                         || tokens[i + 1] != ",")) {
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    return statement;
+}
+
+/**
+ *
+ * Removes an entry. The mutex must be held.
+ *
+ * @param entry The entry to remove
+ * @return void
+ */
+void ResultCache::erase(Entries::iterator entry)
+{
+    usedBytes -= entry->bytes;
+    index.erase(entry->key);
+    entries.erase(entry);
+}
+
+} // namespace RabidSQL
@@ -0,0 +1,1017 @@
+#include "App.h"
+#include "ResultColumn.h"
+#include "ResultSpillFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace RabidSQL {
+
+// The number of rows a dictionary-encoded column holds before the share of
+// distinct values is checked
+static const size_t DICTIONARY_CHECK_ROWS = 64;
+
+/**
+ *
+ * Rounds size up to a multiple of 8, the alignment of each array in a spill
+ * file
+ *
+ * @param size The size to round
+ * @return size_t
+ */
+static size_t padded(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+/**
+ *
+ * Hashes a string with FNV-1a
+ *
+ * @param value The bytes to hash
+ * @param length The number of bytes in value
+ * @return size_t
+ */
+static size_t hashBytes(const char *value, size_t length)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(value[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+/**
+ *
+ * Creates an empty column
+ *
+ */
+ResultColumn::ResultColumn() :
+    storage(S_NONE),
+    type(D_NULL),
+    count(0),
+    reservedRows(0),
+    entries(0),
+    plainBytes(0),
+    mappedNulls(nullptr),
+    mappedIntegers(nullptr),
+    mappedDoubles(nullptr),
+    mappedOffsets(nullptr),
+    mappedBytes(nullptr),
+    mappedCodes(nullptr)
+{
+}
+
+/**
+ *
+ * Appends a cell
+ *
+ * @param value The value of the cell
+ * @return void
+ */
+void ResultColumn::append(const Variant &value)
+{
+    DataType valueType = value.getType();
+
+    if (mapping) {
+        unmap();
+    }
+
+    if (valueType == D_NULL) {
+        appendNull();
+        return;
+    }
+
+    if (valueType == D_STRING || valueType == D_BLOB) {
+        size_t length;
+        auto string = valueType == D_BLOB
+                ? reinterpret_cast<const char *>(value.asBlob(&length))
+                : value.asString(&length);
+
+        appendBytes(valueType, string, length);
+        return;
+    }
+
+    prepare(valueType);
+
+    switch (storage) {
+    case S_INTEGER:
+        integerValues.push_back(toInteger(value));
+        break;
+    case S_DOUBLE:
+        doubleValues.push_back(value.toDouble());
+        break;
+    default:
+        variantValues.push_back(value);
+        break;
+    }
+
+    markRow(false);
+}
+
+/**
+ *
+ * Appends a null cell
+ *
+ * @return void
+ */
+void ResultColumn::appendNull()
+{
+    if (mapping) {
+        unmap();
+    }
+
+    switch (storage) {
+    case S_NONE:
+        break;
+    case S_INTEGER:
+        integerValues.push_back(0);
+        break;
+    case S_DOUBLE:
+        doubleValues.push_back(0);
+        break;
+    case S_STRING:
+        offsets.push_back(bytes.size());
+        break;
+    case S_VARIANT:
+        variantValues.emplace_back();
+        break;
+    case S_DICTIONARY:
+
+        // The empty string
+        codeValues.push_back(0);
+        break;
+    }
+
+    markRow(true);
+}
+
+/**
+ *
+ * Appends a string cell without creating a variant for it
+ *
+ * @param value The characters to copy
+ * @param length The number of characters in value
+ * @return void
+ */
+void ResultColumn::appendString(const char *value, size_t length)
+{
+    appendBytes(D_STRING, value, length);
+}
+
+/**
+ *
+ * Appends a blob cell without creating a variant for it
+ *
+ * @param value The bytes to copy
+ * @param length The number of bytes in value
+ * @return void
+ */
+void ResultColumn::appendBlob(const unsigned char *value, size_t length)
+{
+    appendBytes(D_BLOB, reinterpret_cast<const char *>(value), length);
+}
+
+/**
+ *
+ * Returns the cell at row as a variant of the type it was appended as
+ *
+ * @param row The row of the cell
+ * @return Variant
+ */
+Variant ResultColumn::at(size_t row) const
+{
+    if (row >= count || isNull(row)) {
+        return Variant();
+    }
+
+    switch (storage) {
+    case S_INTEGER:
+        return fromInteger(integerData()[row]);
+    case S_DOUBLE:
+        if (type == D_FLOAT) {
+            return Variant(static_cast<float>(doubleData()[row]));
+        }
+        return Variant(doubleData()[row]);
+    case S_STRING:
+    case S_DICTIONARY:
+    {
+        size_t length;
+        auto string = asString(row, &length);
+
+        if (type == D_BLOB) {
+            return Variant(reinterpret_cast<const unsigned char *>(string),
+                           length);
+        }
+        return Variant(string, length);
+    }
+    case S_VARIANT:
+        return variantValues[row];
+    default:
+        return Variant();
+    }
+}
+
+/**
+ *
+ * Returns true if the cell at row is null
+ *
+ * @param row The row of the cell
+ * @return bool
+ */
+bool ResultColumn::isNull(size_t row) const
+{
+    return (nullWords()[row / 64] >> (row % 64)) & 1;
+}
+
+/**
+ *
+ * Returns the number of cells
+ *
+ * @return size_t
+ */
+size_t ResultColumn::size() const
+{
+    return count;
+}
+
+/**
+ *
+ * Returns the type shared by every non-null cell. Columns of nothing but
+ * nulls, and columns whose cells differ in type, report D_NULL.
+ *
+ * @return DataType
+ */
+DataType ResultColumn::getType() const
+{
+    return type;
+}
+
+/**
+ *
+ * Returns the values of an integer, boolean or date column (dates packed as
+ * by DateTime::pack()), one per row. Null cells hold 0. Returns nullptr for
+ * other columns.
+ *
+ * @return const long long *
+ */
+const long long *ResultColumn::integers() const
+{
+    return storage == S_INTEGER ? integerData() : nullptr;
+}
+
+/**
+ *
+ * Returns the values of a float or double column, one per row. Null cells
+ * hold 0. Returns nullptr for other columns.
+ *
+ * @return const double *
+ */
+const double *ResultColumn::doubles() const
+{
+    return storage == S_DOUBLE ? doubleData() : nullptr;
+}
+
+/**
+ *
+ * Returns the characters of a string or blob cell without copying them. The
+ * result is not null-terminated and stays valid until the column is changed.
+ * Returns nullptr for other columns.
+ *
+ * @param row The row of the cell
+ * @param length Receives the number of characters, if given
+ * @return const char *
+ */
+const char *ResultColumn::asString(size_t row, size_t *length) const
+{
+    if ((storage != S_STRING && storage != S_DICTIONARY) || row >= count) {
+        return nullptr;
+    }
+
+    const size_t *positions = offsetData();
+    size_t index = storage == S_DICTIONARY ? codeData()[row] : row;
+
+    if (length != nullptr) {
+        *length = positions[index + 1] - positions[index];
+    }
+
+    return byteData() + positions[index];
+}
+
+/**
+ *
+ * Returns the dictionary code of each row of a dictionary-encoded column. Null
+ * cells hold the code of the empty string, 0. Returns nullptr for other
+ * columns.
+ *
+ * @return const unsigned int *
+ */
+const unsigned int *ResultColumn::codes() const
+{
+    return storage == S_DICTIONARY ? codeData() : nullptr;
+}
+
+/**
+ *
+ * Returns the number of distinct values of a dictionary-encoded column,
+ * counting the empty string, or 0 for other columns
+ *
+ * @return size_t
+ */
+size_t ResultColumn::dictionarySize() const
+{
+    return storage == S_DICTIONARY ? entries : 0;
+}
+
+/**
+ *
+ * Returns the characters of a dictionary value without copying them, in the
+ * manner of asString()
+ *
+ * @param code The code of the value
+ * @param length Receives the number of characters, if given
+ * @return The characters, or nullptr if code isn't in the dictionary
+ */
+const char *ResultColumn::dictionaryValue(size_t code, size_t *length) const
+{
+    if (storage != S_DICTIONARY || code >= entries) {
+        return nullptr;
+    }
+
+    const size_t *positions = offsetData();
+
+    if (length != nullptr) {
+        *length = positions[code + 1] - positions[code];
+    }
+
+    return byteData() + positions[code];
+}
+
+/**
+ *
+ * Reserves room for rows cells. A column with no type yet reserves once its
+ * first non-null cell is appended.
+ *
+ * @param rows The number of cells to reserve room for
+ * @return void
+ */
+void ResultColumn::reserve(size_t rows)
+{
+    reservedRows = rows;
+
+    if (mapping) {
+        return;
+    }
+    nulls.reserve((rows + 63) / 64);
+
+    switch (storage) {
+    case S_INTEGER:
+        integerValues.reserve(rows);
+        break;
+    case S_DOUBLE:
+        doubleValues.reserve(rows);
+        break;
+    case S_STRING:
+        offsets.reserve(rows + 1);
+        break;
+    case S_VARIANT:
+        variantValues.reserve(rows);
+        break;
+    case S_DICTIONARY:
+        codeValues.reserve(rows);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ *
+ * Frees what the column only needs while cells are appended to it. Appending
+ * again still works.
+ *
+ * @return void
+ */
+void ResultColumn::finish()
+{
+    std::vector<unsigned int>().swap(dictionaryIndex);
+}
+
+/**
+ *
+ * Returns the approximate number of bytes the column occupies. The heap
+ * payloads of variant columns aren't counted.
+ *
+ * @return size_t
+ */
+size_t ResultColumn::memoryUsage() const
+{
+    return sizeof(ResultColumn)
+        + nulls.capacity() * sizeof(unsigned long long)
+        + integerValues.capacity() * sizeof(long long)
+        + doubleValues.capacity() * sizeof(double)
+        + offsets.capacity() * sizeof(size_t)
+        + bytes.capacity()
+        + variantValues.capacity() * sizeof(Variant)
+        + codeValues.capacity() * sizeof(unsigned int)
+        + dictionaryIndex.capacity() * sizeof(unsigned int);
+}
+
+/**
+ *
+ * Returns how many bytes dictionary encoding saves over storing every value of
+ * the column, or 0 if the column isn't dictionary-encoded
+ *
+ * @return size_t
+ */
+size_t ResultColumn::dictionarySavings() const
+{
+    if (storage != S_DICTIONARY) {
+        return 0;
+    }
+
+    size_t plain = (count + 1) * sizeof(size_t) + plainBytes;
+    size_t encoded = count * sizeof(unsigned int)
+            + (entries + 1) * sizeof(size_t) + offsetData()[entries];
+
+    return plain > encoded ? plain - encoded : 0;
+}
+
+/**
+ *
+ * Writes the column's null bitmap and typed arrays to file, each padded to 8
+ * bytes. Variant columns write nothing and stay in memory.
+ *
+ * @param file The file to write to
+ * @return True on success
+ */
+bool ResultColumn::spill(ResultSpillFile &file) const
+{
+    if (storage == S_VARIANT || mapping) {
+        return true;
+    }
+
+    if (!file.write(nulls.data(), nulls.size() * sizeof(unsigned long long))) {
+        return false;
+    }
+
+    switch (storage) {
+    case S_INTEGER:
+        if (!file.write(integerValues.data(), count * sizeof(long long))) {
+            return false;
+        }
+        break;
+    case S_DOUBLE:
+        if (!file.write(doubleValues.data(), count * sizeof(double))) {
+            return false;
+        }
+        break;
+    case S_DICTIONARY:
+        if (!file.write(codeValues.data(), count * sizeof(unsigned int))
+                || !file.align(8)) {
+            return false;
+        }
+        // The dictionary's values follow, stored as for S_STRING
+        // fall through
+    case S_STRING:
+        if (!file.write(offsets.data(), offsets.size() * sizeof(size_t))
+                || !file.write(bytes.data(), bytes.size())) {
+            return false;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return file.align(8);
+}
+
+/**
+ *
+ * Switches the column to reading from a mapping of what spill() wrote, and
+ * frees its arrays
+ *
+ * @param mapping The mapping, kept alive for as long as the column uses it
+ * @param data Where the column's data starts within the mapping
+ * @return The number of bytes of the mapping the column uses
+ */
+size_t ResultColumn::useMapping(const std::shared_ptr<const char> &mapping,
+                                const char *data)
+{
+    if (storage == S_VARIANT || this->mapping) {
+        return 0;
+    }
+
+    const char *position = data;
+
+    mappedNulls = reinterpret_cast<const unsigned long long *>(position);
+    position += padded(nulls.size() * sizeof(unsigned long long));
+
+    switch (storage) {
+    case S_INTEGER:
+        mappedIntegers = reinterpret_cast<const long long *>(position);
+        position += padded(count * sizeof(long long));
+        break;
+    case S_DOUBLE:
+        mappedDoubles = reinterpret_cast<const double *>(position);
+        position += padded(count * sizeof(double));
+        break;
+    case S_DICTIONARY:
+        mappedCodes = reinterpret_cast<const unsigned int *>(position);
+        position += padded(count * sizeof(unsigned int));
+        // The dictionary's values follow, stored as for S_STRING
+        // fall through
+    case S_STRING:
+        mappedOffsets = reinterpret_cast<const size_t *>(position);
+        position += padded(offsets.size() * sizeof(size_t));
+        mappedBytes = position;
+        position += padded(bytes.size());
+        break;
+    default:
+        break;
+    }
+
+    this->mapping = mapping;
+
+    // Free the arrays
+    std::vector<unsigned long long>().swap(nulls);
+    std::vector<long long>().swap(integerValues);
+    std::vector<double>().swap(doubleValues);
+    std::vector<size_t>().swap(offsets);
+    std::vector<char>().swap(bytes);
+    std::vector<unsigned int>().swap(codeValues);
+    std::vector<unsigned int>().swap(dictionaryIndex);
+
+    return position - data;
+}
+
+/**
+ *
+ * Returns true if the column is read from a spill file
+ *
+ * @return bool
+ */
+bool ResultColumn::isSpilled() const
+{
+    return static_cast<bool>(mapping);
+}
+
+/**
+ *
+ * Returns how cells of type are stored
+ *
+ * @param type The type of the cells
+ * @return Storage
+ */
+ResultColumn::Storage ResultColumn::storageFor(DataType type)
+{
+    switch (type) {
+    case D_BOOLEAN:
+    case D_SHORT:
+    case D_USHORT:
+    case D_INT:
+    case D_UINT:
+    case D_LONG:
+    case D_ULONG:
+    case D_LONGLONG:
+    case D_ULONGLONG:
+    case D_DATETIME:
+        return S_INTEGER;
+    case D_FLOAT:
+    case D_DOUBLE:
+        return S_DOUBLE;
+    case D_STRING:
+        return S_DICTIONARY;
+    case D_BLOB:
+        return S_STRING;
+    default:
+        return S_VARIANT;
+    }
+}
+
+/**
+ *
+ * Readies the column for a non-null cell of type. The first such cell picks
+ * the storage, and a cell of another type turns the column into variants.
+ *
+ * @param type The type of the cell about to be appended
+ * @return void
+ */
+void ResultColumn::prepare(DataType type)
+{
+    if (storage == S_NONE) {
+
+        // Only nulls so far. Give each a placeholder.
+        storage = storageFor(type);
+        this->type = type;
+
+        switch (storage) {
+        case S_INTEGER:
+            integerValues.resize(count);
+            break;
+        case S_DOUBLE:
+            doubleValues.resize(count);
+            break;
+        case S_STRING:
+            offsets.assign(count + 1, 0);
+            break;
+        case S_DICTIONARY:
+
+            // Code 0 is the empty string, which nulls use too
+            codeValues.resize(count);
+            offsets.assign(2, 0);
+            entries = 1;
+            break;
+        default:
+            variantValues.resize(count);
+            break;
+        }
+
+        reserve(reservedRows);
+    } else if (type != this->type && this->type != D_NULL) {
+        convertToVariants();
+    }
+}
+
+/**
+ *
+ * Appends a string or blob cell
+ *
+ * @param type D_STRING or D_BLOB
+ * @param value The bytes to copy
+ * @param length The number of bytes in value
+ * @return void
+ */
+void ResultColumn::appendBytes(DataType type, const char *value,
+                               size_t length)
+{
+    if (mapping) {
+        unmap();
+    }
+
+    prepare(type);
+
+    if (storage == S_DICTIONARY) {
+        codeValues.push_back(encode(value, length));
+        plainBytes += length;
+    } else if (storage == S_STRING) {
+        bytes.insert(bytes.end(), value, value + length);
+        offsets.push_back(bytes.size());
+    } else if (type == D_BLOB) {
+        variantValues.emplace_back(
+                reinterpret_cast<const unsigned char *>(value), length);
+    } else {
+        variantValues.emplace_back(value, length);
+    }
+
+    markRow(false);
+
+    if (storage == S_DICTIONARY && count >= DICTIONARY_CHECK_ROWS
+            && entries * 2 > count) {
+
+        // Too many distinct values for the dictionary to pay off
+        convertToStrings();
+    }
+}
+
+/**
+ *
+ * Returns the dictionary code of a string, adding it to the dictionary if it
+ * isn't there yet
+ *
+ * @param value The characters of the string
+ * @param length The number of characters in value
+ * @return unsigned int
+ */
+unsigned int ResultColumn::encode(const char *value, size_t length)
+{
+    if (dictionaryIndex.empty()) {
+        rebuildIndex();
+    }
+
+    size_t hash = hashBytes(value, length);
+    size_t mask = dictionaryIndex.size() - 1;
+
+    for (size_t slot = hash & mask; dictionaryIndex[slot] != 0;
+         slot = (slot + 1) & mask) {
+        unsigned int code = dictionaryIndex[slot] - 1;
+
+        if (offsets[code + 1] - offsets[code] == length
+                && (length == 0 || std::memcmp(bytes.data() + offsets[code],
+                                               value, length) == 0)) {
+            return code;
+        }
+    }
+
+    unsigned int code = static_cast<unsigned int>(entries++);
+    bytes.insert(bytes.end(), value, value + length);
+    offsets.push_back(bytes.size());
+    indexCode(code, hash);
+
+    return code;
+}
+
+/**
+ *
+ * Adds a dictionary code to the index, growing the index once it is half full
+ *
+ * @param code The code
+ * @param hash The hash of the code's value
+ * @return void
+ */
+void ResultColumn::indexCode(unsigned int code, size_t hash)
+{
+    if (entries * 2 > dictionaryIndex.size()) {
+        rebuildIndex();
+        return;
+    }
+
+    size_t mask = dictionaryIndex.size() - 1;
+    size_t slot = hash & mask;
+
+    while (dictionaryIndex[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    dictionaryIndex[slot] = code + 1;
+}
+
+/**
+ *
+ * Builds the index used to look up dictionary values, with room for the
+ * dictionary to double. Slots hold codes plus one; 0 marks an empty slot.
+ *
+ * @return void
+ */
+void ResultColumn::rebuildIndex()
+{
+    size_t size = 16;
+
+    while (size < entries * 4) {
+        size *= 2;
+    }
+
+    dictionaryIndex.assign(size, 0);
+
+    for (unsigned int code = 0; code < entries; code++) {
+        size_t slot = hashBytes(bytes.data() + offsets[code],
+                                offsets[code + 1] - offsets[code]);
+
+        for (slot &= size - 1; dictionaryIndex[slot] != 0;
+             slot = (slot + 1) & (size - 1)) {
+        }
+
+        dictionaryIndex[slot] = code + 1;
+    }
+}
+
+/**
+ *
+ * Stores every value of a dictionary-encoded column in full
+ *
+ * @return void
+ */
+void ResultColumn::convertToStrings()
+{
+    std::vector<size_t> positions;
+    std::vector<char> values;
+
+    positions.reserve(std::max(count, reservedRows) + 1);
+    values.reserve(plainBytes);
+    positions.push_back(0);
+
+    for (size_t row = 0; row < count; row++) {
+        unsigned int code = codeValues[row];
+        values.insert(values.end(), bytes.data() + offsets[code],
+                      bytes.data() + offsets[code + 1]);
+        positions.push_back(values.size());
+    }
+
+    offsets.swap(positions);
+    bytes.swap(values);
+
+    // Free the dictionary
+    std::vector<unsigned int>().swap(codeValues);
+    std::vector<unsigned int>().swap(dictionaryIndex);
+    entries = 0;
+    plainBytes = 0;
+    storage = S_STRING;
+}
+
+/**
+ *
+ * Records whether the cell just appended is null and counts it
+ *
+ * @param null True if the cell is null
+ * @return void
+ */
+void ResultColumn::markRow(bool null)
+{
+    if (count % 64 == 0) {
+        nulls.push_back(0);
+    }
+
+    if (null) {
+        nulls.back() |= 1ULL << (count % 64);
+    }
+
+    count++;
+}
+
+/**
+ *
+ * Converts a cell of the column's type to the integer it is stored as
+ *
+ * @param value The value to convert
+ * @return long long
+ */
+long long ResultColumn::toInteger(const Variant &value) const
+{
+    switch (type) {
+    case D_BOOLEAN:
+        return value.toBool() ? 1 : 0;
+    case D_USHORT:
+    case D_UINT:
+    case D_ULONG:
+    case D_ULONGLONG:
+        return static_cast<long long>(value.toULongLong());
+    case D_DATETIME:
+        return value.toDateTime().pack();
+    default:
+        return value.toLongLong();
+    }
+}
+
+/**
+ *
+ * Converts a stored integer back to a variant of the column's type
+ *
+ * @param value The stored value
+ * @return Variant
+ */
+Variant ResultColumn::fromInteger(long long value) const
+{
+    switch (type) {
+    case D_BOOLEAN:
+        return Variant(value != 0);
+    case D_SHORT:
+        return Variant(static_cast<short>(value));
+    case D_USHORT:
+        return Variant(static_cast<unsigned short>(value));
+    case D_INT:
+        return Variant(static_cast<int>(value));
+    case D_UINT:
+        return Variant(static_cast<unsigned int>(value));
+    case D_LONG:
+        return Variant(static_cast<long>(value));
+    case D_ULONG:
+        return Variant(static_cast<unsigned long>(value));
+    case D_ULONGLONG:
+        return Variant(static_cast<unsigned long long>(value));
+    case D_DATETIME:
+        return Variant(DateTime::unpack(value));
+    default:
+        return Variant(value);
+    }
+}
+
+/**
+ *
+ * Moves every cell into variant storage. Used once cells of different types
+ * have been appended.
+ *
+ * @return void
+ */
+void ResultColumn::convertToVariants()
+{
+    std::vector<Variant> values;
+    values.reserve(count);
+
+    for (size_t row = 0; row < count; row++) {
+        values.push_back(at(row));
+    }
+
+    // Free the typed storage
+    std::vector<long long>().swap(integerValues);
+    std::vector<double>().swap(doubleValues);
+    std::vector<size_t>().swap(offsets);
+    std::vector<char>().swap(bytes);
+    std::vector<unsigned int>().swap(codeValues);
+    std::vector<unsigned int>().swap(dictionaryIndex);
+    entries = 0;
+    plainBytes = 0;
+
+    variantValues = std::move(values);
+    storage = S_VARIANT;
+    type = D_NULL;
+}
+
+/**
+ *
+ * Copies a spilled column back into memory
+ *
+ * @return void
+ */
+void ResultColumn::unmap()
+{
+    nulls.assign(mappedNulls, mappedNulls + (count + 63) / 64);
+
+    switch (storage) {
+    case S_INTEGER:
+        integerValues.assign(mappedIntegers, mappedIntegers + count);
+        break;
+    case S_DOUBLE:
+        doubleValues.assign(mappedDoubles, mappedDoubles + count);
+        break;
+    case S_STRING:
+        offsets.assign(mappedOffsets, mappedOffsets + count + 1);
+        bytes.assign(mappedBytes, mappedBytes + mappedOffsets[count]);
+        break;
+    case S_DICTIONARY:
+        codeValues.assign(mappedCodes, mappedCodes + count);
+        offsets.assign(mappedOffsets, mappedOffsets + entries + 1);
+        bytes.assign(mappedBytes, mappedBytes + mappedOffsets[entries]);
+        break;
+    default:
+        break;
+    }
+
+    mapping.reset();
+    mappedNulls = nullptr;
+    mappedIntegers = nullptr;
+    mappedDoubles = nullptr;
+    mappedOffsets = nullptr;
+    mappedBytes = nullptr;
+    mappedCodes = nullptr;
+}
+
+/**
+ *
+ * Returns the null bitmap
+ *
+ * @return const unsigned long long *
+ */
+const unsigned long long *ResultColumn::nullWords() const
+{
+    return mapping ? mappedNulls : nulls.data();
+}
+
+/**
+ *
+ * Returns the integer array
+ *
+ * @return const long long *
+ */
+const long long *ResultColumn::integerData() const
+{
+    return mapping ? mappedIntegers : integerValues.data();
+}
+
+/**
+ *
+ * Returns the floating point array
+ *
+ * @return const double *
+ */
+const double *ResultColumn::doubleData() const
+{
+    return mapping ? mappedDoubles : doubleValues.data();
+}
+
+/**
+ *
+ * Returns the string offsets
+ *
+ * @return const size_t *
+ */
+const size_t *ResultColumn::offsetData() const
+{
+    return mapping ? mappedOffsets : offsets.data();
+}
+
+/**
+ *
+ * Returns the string bytes
+ *
+ * @return const char *
+ */
+const char *ResultColumn::byteData() const
+{
+    return mapping ? mappedBytes : bytes.data();
+}
+
+/**
+ *
+ * Returns the dictionary codes
+ *
+ * @return const unsigned int *
+ */
+const unsigned int *ResultColumn::codeData() const
+{
+    return mapping ? mappedCodes : codeValues.data();
+}
+
+} // namespace RabidSQL
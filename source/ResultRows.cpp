@@ -0,0 +1,673 @@
+#include "App.h"
+#include "ResultRows.h"
+#include "ResultSpillFile.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace RabidSQL {
+
+const size_t ResultRows::BLOCK_ROWS;
+
+/**
+ *
+ * Creates an iterator positioned at row
+ *
+ * @param rows The rows to iterate over
+ * @param row The row to start at
+ */
+ResultRows::const_iterator::const_iterator(const ResultRows *rows,
+                                           size_t row) :
+    rows(rows),
+    row(row)
+{
+}
+
+/**
+ *
+ * Assembles the current row
+ *
+ * @return VariantVector
+ */
+VariantVector ResultRows::const_iterator::operator*() const
+{
+    return rows->at(row);
+}
+
+/**
+ *
+ * Moves to the next row
+ *
+ * @return The iterator
+ */
+ResultRows::const_iterator &ResultRows::const_iterator::operator++()
+{
+    row++;
+
+    return *this;
+}
+
+/**
+ *
+ * Moves to the next row
+ *
+ * @return The iterator as it was before moving
+ */
+ResultRows::const_iterator ResultRows::const_iterator::operator++(int)
+{
+    const_iterator previous = *this;
+    row++;
+
+    return previous;
+}
+
+/**
+ *
+ * Returns true if both iterators are at the same row
+ *
+ * @param value The iterator to compare
+ * @return bool
+ */
+bool ResultRows::const_iterator::operator==(const const_iterator &value) const
+{
+    return rows == value.rows && row == value.row;
+}
+
+/**
+ *
+ * Returns true if the iterators are at different rows
+ *
+ * @param value The iterator to compare
+ * @return bool
+ */
+bool ResultRows::const_iterator::operator!=(const const_iterator &value) const
+{
+    return !(*this == value);
+}
+
+/**
+ *
+ * Creates an empty set of rows
+ *
+ */
+ResultRows::ResultRows()
+{
+}
+
+/**
+ *
+ * Copies rows
+ *
+ * @param value The rows to copy
+ */
+ResultRows::ResultRows(const ResultRows &value) :
+    blocks(value.blocks),
+    columns(value.columns),
+    rows(value.rows),
+    reservedRows(value.reservedRows),
+    memoryLimit(value.memoryLimit),
+    residentBytes(value.residentBytes),
+    spillFile(value.spillFile),
+    blockStats(value.blockStats),
+    statsBlocks(value.statsBlocks)
+{
+}
+
+/**
+ *
+ * Takes the blocks of value, leaving it empty but with the same memory limit
+ *
+ * @param value The rows to move
+ */
+ResultRows::ResultRows(ResultRows &&value) :
+    blocks(std::move(value.blocks)),
+    columns(value.columns),
+    rows(value.rows),
+    reservedRows(value.reservedRows),
+    memoryLimit(value.memoryLimit),
+    residentBytes(value.residentBytes),
+    spillFile(std::move(value.spillFile)),
+    blockStats(std::move(value.blockStats)),
+    statsBlocks(value.statsBlocks)
+{
+    value.clear();
+}
+
+/**
+ *
+ * Copies rows
+ *
+ * @param value The rows to copy
+ * @return ResultRows&
+ */
+ResultRows &ResultRows::operator=(const ResultRows &value)
+{
+    blocks = value.blocks;
+    columns = value.columns;
+    rows = value.rows;
+    reservedRows = value.reservedRows;
+    memoryLimit = value.memoryLimit;
+    residentBytes = value.residentBytes;
+    spillFile = value.spillFile;
+    blockStats = value.blockStats;
+    statsBlocks = value.statsBlocks;
+
+    return *this;
+}
+
+/**
+ *
+ * Takes the blocks of value, leaving it empty but with the same memory limit
+ *
+ * @param value The rows to move
+ * @return ResultRows&
+ */
+ResultRows &ResultRows::operator=(ResultRows &&value)
+{
+    if (this != &value) {
+        blocks = std::move(value.blocks);
+        columns = value.columns;
+        rows = value.rows;
+        reservedRows = value.reservedRows;
+        memoryLimit = value.memoryLimit;
+        residentBytes = value.residentBytes;
+        spillFile = std::move(value.spillFile);
+        blockStats = std::move(value.blockStats);
+        statsBlocks = value.statsBlocks;
+        value.clear();
+    }
+
+    return *this;
+}
+
+/**
+ *
+ * Returns the number of rows
+ *
+ * @return size_t
+ */
+size_t ResultRows::size() const
+{
+    return rows;
+}
+
+/**
+ *
+ * Returns true if there are no rows
+ *
+ * @return bool
+ */
+bool ResultRows::empty() const
+{
+    return rows == 0;
+}
+
+/**
+ *
+ * Assembles a row
+ *
+ * @param row The index of the row
+ * @return VariantVector
+ */
+VariantVector ResultRows::at(size_t row) const
+{
+    VariantVector values;
+
+    if (row >= rows) {
+        return values;
+    }
+
+    const Block &block = blocks[row / BLOCK_ROWS];
+    values.reserve(columns);
+
+    for (auto &column : block) {
+        values.push_back(column.at(row % BLOCK_ROWS));
+    }
+
+    return values;
+}
+
+/**
+ *
+ * Returns a single cell
+ *
+ * @param row The index of the row
+ * @param column The index of the column
+ * @return Variant
+ */
+Variant ResultRows::at(size_t row, size_t column) const
+{
+    if (row >= rows || column >= columns) {
+        return Variant();
+    }
+
+    return blocks[row / BLOCK_ROWS][column].at(row % BLOCK_ROWS);
+}
+
+/**
+ *
+ * Assembles a row
+ *
+ * @param row The index of the row
+ * @return VariantVector
+ */
+VariantVector ResultRows::operator[](size_t row) const
+{
+    return at(row);
+}
+
+/**
+ *
+ * Assembles the first row
+ *
+ * @return VariantVector
+ */
+VariantVector ResultRows::front() const
+{
+    return at(0);
+}
+
+/**
+ *
+ * Assembles the last row
+ *
+ * @return VariantVector
+ */
+VariantVector ResultRows::back() const
+{
+    return at(rows - 1);
+}
+
+/**
+ *
+ * Returns an iterator to the first row
+ *
+ * @return const_iterator
+ */
+ResultRows::const_iterator ResultRows::begin() const
+{
+    return const_iterator(this, 0);
+}
+
+/**
+ *
+ * Returns an iterator past the last row
+ *
+ * @return const_iterator
+ */
+ResultRows::const_iterator ResultRows::end() const
+{
+    return const_iterator(this, size());
+}
+
+/**
+ *
+ * Appends a row. Columns are added as needed; cells missing from a short row
+ * are null.
+ *
+ * @param row The cells of the row
+ * @return void
+ */
+void ResultRows::push_back(const VariantVector &row)
+{
+    if (row.size() > columns) {
+        setColumnCount(row.size());
+    }
+
+    addRow();
+
+    for (size_t i = 0; i < columns; i++) {
+
+        if (i < row.size()) {
+            appendTo(i).append(row[i]);
+        } else {
+            appendTo(i).appendNull();
+        }
+    }
+}
+
+/**
+ *
+ * Starts a row. Exactly one cell must then be appended to each column through
+ * appendTo().
+ *
+ * @return void
+ */
+void ResultRows::addRow()
+{
+    if (rows % BLOCK_ROWS == 0) {
+
+        if (!blocks.empty()) {
+            sealBlock(blocks.size() - 1);
+        }
+
+        blocks.emplace_back(columns);
+        reserveBlock(blocks.size() - 1);
+    }
+
+    rows++;
+}
+
+/**
+ *
+ * Returns the column the cells of the row being added go to
+ *
+ * @param column The index of the column
+ * @return ResultColumn&
+ */
+ResultColumn &ResultRows::appendTo(size_t column)
+{
+    return blocks.back()[column];
+}
+
+/**
+ *
+ * Returns the number of columns
+ *
+ * @return size_t
+ */
+size_t ResultRows::columnCount() const
+{
+    return columns;
+}
+
+/**
+ *
+ * Sets the number of columns. New columns hold nulls for the existing rows.
+ *
+ * @param count The number of columns
+ * @return void
+ */
+void ResultRows::setColumnCount(size_t count)
+{
+    if (count != columns) {
+
+        // Gathered again by statistics() from the blocks themselves
+        blockStats.clear();
+        statsBlocks = 0;
+    }
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        Block &block = blocks[i];
+        size_t filled = blockRows(i);
+
+        // Rows of the last block may still be being filled
+        if (i == blocks.size() - 1 && !block.empty()) {
+            filled = block.front().size();
+        }
+
+        block.resize(count);
+
+        for (size_t column = columns; column < count; column++) {
+
+            for (size_t row = 0; row < filled; row++) {
+                block[column].appendNull();
+            }
+        }
+    }
+
+    columns = count;
+}
+
+/**
+ *
+ * Returns the number of blocks the rows are kept in
+ *
+ * @return size_t
+ */
+size_t ResultRows::blockCount() const
+{
+    return blocks.size();
+}
+
+/**
+ *
+ * Returns a column of a block, for scanning. Row r of the block is row
+ * block * BLOCK_ROWS + r of the result.
+ *
+ * @param block The index of the block
+ * @param index The index of the column
+ * @return const ResultColumn&
+ */
+const ResultColumn &ResultRows::column(size_t block, size_t index) const
+{
+    return blocks[block][index];
+}
+
+/**
+ *
+ * Reserves room for rows rows in total. Blocks are sized to the rows they
+ * will hold rather than BLOCK_ROWS, so small results stay small.
+ *
+ * @param rows The number of rows to reserve room for
+ * @return void
+ */
+void ResultRows::reserve(size_t rows)
+{
+    reservedRows = rows;
+
+    if (!blocks.empty()) {
+        reserveBlock(blocks.size() - 1);
+    }
+}
+
+/**
+ *
+ * Removes every row and column. The memory limit is kept.
+ *
+ * @return void
+ */
+void ResultRows::clear()
+{
+    blocks.clear();
+    columns = 0;
+    rows = 0;
+    reservedRows = 0;
+    residentBytes = 0;
+    spillFile.reset();
+    blockStats.clear();
+    statsBlocks = 0;
+}
+
+/**
+ *
+ * Returns the approximate number of bytes the rows occupy
+ *
+ * @return size_t
+ */
+size_t ResultRows::memoryUsage() const
+{
+    size_t usage = sizeof(ResultRows);
+
+    usage += blocks.capacity() * sizeof(Block);
+
+    for (auto &block : blocks) {
+        usage += block.capacity() * sizeof(ResultColumn);
+
+        for (auto &column : block) {
+            usage += column.memoryUsage() - sizeof(ResultColumn);
+        }
+    }
+
+    return usage;
+}
+
+/**
+ *
+ * Returns how many bytes dictionary-encoded string columns save over storing
+ * every value
+ *
+ * @return size_t
+ */
+size_t ResultRows::dictionarySavings() const
+{
+    size_t savings = 0;
+
+    for (auto &block : blocks) {
+        for (auto &column : block) {
+            savings += column.dictionarySavings();
+        }
+    }
+
+    return savings;
+}
+
+/**
+ *
+ * Returns the statistics of each column. Those of full blocks were gathered
+ * as the blocks filled; only the rest are scanned now.
+ *
+ * @return std::vector<ColumnStats>
+ */
+std::vector<ColumnStats> ResultRows::statistics() const
+{
+    std::vector<ColumnStats> stats = blockStats;
+    stats.resize(columns);
+
+    for (size_t block = statsBlocks; block < blocks.size(); block++) {
+        for (size_t i = 0; i < columns; i++) {
+            stats[i].add(blocks[block][i]);
+        }
+    }
+
+    return stats;
+}
+
+/**
+ *
+ * Sets how much memory full blocks may use before further blocks are spilled
+ * to disk. Applies to blocks filled from now on.
+ *
+ * @param bytes The limit in bytes, or 0 for no limit
+ * @return void
+ */
+void ResultRows::setMemoryLimit(size_t bytes)
+{
+    memoryLimit = bytes;
+}
+
+/**
+ *
+ * Returns the memory limit in bytes, or 0 if there is none
+ *
+ * @return size_t
+ */
+size_t ResultRows::getMemoryLimit() const
+{
+    return memoryLimit;
+}
+
+/**
+ *
+ * Returns the number of rows a block holds
+ *
+ * @param block The index of the block
+ * @return size_t
+ */
+size_t ResultRows::blockRows(size_t block) const
+{
+    return std::min(BLOCK_ROWS, rows - block * BLOCK_ROWS);
+}
+
+/**
+ *
+ * Reserves room in a block for the reserved rows that fall within it
+ *
+ * @param block The index of the block
+ * @return void
+ */
+void ResultRows::reserveBlock(size_t block)
+{
+    size_t first = block * BLOCK_ROWS;
+
+    if (reservedRows <= first) {
+        return;
+    }
+
+    size_t count = std::min(BLOCK_ROWS, reservedRows - first);
+
+    for (auto &column : blocks[block]) {
+        column.reserve(count);
+    }
+}
+
+/**
+ *
+ * Called once a block is full. Frees what its columns only needed while being
+ * filled and adds them to the statistics, then spills the block if keeping it
+ * would take the rows over the memory limit.
+ *
+ * @param block The index of the block
+ * @return void
+ */
+void ResultRows::sealBlock(size_t block)
+{
+    size_t usage = 0;
+
+    for (auto &column : blocks[block]) {
+        column.finish();
+        usage += column.memoryUsage();
+    }
+
+    if (block == statsBlocks) {
+        blockStats.resize(columns);
+
+        for (size_t i = 0; i < columns; i++) {
+            blockStats[i].add(blocks[block][i]);
+        }
+
+        statsBlocks++;
+    }
+
+    if (memoryLimit != 0 && residentBytes + usage > memoryLimit
+            && spillBlock(block)) {
+        return;
+    }
+
+    residentBytes += usage;
+}
+
+/**
+ *
+ * Writes a block's columns to the spill file and maps them back. Variant
+ * columns stay in memory.
+ *
+ * @param block The index of the block
+ * @return False if the block couldn't be spilled; it is then left as it was
+ */
+bool ResultRows::spillBlock(size_t block)
+{
+    if (!spillFile) {
+        spillFile = std::make_shared<ResultSpillFile>();
+    }
+
+    if (!spillFile->isOpen()
+            || !spillFile->align(ResultSpillFile::pageSize())) {
+        return false;
+    }
+
+    size_t offset = spillFile->size();
+
+    for (auto &column : blocks[block]) {
+
+        if (!column.spill(*spillFile)) {
+            return false;
+        }
+    }
+
+    auto mapping = spillFile->map(offset, spillFile->size() - offset);
+
+    if (!mapping) {
+        return false;
+    }
+
+    const char *data = mapping.get();
+
+    for (auto &column : blocks[block]) {
+        data += column.useMapping(mapping, data);
+    }
+
+    return true;
+}
+
+} // namespace RabidSQL
@@ -0,0 +1,170 @@
+#include "App.h"
+#include "ResultSpillFile.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace RabidSQL {
+
+/**
+ *
+ * Creates and unlinks a temporary file in $TMPDIR, or /tmp if it isn't set.
+ * Check isOpen() before use.
+ *
+ */
+ResultSpillFile::ResultSpillFile() :
+    descriptor(-1),
+    length(0)
+{
+    const char *directory = std::getenv("TMPDIR");
+    std::string path = directory != nullptr && *directory != '\0'
+            ? directory : "/tmp";
+    path += "/rabidsql-result-XXXXXX";
+
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+
+    descriptor = mkstemp(name.data());
+
+    if (descriptor != -1) {
+
+        // Nothing else needs the name
+        unlink(name.data());
+    }
+}
+
+/**
+ *
+ * Closes the file. Existing mappings stay valid.
+ *
+ */
+ResultSpillFile::~ResultSpillFile()
+{
+    if (descriptor != -1) {
+        close(descriptor);
+    }
+}
+
+/**
+ *
+ * Returns true if the file was created
+ *
+ * @return bool
+ */
+bool ResultSpillFile::isOpen() const
+{
+    return descriptor != -1;
+}
+
+/**
+ *
+ * Returns the number of bytes written so far
+ *
+ * @return size_t
+ */
+size_t ResultSpillFile::size() const
+{
+    return length;
+}
+
+/**
+ *
+ * Appends data to the file
+ *
+ * @param data The bytes to write
+ * @param length The number of bytes to write
+ * @return True on success. On failure the file's contents past the last
+ * successful write are undefined.
+ */
+bool ResultSpillFile::write(const void *data, size_t length)
+{
+    auto position = static_cast<const char *>(data);
+    size_t remaining = length;
+
+    while (remaining > 0) {
+        ssize_t written = pwrite(descriptor, position, remaining,
+                                 static_cast<off_t>(this->length));
+
+        if (written < 0) {
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        position += written;
+        remaining -= written;
+        this->length += written;
+    }
+
+    return true;
+}
+
+/**
+ *
+ * Pads the file with zeros to a multiple of alignment
+ *
+ * @param alignment The alignment, in bytes
+ * @return True on success
+ */
+bool ResultSpillFile::align(size_t alignment)
+{
+    size_t padding = (alignment - length % alignment) % alignment;
+
+    if (padding == 0) {
+        return true;
+    }
+
+    std::vector<char> zeros(padding, 0);
+
+    return write(zeros.data(), padding);
+}
+
+/**
+ *
+ * Maps part of the file into memory, read only
+ *
+ * @param offset Where the region starts. Must be a multiple of pageSize().
+ * @param length The length of the region
+ * @return The mapping, unmapped when the last reference is dropped, or
+ * nullptr on failure
+ */
+std::shared_ptr<const char> ResultSpillFile::map(size_t offset, size_t length)
+{
+    if (descriptor == -1 || length == 0) {
+        return nullptr;
+    }
+
+    void *address = mmap(nullptr, length, PROT_READ, MAP_SHARED, descriptor,
+                         static_cast<off_t>(offset));
+
+    if (address == MAP_FAILED) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const char>(static_cast<const char *>(address),
+                                       [length](const char *address) {
+        munmap(const_cast<char *>(address), length);
+    });
+}
+
+/**
+ *
+ * Returns the size of a memory page, which mapped regions must start on
+ *
+ * @return size_t
+ */
+size_t ResultSpillFile::pageSize()
+{
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    return size;
+}
+
+} // namespace RabidSQL
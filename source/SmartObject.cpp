@@ -249,6 +249,42 @@ void SmartObject::queueData(int id, const VariantVector &arguments)
     }
 }
 
+/**
+ *
+ * Queue some data for other object(s) to pickup. The arguments are moved into
+ * the last receiver's queue; any other receivers get a copy.
+ *
+ * @param id The id of the queue
+ * @param arguments The arguments to pass
+ * @return void
+ */
+void SmartObject::queueData(int id, VariantVector &&arguments)
+{
+    // Find all of the connected functions matching this id
+    auto its = connectedObjects.equal_range(id);
+
+    // Add to queue(s)
+    for (auto it = its.first; it != its.second; ++it) {
+
+        auto next = it;
+        ++next;
+
+        // Lock mutex
+        it->second->mutex.lock();
+
+        if (next == its.second) {
+
+            // Last receiver. Hand over the arguments themselves
+            it->second->dataQueue.push(Data(id, std::move(arguments)));
+        } else {
+            it->second->dataQueue.push(Data(id, arguments));
+        }
+
+        // Unlock mutex
+        it->second->mutex.unlock();
+    }
+}
+
 /**
  *
  * Process any data in the queue, clearing it in our wake. Note that while
@@ -272,7 +308,7 @@ int SmartObject::processQueue()
         finished = dataQueue.empty();
 
         if (!finished) {
-            auto data = dataQueue.front();
+            auto data = std::move(dataQueue.front());
             dataQueue.pop();
 
             // Unlock mutex
@@ -398,5 +434,17 @@ SmartObject::Data::Data(int id, const VariantVector &arguments)
     this->arguments = arguments;
 };
 
+/**
+ *
+ * Initializes a Data object, taking over the provided argument list.
+ *
+ * @return void
+ */
+SmartObject::Data::Data(int id, VariantVector &&arguments) :
+    arguments(std::move(arguments))
+{
+    this->id = id;
+};
+
 } // namespace RabidSQL
 
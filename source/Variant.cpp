@@ -1,14 +1,83 @@
 #include "App.h"
 #include "ArbitraryPointer.h"
 #include "FileStream.h"
+#include "NumericConversion.h"
 #include "Variant.h"
 #include "QueryResult.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
-#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 
 namespace RabidSQL {
 
+/**
+ * Common header of all heap payloads. The reference count is atomic as
+ * variants are routinely handed between connection threads and the UI thread.
+ */
+struct Variant::Payload {
+    Payload() : references(1) {}
+
+    std::atomic_int references;
+};
+
+/**
+ * A heap payload holding a single (immutable) value of type T
+ */
+template<typename T>
+struct Variant::SharedPayload : public Variant::Payload {
+    template<typename... Args>
+    SharedPayload(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    T value;
+};
+
+/**
+ * A heap payload for strings too long to be stored inline. The characters are
+ * allocated along with the header, so each string costs a single allocation.
+ */
+struct Variant::StringPayload : public Variant::Payload {
+    size_t size;
+    char string[1];
+
+    /**
+     * Allocates a payload large enough to hold size characters plus a null
+     * terminator and copies value into it
+     *
+     * @param value The characters to copy
+     * @param size The number of characters in value
+     * @return StringPayload *
+     */
+    static StringPayload *create(const char *value, size_t size)
+    {
+        auto payload = new (::operator new(sizeof(StringPayload) + size))
+                StringPayload();
+        payload->size = size;
+        memcpy(payload->string, value, size);
+        payload->string[size] = 0;
+
+        return payload;
+    }
+
+    /**
+     * Frees a payload allocated with create()
+     *
+     * @param payload The payload to free
+     * @return void
+     */
+    static void destroy(StringPayload *payload)
+    {
+        payload->~StringPayload();
+        ::operator delete(payload);
+    }
+};
+
 /**
  * Basic initialization (sets defaults)
  *
@@ -18,16 +87,11 @@ namespace RabidSQL {
 void Variant::init(DataType type)
 {
     this->type = type;
-    this->data = nullptr;
+    this->data.pointer = nullptr;
+    this->smallStringSize = 0;
     switch (type) {
         case D_NULL:
         case D_POINTER:
-            deleteData = false;
-            break;
-        case D_STRING:
-        case D_STRINGVECTOR:
-        case D_VARIANTVECTOR:
-        case D_VARIANTMAP:
         case D_LONG:
         case D_LONGLONG:
         case D_ULONG:
@@ -39,12 +103,57 @@ void Variant::init(DataType type)
         case D_BOOLEAN:
         case D_DOUBLE:
         case D_FLOAT:
+        case D_DATETIME:
+        case D_DECIMAL:
+            // Stored inline. Nothing to free.
+            deleteData = false;
+            break;
+        case D_STRING:
+        case D_BLOB:
+        case D_STRINGVECTOR:
+        case D_VARIANTVECTOR:
+        case D_VARIANTMAP:
+        case D_VARIANTHASHMAP:
         case D_QUERYRESULT:
             deleteData = true;
             break;
     }
 }
 
+/**
+ * Stores a string or blob. Short ones are kept inline, longer ones on the heap.
+ * Expects that init(D_STRING) or init(D_BLOB) has already been called.
+ *
+ * @param value The characters to copy
+ * @param length The number of characters in value
+ * @return void
+ */
+void Variant::setString(const char *value, size_t length)
+{
+    if (length < SMALL_STRING_SIZE) {
+
+        // Fits inline. Keep it null-terminated so it can be read as a c-string
+        memcpy(data.string, value, length);
+        data.string[length] = 0;
+        smallStringSize = static_cast<unsigned char>(length);
+        deleteData = false;
+    } else {
+
+        data.pointer = StringPayload::create(value, length);
+        deleteData = true;
+    }
+}
+
+/**
+ * Returns true if this is a string or blob short enough to be stored inline
+ *
+ * @return bool
+ */
+bool Variant::isSmallString() const
+{
+    return (type == D_STRING || type == D_BLOB) && !deleteData;
+}
+
 /**
  * Initializes a null variant.
  *
@@ -80,7 +189,25 @@ Variant::Variant(const std::nullptr_t &value)
 Variant::Variant(const Variant &value)
 {
     init(D_NULL);
-    *this = value;
+    copy(value);
+}
+
+/**
+ *
+ * Takes over the contents of another variant. The other variant is left null.
+ *
+ * @param value The value to move
+ * @return void
+ */
+Variant::Variant(Variant &&value)
+{
+    data = value.data;
+    type = value.type;
+    deleteData = value.deleteData;
+    smallStringSize = value.smallStringSize;
+
+    // The data is ours now
+    value.init(D_NULL);
 }
 
 /**
@@ -92,7 +219,7 @@ Variant::Variant(const Variant &value)
 Variant::Variant(const std::string &value)
 {
     init(D_STRING);
-    data = new std::string(value);
+    setString(value.data(), value.size());
 }
 
 /**
@@ -104,7 +231,20 @@ Variant::Variant(const std::string &value)
 Variant::Variant(const char *value)
 {
     init(D_STRING);
-    data = new std::string(value);
+    setString(value, strlen(value));
+}
+
+/**
+ * Initializes a variant based on a string that need not be null-terminated
+ *
+ * @param value The characters to copy
+ * @param length The number of characters in value
+ * @return void
+ */
+Variant::Variant(const char *value, size_t length)
+{
+    init(D_STRING);
+    setString(value, length);
 }
 
 /**
@@ -120,7 +260,7 @@ Variant::Variant(ArbitraryPointer *value, bool manage)
         init(D_NULL);
     } else {
         init(D_POINTER);
-        data = value;
+        data.pointer = value;
         deleteData = manage;
     }
 }
@@ -134,7 +274,19 @@ Variant::Variant(ArbitraryPointer *value, bool manage)
 Variant::Variant(const std::vector<std::string> &value)
 {
     init(D_STRINGVECTOR);
-    data = new std::vector<std::string>(value);
+    data.pointer = new SharedPayload<std::vector<std::string>>(value);
+}
+
+/**
+ * Initializes a variant based on a string vector, taking over its contents
+ *
+ * @param value The value to move
+ * @return void
+ */
+Variant::Variant(std::vector<std::string> &&value)
+{
+    init(D_STRINGVECTOR);
+    data.pointer = new SharedPayload<std::vector<std::string>>(std::move(value));
 }
 
 /**
@@ -146,7 +298,19 @@ Variant::Variant(const std::vector<std::string> &value)
 Variant::Variant(const VariantVector &value)
 {
     init(D_VARIANTVECTOR);
-    data = new VariantVector(value);
+    data.pointer = new SharedPayload<VariantVector>(value);
+}
+
+/**
+ * Initializes a variant based on a variant vector, taking over its contents
+ *
+ * @param value The value to move
+ * @return void
+ */
+Variant::Variant(VariantVector &&value)
+{
+    init(D_VARIANTVECTOR);
+    data.pointer = new SharedPayload<VariantVector>(std::move(value));
 }
 
 /**
@@ -158,7 +322,43 @@ Variant::Variant(const VariantVector &value)
 Variant::Variant(const VariantMap &value)
 {
     init(D_VARIANTMAP);
-    data = new VariantMap(value);
+    data.pointer = new SharedPayload<VariantMap>(value);
+}
+
+/**
+ * Initializes a variant based on a variant map, taking over its contents
+ *
+ * @param value The value to move
+ * @return void
+ */
+Variant::Variant(VariantMap &&value)
+{
+    init(D_VARIANTMAP);
+    data.pointer = new SharedPayload<VariantMap>(std::move(value));
+}
+
+/**
+ * Initializes a variant based on a variant hash map
+ *
+ * @param value The value to copy
+ * @return void
+ */
+Variant::Variant(const VariantHashMap &value)
+{
+    init(D_VARIANTHASHMAP);
+    data.pointer = new SharedPayload<VariantHashMap>(value);
+}
+
+/**
+ * Initializes a variant based on a variant hash map, taking over its contents
+ *
+ * @param value The value to move
+ * @return void
+ */
+Variant::Variant(VariantHashMap &&value)
+{
+    init(D_VARIANTHASHMAP);
+    data.pointer = new SharedPayload<VariantHashMap>(std::move(value));
 }
 
 /**
@@ -170,7 +370,7 @@ Variant::Variant(const VariantMap &value)
 Variant::Variant(const long &value)
 {
     init(D_LONG);
-    data = new long(value);
+    data.longValue = value;
 }
 
 /**
@@ -182,7 +382,7 @@ Variant::Variant(const long &value)
 Variant::Variant(const long long &value)
 {
     init(D_LONGLONG);
-    data = new long long(value);
+    data.longLongValue = value;
 }
 
 /**
@@ -193,8 +393,8 @@ Variant::Variant(const long long &value)
  */
 Variant::Variant(const unsigned long &value)
 {
-    init(D_LONG);
-    data = new unsigned long(value);
+    init(D_ULONG);
+    data.ulongValue = value;
 }
 
 /**
@@ -206,7 +406,7 @@ Variant::Variant(const unsigned long &value)
 Variant::Variant(const unsigned long long &value)
 {
     init(D_ULONGLONG);
-    data = new unsigned long long(value);
+    data.ulongLongValue = value;
 }
 
 /**
@@ -218,7 +418,7 @@ Variant::Variant(const unsigned long long &value)
 Variant::Variant(const int &value)
 {
     init(D_INT);
-    data = new int(value);
+    data.intValue = value;
 }
 
 /**
@@ -230,7 +430,7 @@ Variant::Variant(const int &value)
 Variant::Variant(const unsigned int &value)
 {
     init(D_UINT);
-    data = new unsigned int(value);
+    data.uintValue = value;
 }
 
 /**
@@ -242,7 +442,7 @@ Variant::Variant(const unsigned int &value)
 Variant::Variant(const short &value)
 {
     init(D_SHORT);
-    data = new short(value);
+    data.shortValue = value;
 }
 
 /**
@@ -254,7 +454,7 @@ Variant::Variant(const short &value)
 Variant::Variant(const unsigned short &value)
 {
     init(D_USHORT);
-    data = new unsigned short(value);
+    data.ushortValue = value;
 }
 
 /**
@@ -266,7 +466,7 @@ Variant::Variant(const unsigned short &value)
 Variant::Variant(const bool &value)
 {
     init(D_BOOLEAN);
-    data = new bool(value);
+    data.boolean = value;
 }
 
 /**
@@ -278,7 +478,7 @@ Variant::Variant(const bool &value)
 Variant::Variant(const double &value)
 {
     init(D_DOUBLE);
-    data = new double(value);
+    data.doubleValue = value;
 }
 
 /**
@@ -290,7 +490,44 @@ Variant::Variant(const double &value)
 Variant::Variant(const float &value)
 {
     init(D_FLOAT);
-    data = new float(value);
+    data.floatValue = value;
+}
+
+/**
+ * Initializes a variant based on a date and time
+ *
+ * @param value The value to copy
+ * @return void
+ */
+Variant::Variant(const DateTime &value)
+{
+    init(D_DATETIME);
+    data.longLongValue = value.pack();
+}
+
+/**
+ * Initializes a variant based on a fixed-point decimal
+ *
+ * @param value The value to copy
+ * @return void
+ */
+Variant::Variant(const Decimal &value)
+{
+    init(D_DECIMAL);
+    data.decimalValue = value;
+}
+
+/**
+ * Initializes a variant based on raw binary data
+ *
+ * @param value The bytes to copy
+ * @param length The number of bytes in value
+ * @return void
+ */
+Variant::Variant(const unsigned char *value, size_t length)
+{
+    init(D_BLOB);
+    setString(reinterpret_cast<const char *>(value), length);
 }
 
 /**
@@ -302,829 +539,2581 @@ Variant::Variant(const float &value)
 Variant::Variant(const QueryResult &value)
 {
     init(D_QUERYRESULT);
-    data = new QueryResult(value);
+    data.pointer = new SharedPayload<QueryResult>(value);
 }
 
 /**
+ * Initializes a variant based on a QueryResult structure, taking over its
+ * columns and rows
  *
- * Assigns the contents of the argument passed (value) to this object. This
- * makes a deep copy.
+ * @param value The object to move
+ * @return void
+ */
+Variant::Variant(QueryResult &&value)
+{
+    init(D_QUERYRESULT);
+    data.pointer = new SharedPayload<QueryResult>(std::move(value));
+}
+
+/**
+ *
+ * Assigns the contents of the argument passed (value) to this object. Inline
+ * values are copied and heap payloads shared, so this never deep copies (except
+ * for pointers, which are cloned).
  *
  * @param value The value to copy
  * @return void
  */
 void Variant::operator=(const Variant &value)
 {
-    if (deleteData && data != value.data) {
+    if (this == &value) {
 
-        deinit();
+        // Self-assignment. Nothing to do.
+        return;
     }
 
+    // Copy first, value may live inside the data we're about to release
+    *this = Variant(value);
+}
+
+/**
+ *
+ * Copies the contents of the argument passed (value) into this object. Expects
+ * this object to be empty (null).
+ *
+ * @param value The value to copy
+ * @return void
+ */
+void Variant::copy(const Variant &value)
+{
     init(value.type);
     switch (type) {
     case D_NULL:
-        data = nullptr;
         break;
     case D_POINTER:
-        if (value.data == nullptr) {
+        if (value.data.pointer == nullptr) {
             init(D_NULL);
         } else {
-            data = value.toPointer()->clone();
+            data.pointer = value.toPointer()->clone();
             deleteData = value.deleteData;
         }
         break;
     case D_STRING:
-        data = new std::string(value.toString());
-        break;
+    case D_BLOB:
     case D_STRINGVECTOR:
-        data = new std::vector<std::string>(value.toStringVector());
-        break;
     case D_VARIANTVECTOR:
-        data = new VariantVector(value.toVariantVector());
-        break;
     case D_VARIANTMAP:
-        data = new VariantMap(value.toVariantMap());
+    case D_VARIANTHASHMAP:
+    case D_QUERYRESULT:
+        data = value.data;
+        smallStringSize = value.smallStringSize;
+        deleteData = value.deleteData;
+
+        if (deleteData) {
+
+            // Share the payload
+            static_cast<Payload *>(data.pointer)->references.fetch_add(1,
+                    std::memory_order_relaxed);
+        }
         break;
     case D_LONG:
-        data = new long(value.toLong());
-        break;
     case D_LONGLONG:
-        data = new unsigned long long(value.toLong());
-        break;
     case D_ULONG:
-        data = new unsigned long(value.toLong());
-        break;
     case D_ULONGLONG:
-        data = new unsigned long long(value.toLong());
-        break;
     case D_INT:
-        data = new int(value.toLong());
-        break;
     case D_UINT:
-        data = new unsigned int(value.toLong());
-        break;
     case D_SHORT:
-        data = new short(value.toLong());
-        break;
     case D_USHORT:
-        data = new unsigned short(value.toLong());
-        break;
     case D_BOOLEAN:
-        data = new bool(value.toBool());
-        break;
     case D_DOUBLE:
-        data = new double(value.toDouble());
-        break;
     case D_FLOAT:
-        data = new float(value.toFloat());
-        break;
-    case D_QUERYRESULT:
-        data = new QueryResult(value.toQueryResult());
+    case D_DATETIME:
+    case D_DECIMAL:
+        // Inline value. A plain copy will do.
+        data = value.data;
         break;
     }
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if they
- * are the same (comparison based on the type of this object). Else false.
  *
- * @param value The value to compare
- * @return True if this object equals value, else false
+ * Moves the contents of the argument passed (value) into this object. No copy
+ * is made; value is left null.
+ *
+ * @param value The value to move
+ * @return void
  */
-bool Variant::operator==(const Variant &value) const
+void Variant::operator=(Variant &&value)
 {
-    DataType type;
+    if (this == &value) {
 
-    // By default use our type
-    type = this->type;
+        // Self-assignment. Nothing to do.
+        return;
+    }
 
-    // Because of precision differences, we need to treat double-float
-    // comparisons specially. Realistically, this comparison shouldn't ever
-    // happen >.<
-    if (type == D_FLOAT && value.type == D_DOUBLE) {
+    // Take the data before freeing our own. value may live inside our data
+    // (e.g. an element of a vector we hold)
+    Data data = value.data;
+    DataType type = value.type;
+    bool deleteData = value.deleteData;
+    unsigned char smallStringSize = value.smallStringSize;
+    value.init(D_NULL);
 
-        return fabs(toFloat() - value.toDouble()) < 0.00001;
-    } else if (type == D_DOUBLE && value.type == D_FLOAT) {
+    if (this->deleteData) {
 
-        return fabs(toDouble() - value.toFloat()) < 0.00001;
+        deinit();
     }
 
-    // We need to make sure that if a equals b, that b also equals a. To do this
-    // it is necessary to always use the greatest (or least) type. However, it
-    // is impractical to prefer string over double or float as that would make
-    // 1.0 not equal "1", so decimal types are always greater than non-decimal
-    // types. NONE is a special case and is not simply put at the end of the
-    // DataType list because if types get added in the future, that would change
-    // the id of it and break any saved server configs.
-    if (type != D_NULL && (value.type == D_NULL || value.type > type)) {
+    this->data = data;
+    this->type = type;
+    this->deleteData = deleteData;
+    this->smallStringSize = smallStringSize;
+}
 
-        // Set type to the right side's type (greater than left or NONE)
-        type = value.type;
-    }
+// Every pair of types is compared by one of these functions, looked up in a
+// table indexed by both types. The table is filled at compile time, so
+// comparing two variants is a single indirect call with no switch on either
+// type.
+struct Variant::Comparison {
+    typedef int (*Comparator)(const Variant &left, const Variant &right);
+
+    enum Constants {
+        // DataType ids are multiples of TYPE_STEP
+        TYPE_STEP = 10,
+        TYPE_COUNT = _LAST / TYPE_STEP + 1
+    };
+
+    static_assert(_LAST % TYPE_STEP == 0,
+                  "DataType ids must be multiples of TYPE_STEP");
+
+    template<int... Index>
+    struct Indices {
+    };
+
+    template<int Count, int... Index>
+    struct MakeIndices : MakeIndices<Count - 1, Count - 1, Index...> {
+    };
+
+    template<int... Index>
+    struct MakeIndices<0, Index...> {
+        typedef Indices<Index...> Type;
+    };
+
+    struct Table {
+        Comparator comparators[TYPE_COUNT * TYPE_COUNT];
+    };
+
+    static const Table table;
+
+    template<typename T>
+    static int order(const T &left, const T &right);
+    static int order(const std::string &left, const std::string &right);
+    static int order(const Variant &left, const Variant &right);
+    static int order(const VariantMap::value_type &left,
+                     const VariantMap::value_type &right);
+    static int order(const std::vector<std::string> &left,
+                     const std::vector<std::string> &right);
+    static int order(const VariantVector &left, const VariantVector &right);
+    static int order(const VariantMap &left, const VariantMap &right);
+    template<typename T>
+    static int sequences(const T &left, const T &right);
+
+    template<typename T, T Data::*member>
+    static int scalars(const Variant &left, const Variant &right);
+    template<typename T, T (Variant::*convert)() const>
+    static int converted(const Variant &left, const Variant &right);
+    static int nulls(const Variant &left, const Variant &right);
+    static int strings(const Variant &left, const Variant &right);
+    static int stringVectors(const Variant &left, const Variant &right);
+    static int variantVectors(const Variant &left, const Variant &right);
+    static int variantMaps(const Variant &left, const Variant &right);
+    static int variantHashMaps(const Variant &left, const Variant &right);
+    static int queryResults(const Variant &left, const Variant &right);
+    static int mixedFloats(const Variant &left, const Variant &right);
+    static int integers(const Variant &left, const Variant &right);
+    static int integerWithFloat(const Variant &left, const Variant &right);
+    static int dates(const Variant &left, const Variant &right);
+    static int decimals(const Variant &left, const Variant &right);
+    static int mixedDecimals(const Variant &left, const Variant &right);
+
+    static constexpr bool isFloat(int type);
+    static constexpr bool isInteger(int type);
+    static constexpr bool isUnsigned(int type);
+    static constexpr Comparator sameType(int type);
+    static constexpr Comparator mixedType(int type);
+    static constexpr Comparator select(int left, int right);
+    template<int... Index>
+    static constexpr Table makeTable(Indices<Index...>);
+};
 
-    switch (type) {
-    case D_POINTER:
-        return data == value.data;
-    case D_STRING:
-        return toString() == value.toString();
-    case D_STRINGVECTOR:
-        return toStringVector() == value.toStringVector();
-    case D_VARIANTVECTOR:
-        return toVariantVector() == value.toVariantVector();
-    case D_VARIANTMAP:
-        return toVariantMap() == value.toVariantMap();
-    case D_DOUBLE:
-        return toDouble() == value.toDouble();
-    case D_FLOAT:
-        return toFloat() == value.toFloat();
-    case D_SHORT:
-        return toShort() == value.toShort();
-    case D_USHORT:
-        return toUShort() == value.toUShort();
-    case D_BOOLEAN:
-        return toBool() == value.toBool();
-    case D_INT:
-        return toInt() == value.toInt();
-    case D_UINT:
-        return toUInt() == value.toUInt();
-    case D_LONG:
-        return toLong() == value.toLong();
-    case D_LONGLONG:
-        return toLongLong() == value.toLongLong();
-    case D_ULONG:
-        return toULong() == value.toULong();
-    case D_ULONGLONG:
-        return toULongLong() == value.toULongLong();
-    case D_QUERYRESULT:
-        return toQueryResult().uid == value.toQueryResult().uid;
-    case D_NULL:
-        return isNull() == value.isNull();
-    }
+/**
+ *
+ * Three-way comparison of two values with operator<
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+template<typename T>
+int Variant::Comparison::order(const T &left, const T &right)
+{
+    return left < right ? -1 : (right < left ? 1 : 0);
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if this
- * is greater than value (comparison based on the type of this object). Else
- * false.
  *
- * @param value The value to compare
- * @return True if this object does not equal value, else false
+ * Three-way comparison of two strings
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
  */
-bool Variant::operator>(const Variant &value) const
+int Variant::Comparison::order(const std::string &left,
+                               const std::string &right)
 {
-    DataType type;
+    return left.compare(right);
+}
 
-    // By default use our type
-    type = this->type;
+/**
+ *
+ * Three-way comparison of two variants
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::order(const Variant &left, const Variant &right)
+{
+    return left.compare(right);
+}
 
-    // We need to make sure that if a > b, that b is < a. To do this
-    // it is necessary to always use the greatest (or least) type -- it need
-    // only be consistent
-    if (value.type > this->type) {
-        type = value.type;
-    }
+/**
+ *
+ * Three-way comparison of two map entries, by key then by value
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::order(const VariantMap::value_type &left,
+                               const VariantMap::value_type &right)
+{
+    int result = left.first.compare(right.first);
 
-    switch (type) {
-    case D_POINTER:
-        return data > value.data;
-    case D_STRING:
-        return toString() > value.toString();
-    case D_STRINGVECTOR:
-        return toStringVector() > value.toStringVector();
-    case D_VARIANTVECTOR:
-        return toVariantVector() > value.toVariantVector();
-    case D_VARIANTMAP:
-        return toVariantMap() > value.toVariantMap();
-    case D_DOUBLE:
-        return toDouble() > value.toDouble();
-    case D_FLOAT:
-        return toFloat() > value.toFloat();
-    case D_SHORT:
-        return toShort() > value.toShort();
-    case D_USHORT:
-        return toUShort() > value.toUShort();
-    case D_BOOLEAN:
-        return toBool() > value.toBool();
-    case D_INT:
-        return toInt() > value.toInt();
-    case D_UINT:
-        return toUInt() > value.toUInt();
-    case D_LONG:
-        return toLong() > value.toLong();
-    case D_LONGLONG:
-        return toLongLong() > value.toLongLong();
-    case D_ULONG:
-        return toULong() > value.toULong();
-    case D_ULONGLONG:
-        return toULongLong() > value.toULongLong();
-    case D_QUERYRESULT:
-        return toQueryResult().uid > value.toQueryResult().uid;
-    case D_NULL:
-        return value.isNull();
-    }
+    return result != 0 ? result : left.second.compare(right.second);
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if this
- * is less than value (comparison based on the type of this object). Else false.
  *
- * @param value The value to compare
- * @return True if this object is less than value, else false
+ * Three-way comparison of two string vectors
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
  */
-bool Variant::operator<(const Variant &value) const
+int Variant::Comparison::order(const std::vector<std::string> &left,
+                               const std::vector<std::string> &right)
 {
-    DataType type;
-
-    // By default use our type
-    type = this->type;
+    return sequences(left, right);
+}
 
-    // We need to make sure that if a > b, that b is < a. To do this
-    // it is necessary to always use the greatest (or least) type -- it need
-    // only be consistent
-    if (value.type > this->type) {
-        type = value.type;
-    }
+/**
+ *
+ * Three-way comparison of two variant vectors
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::order(const VariantVector &left,
+                               const VariantVector &right)
+{
+    return sequences(left, right);
+}
 
-    switch (type) {
-    case D_POINTER:
-        return data < value.data;
+/**
+ *
+ * Three-way comparison of two variant maps
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::order(const VariantMap &left,
+                               const VariantMap &right)
+{
+    return sequences(left, right);
+}
+
+/**
+ *
+ * Compares two sequences lexicographically, visiting each pair of elements
+ * once
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+template<typename T>
+int Variant::Comparison::sequences(const T &left, const T &right)
+{
+    auto leftIt = left.begin();
+    auto rightIt = right.begin();
+
+    for (; leftIt != left.end() && rightIt != right.end();
+         ++leftIt, ++rightIt) {
+
+        int result = order(*leftIt, *rightIt);
+
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    return order(left.size(), right.size());
+}
+
+/**
+ *
+ * Compares two variants of the same scalar type by reading their data
+ * directly
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+template<typename T, T Variant::Data::*member>
+int Variant::Comparison::scalars(const Variant &left, const Variant &right)
+{
+    return order(left.data.*member, right.data.*member);
+}
+
+/**
+ *
+ * Compares two variants after converting both with convert
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+template<typename T, T (Variant::*convert)() const>
+int Variant::Comparison::converted(const Variant &left, const Variant &right)
+{
+    return order((left.*convert)(), (right.*convert)());
+}
+
+/**
+ *
+ * Compares variants where at least one side is null. Nulls only equal nulls
+ * and sort before everything else.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::nulls(const Variant &left, const Variant &right)
+{
+    return (left.type != D_NULL) - (right.type != D_NULL);
+}
+
+/**
+ *
+ * Compares two strings or two blobs byte by byte
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::strings(const Variant &left, const Variant &right)
+{
+    return left.compareString(right);
+}
+
+/**
+ *
+ * Compares two string vectors
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::stringVectors(const Variant &left,
+                                       const Variant &right)
+{
+    return order(left.sharedValue<std::vector<std::string>>(),
+                 right.sharedValue<std::vector<std::string>>());
+}
+
+/**
+ *
+ * Compares two variant vectors
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::variantVectors(const Variant &left,
+                                        const Variant &right)
+{
+    return order(left.sharedValue<VariantVector>(),
+                 right.sharedValue<VariantVector>());
+}
+
+/**
+ *
+ * Compares two variant maps
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::variantMaps(const Variant &left,
+                                     const Variant &right)
+{
+    return order(left.sharedValue<VariantMap>(),
+                 right.sharedValue<VariantMap>());
+}
+
+/**
+ *
+ * Compares variants where at least one side is a hash map. Hash maps have no
+ * order of their own, so unequal ones are ordered by their keys converted to
+ * strings.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::variantHashMaps(const Variant &left,
+                                         const Variant &right)
+{
+    if (left.type == right.type) {
+
+        if (left.sharedValue<VariantHashMap>()
+                == right.sharedValue<VariantHashMap>()) {
+            return 0;
+        }
+    } else if (left.toVariantHashMap() == right.toVariantHashMap()) {
+        return 0;
+    }
+
+    return order(left.toVariantMap(), right.toVariantMap());
+}
+
+/**
+ *
+ * Compares query results by their unique ids
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return Less than, equal to or greater than zero
+ */
+int Variant::Comparison::queryResults(const Variant &left,
+                                      const Variant &right)
+{
+    if (left.type == right.type) {
+        return left.sharedValue<QueryResult>().uid.compare(
+                right.sharedValue<QueryResult>().uid);
+    }
+
+    return left.toQueryResult().uid.compare(right.toQueryResult().uid);
+}
+
+/**
+ *
+ * Compares a float with a double. Because of precision differences values
+ * that are very close count as equal. Realistically, this comparison
+ * shouldn't ever happen >.<
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::mixedFloats(const Variant &left,
+                                     const Variant &right)
+{
+    double difference = left.toDouble() - right.toDouble();
+
+    if (fabs(difference) < 0.00001) {
+        return 0;
+    }
+
+    return difference < 0 ? -1 : 1;
+}
+
+/**
+ *
+ * Compares two integers of different types without narrowing either. Signed
+ * values compare as long long and unsigned values as unsigned long long; a
+ * negative value is less than any unsigned one. Booleans are 0 and 1.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::integers(const Variant &left, const Variant &right)
+{
+    bool leftUnsigned = isUnsigned(left.type);
+    bool rightUnsigned = isUnsigned(right.type);
+
+    if (!leftUnsigned && !rightUnsigned) {
+        return order(left.toLongLong(), right.toLongLong());
+    } else if (leftUnsigned && rightUnsigned) {
+        return order(left.toULongLong(), right.toULongLong());
+    } else if (!leftUnsigned) {
+        long long value = left.toLongLong();
+
+        return value < 0 ? -1 : order(static_cast<unsigned long long>(value),
+                                      right.toULongLong());
+    }
+
+    long long value = right.toLongLong();
+
+    return value < 0 ? 1 : order(left.toULongLong(),
+                                 static_cast<unsigned long long>(value));
+}
+
+/**
+ *
+ * Compares an integer with a float or double exactly, rather than rounding
+ * the integer to the floating point type. NaN is greater than every integer.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::integerWithFloat(const Variant &left,
+                                          const Variant &right)
+{
+    if (isFloat(left.type)) {
+        return -integerWithFloat(right, left);
+    }
+
+    // 2^63 and 2^64, the bounds of the integer types
+    const double signedLimit = 9223372036854775808.0;
+    const double unsignedLimit = 18446744073709551616.0;
+    double number = right.toDouble();
+
+    if (number != number) {
+        return -1;
+    } else if (isUnsigned(left.type)) {
+
+        if (number < 0) {
+            return 1;
+        } else if (number >= unsignedLimit) {
+            return -1;
+        }
+
+        auto whole = static_cast<unsigned long long>(number);
+        int result = order(left.toULongLong(), whole);
+
+        return result != 0 ? result : order(0.0, number - whole);
+    }
+
+    if (number < -signedLimit) {
+        return 1;
+    } else if (number >= signedLimit) {
+        return -1;
+    }
+
+    auto whole = static_cast<long long>(number);
+    int result = order(left.toLongLong(), whole);
+
+    return result != 0 ? result
+                       : order(0.0, number - static_cast<double>(whole));
+}
+
+/**
+ *
+ * Compares two dates through their packed values. Whether they have a time
+ * part is ignored.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::dates(const Variant &left, const Variant &right)
+{
+    return order(left.data.longLongValue >> 1, right.data.longLongValue >> 1);
+}
+
+/**
+ *
+ * Compares two decimals exactly
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::decimals(const Variant &left, const Variant &right)
+{
+    return left.data.decimalValue.compare(right.data.decimalValue);
+}
+
+/**
+ *
+ * Compares a decimal with another type. Floating point values compare as
+ * doubles; everything else is converted to a decimal.
+ *
+ * @param left The left value
+ * @param right The right value
+ * @return -1, 0 or 1
+ */
+int Variant::Comparison::mixedDecimals(const Variant &left,
+                                       const Variant &right)
+{
+    if (isFloat(left.type) || isFloat(right.type)) {
+        return order(left.toDouble(), right.toDouble());
+    }
+
+    return left.toDecimal().compare(right.toDecimal());
+}
+
+/**
+ *
+ * Returns true for the floating point types
+ *
+ * @param type The type id
+ * @return bool
+ */
+constexpr bool Variant::Comparison::isFloat(int type)
+{
+    return type == D_FLOAT || type == D_DOUBLE;
+}
+
+/**
+ *
+ * Returns true for the integer types, including booleans
+ *
+ * @param type The type id
+ * @return bool
+ */
+constexpr bool Variant::Comparison::isInteger(int type)
+{
+    return type == D_SHORT || type == D_USHORT || type == D_INT
+           || type == D_UINT || type == D_LONG || type == D_ULONG
+           || type == D_LONGLONG || type == D_ULONGLONG || type == D_BOOLEAN;
+}
+
+/**
+ *
+ * Returns true for the unsigned integer types whose values may not fit in a
+ * long long
+ *
+ * @param type The type id
+ * @return bool
+ */
+constexpr bool Variant::Comparison::isUnsigned(int type)
+{
+    return type == D_UINT || type == D_ULONG || type == D_ULONGLONG;
+}
+
+/**
+ *
+ * Picks the comparator for two variants of the same type
+ *
+ * @param type The type id
+ * @return Comparator
+ */
+constexpr Variant::Comparison::Comparator Variant::Comparison::sameType(
+        int type)
+{
+    return type == D_STRING || type == D_BLOB ? &strings
+        : type == D_STRINGVECTOR ? &stringVectors
+        : type == D_VARIANTVECTOR ? &variantVectors
+        : type == D_VARIANTMAP ? &variantMaps
+        : type == D_VARIANTHASHMAP ? &variantHashMaps
+        : type == D_QUERYRESULT ? &queryResults
+        : type == D_ULONG ? &scalars<unsigned long, &Data::ulongValue>
+        : type == D_ULONGLONG
+            ? &scalars<unsigned long long, &Data::ulongLongValue>
+        : type == D_LONG ? &scalars<long, &Data::longValue>
+        : type == D_LONGLONG ? &scalars<long long, &Data::longLongValue>
+        : type == D_UINT ? &scalars<unsigned int, &Data::uintValue>
+        : type == D_INT ? &scalars<int, &Data::intValue>
+        : type == D_USHORT ? &scalars<unsigned short, &Data::ushortValue>
+        : type == D_SHORT ? &scalars<short, &Data::shortValue>
+        : type == D_FLOAT ? &scalars<float, &Data::floatValue>
+        : type == D_DOUBLE ? &scalars<double, &Data::doubleValue>
+        : type == D_BOOLEAN ? &scalars<bool, &Data::boolean>
+        : type == D_POINTER ? &scalars<void *, &Data::pointer>
+        : type == D_DATETIME ? &dates
+        : type == D_DECIMAL ? &decimals
+        : &nulls;
+}
+
+/**
+ *
+ * Picks the comparator for two variants of different types, where type is
+ * the greater of the two. Using the greater type makes the result the same
+ * whichever side each variant is on. Floating point types are greater than
+ * strings so that 1.0 equals "1". Pairs of numbers are handled by select().
+ *
+ * @param type The greater type id
+ * @return Comparator
+ */
+constexpr Variant::Comparison::Comparator Variant::Comparison::mixedType(
+        int type)
+{
+    return type == D_STRING || type == D_BLOB
+            ? &converted<const std::string, &Variant::toString>
+        : type == D_STRINGVECTOR
+            ? &converted<const std::vector<std::string>,
+                         &Variant::toStringVector>
+        : type == D_VARIANTVECTOR
+            ? &converted<const VariantVector, &Variant::toVariantVector>
+        : type == D_VARIANTMAP
+            ? &converted<const VariantMap, &Variant::toVariantMap>
+        : type == D_VARIANTHASHMAP ? &variantHashMaps
+        : type == D_QUERYRESULT ? &queryResults
+        : type == D_ULONG ? &converted<const unsigned long, &Variant::toULong>
+        : type == D_ULONGLONG
+            ? &converted<const unsigned long long, &Variant::toULongLong>
+        : type == D_LONG ? &converted<const long, &Variant::toLong>
+        : type == D_LONGLONG
+            ? &converted<const long long, &Variant::toLongLong>
+        : type == D_UINT ? &converted<const unsigned int, &Variant::toUInt>
+        : type == D_INT ? &converted<const int, &Variant::toInt>
+        : type == D_USHORT
+            ? &converted<const unsigned short, &Variant::toUShort>
+        : type == D_SHORT ? &converted<const short, &Variant::toShort>
+        : type == D_FLOAT ? &converted<const float, &Variant::toFloat>
+        : type == D_DOUBLE ? &converted<const double, &Variant::toDouble>
+        : type == D_BOOLEAN ? &converted<const bool, &Variant::toBool>
+        : type == D_POINTER
+            ? &converted<ArbitraryPointer *, &Variant::toPointer>
+        : type == D_DATETIME
+            ? &converted<const DateTime, &Variant::toDateTime>
+        : type == D_DECIMAL ? &mixedDecimals
+        : &nulls;
+}
+
+/**
+ *
+ * Picks the comparator for a pair of types. Numbers of different types are
+ * compared by value, never by narrowing one to the other's type.
+ *
+ * @param left The left type id
+ * @param right The right type id
+ * @return Comparator
+ */
+constexpr Variant::Comparison::Comparator Variant::Comparison::select(
+        int left, int right)
+{
+    return left == right ? sameType(left)
+        : left == D_NULL || right == D_NULL ? &nulls
+        : isFloat(left) && isFloat(right) ? &mixedFloats
+        : isInteger(left) && isInteger(right) ? &integers
+        : (isInteger(left) && isFloat(right))
+          || (isFloat(left) && isInteger(right)) ? &integerWithFloat
+        : mixedType(left > right ? left : right);
+}
+
+/**
+ *
+ * Builds the comparator table. Entry i compares type (i / TYPE_COUNT) with
+ * type (i % TYPE_COUNT), each scaled by TYPE_STEP.
+ *
+ * @return Table
+ */
+template<int... Index>
+constexpr Variant::Comparison::Table Variant::Comparison::makeTable(
+        Indices<Index...>)
+{
+    return Table{{select(Index / TYPE_COUNT * TYPE_STEP,
+                         Index % TYPE_COUNT * TYPE_STEP)...}};
+}
+
+const Variant::Comparison::Table Variant::Comparison::table =
+        Variant::Comparison::makeTable(
+                Variant::Comparison::MakeIndices<
+                        Variant::Comparison::TYPE_COUNT
+                        * Variant::Comparison::TYPE_COUNT>::Type());
+
+/**
+ * Compares this variant with the one identified by value. Numbers of
+ * different types compare by value. Other values of different types are
+ * converted to the greater of the two types first, so the result doesn't
+ * depend on which side each is on. Nulls sort first.
+ *
+ * @param value The value to compare
+ * @return Less than, equal to or greater than zero if this is less than, equal
+ *         to or greater than value
+ */
+int Variant::compare(const Variant &value) const
+{
+    return Comparison::table.comparators[
+            type / Comparison::TYPE_STEP * Comparison::TYPE_COUNT
+            + value.type / Comparison::TYPE_STEP](*this, value);
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if they
+ * are the same. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object equals value, else false
+ */
+bool Variant::operator==(const Variant &value) const
+{
+    return compare(value) == 0;
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if this
+ * is greater than value. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object is greater than value, else false
+ */
+bool Variant::operator>(const Variant &value) const
+{
+    return compare(value) > 0;
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if this
+ * is less than value. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object is less than value, else false
+ */
+bool Variant::operator<(const Variant &value) const
+{
+    return compare(value) < 0;
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if they
+ * differ. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object does not equal value, else false
+ */
+bool Variant::operator!=(const Variant &value) const
+{
+    return compare(value) != 0;
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if this
+ * is greater than or equal to value. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object is greater than or equal to value, else false
+ */
+bool Variant::operator>=(const Variant &value) const
+{
+    return compare(value) >= 0;
+}
+
+/**
+ * Compares this variant with the one identified by value. Returns true if this
+ * is less than or equal to value. Else false.
+ *
+ * @param value The value to compare
+ * @return True if this object is less than or equal to value, else false
+ */
+bool Variant::operator<=(const Variant &value) const
+{
+    return compare(value) <= 0;
+}
+
+/**
+ *
+ * Checks if this variant represents nullptr. Returns true if so else false.
+ *
+ * @return bool
+ */
+const bool Variant::isNull() const
+{
+    return type == D_NULL || (type == D_POINTER && data.pointer == nullptr);
+}
+
+/**
+ *
+ * Converts this variant to a string. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The string representation of this variant
+ */
+const std::string Variant::toString() const
+{
+    char buffer[NumericConversion::BUFFER_SIZE];
+
+    switch (type) {
+    case D_POINTER:
+        return "";
+    case D_STRING:
+    {
+        size_t length;
+        auto string = asString(&length);
+        return std::string(string, length);
+    }
+    case D_VARIANTVECTOR:
+    {
+        auto &vector = sharedValue<VariantVector>();
+        if (vector.size() == 0) {
+            return "";
+        }
+        return vector.at(0).toString();
+    }
+    case D_STRINGVECTOR:
+    {
+        auto &vector = sharedValue<std::vector<std::string>>();
+        if (vector.size() == 0) {
+            return "";
+        }
+        return vector.at(0);
+    }
+    case D_DOUBLE:
+        return std::string(buffer, NumericConversion::formatDouble(
+                               buffer, data.doubleValue));
+    case D_FLOAT:
+        return std::string(buffer, NumericConversion::formatDouble(
+                               buffer, data.floatValue));
+    case D_SHORT:
+        return std::string(buffer, NumericConversion::formatInteger(
+                               buffer, data.shortValue));
+    case D_USHORT:
+        return std::string(buffer, NumericConversion::formatUnsigned(
+                               buffer, data.ushortValue));
+    case D_BOOLEAN:
+        if (data.boolean) {
+            return "true";
+        } else {
+            return "false";
+        }
+    case D_INT:
+        return std::string(buffer, NumericConversion::formatInteger(
+                               buffer, data.intValue));
+    case D_UINT:
+        return std::string(buffer, NumericConversion::formatUnsigned(
+                               buffer, data.uintValue));
+    case D_LONG:
+        return std::string(buffer, NumericConversion::formatInteger(
+                               buffer, data.longValue));
+    case D_ULONG:
+        return std::string(buffer, NumericConversion::formatUnsigned(
+                               buffer, data.ulongValue));
+    case D_LONGLONG:
+        return std::string(buffer, NumericConversion::formatInteger(
+                               buffer, data.longLongValue));
+    case D_ULONGLONG:
+        return std::string(buffer, NumericConversion::formatUnsigned(
+                               buffer, data.ulongLongValue));
+    case D_DATETIME:
+        return std::string(buffer, toDateTime().format(buffer));
+    case D_DECIMAL:
+        return std::string(buffer, data.decimalValue.format(buffer));
+    case D_BLOB:
+    {
+        size_t length;
+        auto string = bytes(&length);
+        return std::string(string, length);
+    }
+    case D_NULL:
+    case D_VARIANTMAP:
+    case D_VARIANTHASHMAP:
+    default:
+        return "";
+    }
+}
+
+/**
+ *
+ * Converts this variant to a string vector. If the data happens to be a variant
+ * vector, it is iterated and each element converted. Other data types will be
+ * inserted into a new vector as the first element.
+ *
+ * @return The string vector representation of this variant
+ */
+const std::vector<std::string> Variant::toStringVector() const
+{
+    std::vector<std::string> vector;
+
+    switch (type) {
+    case D_STRINGVECTOR:
+        return sharedValue<std::vector<std::string>>();
+    case D_VARIANTVECTOR:
+    {
+        auto &variantVector = sharedValue<VariantVector>();
+        for (VariantVector::const_iterator it = variantVector.begin();
+                it != variantVector.end(); ++it) {
+            vector.push_back((*it).toString());
+        }
+        break;
+    }
+    case D_POINTER:
+    case D_NULL:
+    case D_VARIANTMAP:
+    case D_VARIANTHASHMAP:
+        break;
+    default:
+        vector.push_back(toString());
+        break;
+    }
+
+    return vector;
+}
+
+/**
+ *
+ * Converts this variant to a variant vector. If the data happens to be a string
+ * vector, it is iterated and each element converted. Other data types will be
+ * inserted into a new vector as the first element.
+ *
+ * @return The variant vector representation of this variant
+ */
+const VariantVector Variant::toVariantVector() const
+{
+    VariantVector vector;
+
+    switch (type) {
+    case D_VARIANTVECTOR:
+        return sharedValue<VariantVector>();
+    case D_STRINGVECTOR:
+    {
+        auto &stringVector = sharedValue<std::vector<std::string>>();
+        for (std::vector<std::string>::const_iterator it = stringVector.begin();
+                it != stringVector.end(); ++it) {
+            vector.push_back(Variant(*it));
+        }
+        break;
+    }
+    case D_POINTER:
+    case D_NULL:
+    case D_VARIANTMAP:
+    case D_VARIANTHASHMAP:
+        break;
+    default:
+        vector.push_back(*this);
+        break;
+    }
+
+    return vector;
+}
+
+/**
+ *
+ * Converts this variant to a float. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The float representation of this object
+ */
+const float Variant::toFloat() const
+{
+    return numericCast<float>();
+}
+
+/**
+ *
+ * Converts this variant to a double. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The double representation of this object
+ */
+const double Variant::toDouble() const
+{
+    return numericCast<double>();
+}
+
+/**
+ *
+ * Converts this variant to a date. Strings are parsed; anything that isn't a
+ * date converts to the zero date.
+ *
+ * @return The DateTime representation of this object
+ */
+const DateTime Variant::toDateTime() const
+{
+    DateTime value;
+
+    switch (type) {
+    case D_DATETIME:
+        return DateTime::unpack(data.longLongValue);
+    case D_STRING:
+    case D_BLOB:
+    {
+        size_t length;
+        auto string = bytes(&length);
+        if (!DateTime::parse(string, length, value)) {
+            return DateTime();
+        }
+        return value;
+    }
+    case D_STRINGVECTOR:
+    case D_VARIANTVECTOR:
+        return at(0).toDateTime();
+    default:
+        return value;
+    }
+}
+
+/**
+ *
+ * Converts this variant to a fixed-point decimal. Strings that don't hold a
+ * decimal (or need more than Decimal::MAX_DIGITS digits) convert to zero.
+ *
+ * @return The Decimal representation of this object
+ */
+const Decimal Variant::toDecimal() const
+{
+    Decimal value = Decimal();
+
+    switch (type) {
+    case D_DECIMAL:
+        return data.decimalValue;
+    case D_ULONGLONG:
+        value.value = data.ulongLongValue > static_cast<unsigned long long>(
+                    std::numeric_limits<long long>::max())
+                ? std::numeric_limits<long long>::max()
+                : static_cast<long long>(data.ulongLongValue);
+        return value;
+    case D_ULONG:
+    case D_LONG:
+    case D_LONGLONG:
+    case D_UINT:
+    case D_INT:
+    case D_USHORT:
+    case D_SHORT:
+    case D_BOOLEAN:
+    case D_DATETIME:
+        value.value = toLongLong();
+        return value;
+    case D_NULL:
+    case D_POINTER:
+    case D_VARIANTMAP:
+    case D_VARIANTHASHMAP:
+    case D_QUERYRESULT:
+        return value;
+    default:
+    {
+        auto string = toString();
+        if (!Decimal::parse(string.data(), string.size(), value)) {
+            return Decimal();
+        }
+        return value;
+    }
+    }
+}
+
+/**
+ *
+ * Converts this variant to raw bytes. Strings are returned as their
+ * characters; other types as their string representation.
+ *
+ * @return The blob representation of this object
+ */
+const std::vector<unsigned char> Variant::toBlob() const
+{
+    if (type == D_STRING || type == D_BLOB) {
+
+        size_t length;
+        auto data = reinterpret_cast<const unsigned char *>(bytes(&length));
+        return std::vector<unsigned char>(data, data + length);
+    }
+
+    auto string = toString();
+    return std::vector<unsigned char>(string.begin(), string.end());
+}
+
+/**
+ *
+ * Converts this variant to a long. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The long representation of this object
+ */
+const long Variant::toLong() const
+{
+    return numericCast<long>();
+}
+
+/**
+ *
+ * Converts this variant to a long long. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The long representation of this object
+ */
+const long long Variant::toLongLong() const
+{
+    return numericCast<long long>();
+}
+
+/**
+ *
+ * Converts this variant to an unsigned long. In the event if a vector, the
+ * first element will be returned.
+ *
+ * @return The unsigned long representation of this object
+ */
+const unsigned long Variant::toULong() const
+{
+    return numericCast<unsigned long>();
+}
+
+/**
+ *
+ * Converts this variant to an unsigned long long. In the event if a vector, the
+ * first element will be returned.
+ *
+ * @return The unsigned long representation of this object
+ */
+const unsigned long long Variant::toULongLong() const
+{
+    return numericCast<unsigned long long>();
+}
+
+/**
+ *
+ * Converts this variant to an integer. In the event if a vector, the first
+ * element will be returned.
+ *
+ * @return The int representation of this object
+ */
+const int Variant::toInt() const
+{
+    return numericCast<int>();
+}
+
+/**
+ *
+ * Converts this variant to an unsigned integer. In the event if a vector, the
+ * first element will be returned.
+ *
+ * @return The unsigned int representation of this object
+ */
+const unsigned int Variant::toUInt() const
+{
+    return numericCast<unsigned int>();
+}
+
+/**
+ *
+ * Converts this variant to a short. In the event if a vector, the first element
+ * will be returned.
+ *
+ * @return The short representation of this object
+ */
+const short Variant::toShort() const
+{
+    return numericCast<short>();
+}
+
+/**
+ *
+ * Converts this variant to an unsigned short. In the event if a vector, the
+ * first element will be returned.
+ *
+ * @return The unsigned short representation of this object
+ */
+const unsigned short Variant::toUShort() const
+{
+    return numericCast<unsigned short>();
+}
+
+/**
+ *
+ * Converts this variant to a bool. In the event if a vector, the first element
+ * will be returned.
+ *
+ * @return The unsigned short representation of this object
+ */
+const bool Variant::toBool() const
+{
+    if (type != D_STRING) {
+
+        // Booleans, numbers and vectors (by way of their first element)
+        return numericCast<bool>();
+    }
+
+    size_t length;
+    auto string = asString(&length);
+
+    // Case insensitive comparison against "true"
+    if (length == 4 && ::tolower(string[0]) == 't'
+            && ::tolower(string[1]) == 'r' && ::tolower(string[2]) == 'u'
+            && ::tolower(string[3]) == 'e') {
+
+        return true;
+    } else {
+
+        // Return true if numeric cast evaluates to true
+        return parseNumber<bool>(string, length);
+    }
+}
+
+/**
+ *
+ * Converts this variant to a query result. If the stored type is not a query
+ * result, returns an empty QueryResult
+ *
+ * @return The QueryResult representation of this object
+ */
+const QueryResult Variant::toQueryResult() const
+{
+    if (type == D_QUERYRESULT) {
+
+        return sharedValue<QueryResult>();
+    }
+
+    return QueryResult();
+}
+
+/**
+ *
+ * Converts this variant to a variant map. Hash map keys are converted to
+ * strings. If the stored type is not a map, returns an empty variant map
+ *
+ * @return The variant map representation of this object
+ */
+const VariantMap Variant::toVariantMap() const
+{
+    if (type == D_VARIANTMAP) {
+
+        return sharedValue<VariantMap>();
+    } else if (type == D_VARIANTHASHMAP) {
+
+        VariantMap map;
+        auto &hashMap = sharedValue<VariantHashMap>();
+
+        for (auto it = hashMap.begin(); it != hashMap.end(); ++it) {
+            map[it->first.toString()] = it->second;
+        }
+
+        return map;
+    }
+
+    return VariantMap();
+}
+
+/**
+ *
+ * Converts this variant to a variant hash map. Variant map keys become string
+ * variants. If the stored type is not a map, returns an empty hash map
+ *
+ * @return The variant hash map representation of this object
+ */
+const VariantHashMap Variant::toVariantHashMap() const
+{
+    if (type == D_VARIANTHASHMAP) {
+
+        return sharedValue<VariantHashMap>();
+    } else if (type == D_VARIANTMAP) {
+
+        VariantHashMap hashMap;
+        auto &map = sharedValue<VariantMap>();
+
+        hashMap.reserve(map.size());
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            hashMap.emplace(it->first, it->second);
+        }
+
+        return hashMap;
+    }
+
+    return VariantHashMap();
+}
+
+/**
+ *
+ * Returns the characters of this string without copying them, or nullptr if
+ * this is not a string. The characters are null-terminated and remain valid
+ * for as long as this variant is unchanged.
+ *
+ * @param length If provided, receives the number of characters
+ * @return const char *
+ */
+const char *Variant::asString(size_t *length) const
+{
+    if (type != D_STRING) {
+
+        return nullptr;
+    }
+
+    return bytes(length);
+}
+
+/**
+ *
+ * Returns the bytes of a blob without copying them. The pointer stays valid for
+ * as long as this variant is alive and unmodified.
+ *
+ * @param length If not null, receives the number of bytes
+ * @return The bytes, or nullptr if this is not a blob
+ */
+const unsigned char *Variant::asBlob(size_t *length) const
+{
+    if (type != D_BLOB) {
+
+        return nullptr;
+    }
+
+    return reinterpret_cast<const unsigned char *>(bytes(length));
+}
+
+/**
+ *
+ * Returns the characters of a string or blob, wherever they are stored.
+ * Expects type to be D_STRING or D_BLOB.
+ *
+ * @param length If not null, receives the number of characters
+ * @return const char *
+ */
+const char *Variant::bytes(size_t *length) const
+{
+    if (isSmallString()) {
+
+        if (length != nullptr) {
+            *length = smallStringSize;
+        }
+
+        return data.string;
+    }
+
+    auto payload = static_cast<StringPayload *>(data.pointer);
+
+    if (length != nullptr) {
+        *length = payload->size;
+    }
+
+    return payload->string;
+}
+
+/**
+ *
+ * Returns the string vector held by this variant without copying it, or
+ * nullptr if this is not a string vector
+ *
+ * @return const std::vector<std::string> *
+ */
+const std::vector<std::string> *Variant::asStringVector() const
+{
+    if (type == D_STRINGVECTOR) {
+
+        return &sharedValue<std::vector<std::string>>();
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Returns the variant vector held by this variant without copying it, or
+ * nullptr if this is not a variant vector
+ *
+ * @return const VariantVector *
+ */
+const VariantVector *Variant::asVariantVector() const
+{
+    if (type == D_VARIANTVECTOR) {
+
+        return &sharedValue<VariantVector>();
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Returns the variant map held by this variant without copying it, or nullptr
+ * if this is not a variant map
+ *
+ * @return const VariantMap *
+ */
+const VariantMap *Variant::asVariantMap() const
+{
+    if (type == D_VARIANTMAP) {
+
+        return &sharedValue<VariantMap>();
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Returns the variant hash map held by this variant without copying it, or
+ * nullptr if this is not a variant hash map
+ *
+ * @return const VariantHashMap *
+ */
+const VariantHashMap *Variant::asVariantHashMap() const
+{
+    if (type == D_VARIANTHASHMAP) {
+
+        return &sharedValue<VariantHashMap>();
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Returns the query result held by this variant without copying it, or nullptr
+ * if this is not a query result
+ *
+ * @return const QueryResult *
+ */
+const QueryResult *Variant::asQueryResult() const
+{
+    if (type == D_QUERYRESULT) {
+
+        return &sharedValue<QueryResult>();
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Returns the number of elements held by this variant. Vectors and maps return
+ * their element count, null returns 0 and everything else is a single element.
+ *
+ * @return size_t
+ */
+size_t Variant::size() const
+{
+    switch (type) {
+    case D_NULL:
+        return 0;
+    case D_POINTER:
+        return isNull() ? 0 : 1;
+    case D_STRINGVECTOR:
+        return asStringVector()->size();
+    case D_VARIANTVECTOR:
+        return asVariantVector()->size();
+    case D_VARIANTMAP:
+        return asVariantMap()->size();
+    case D_VARIANTHASHMAP:
+        return asVariantHashMap()->size();
+    default:
+        return 1;
+    }
+}
+
+/**
+ *
+ * Returns the element at index without copying the rest of the collection. For
+ * non-vector types, index 0 returns this variant. Returns null if index is out
+ * of range.
+ *
+ * @param index The index of the element
+ * @return Variant
+ */
+Variant Variant::at(size_t index) const
+{
+    if (index >= size()) {
+
+        return Variant();
+    }
+
+    switch (type) {
+    case D_STRINGVECTOR:
+        return asStringVector()->at(index);
+    case D_VARIANTVECTOR:
+        return asVariantVector()->at(index);
+    case D_VARIANTMAP:
+    {
+        auto it = asVariantMap()->begin();
+        std::advance(it, index);
+        return it->second;
+    }
+    case D_VARIANTHASHMAP:
+    {
+        auto it = asVariantHashMap()->begin();
+        std::advance(it, index);
+        return it->second;
+    }
+    default:
+        return *this;
+    }
+}
+
+/**
+ *
+ * Hashes this variant so that equal values of related types hash equally.
+ * Numbers hash by value whatever their type (integral values as integers,
+ * others at float precision so that float and double compare as they do in
+ * operator==). Strings that hold a number, a date or a boolean hash as that
+ * value; other strings hash their bytes. A single element vector hashes as
+ * its element.
+ *
+ * Comparisons that convert lossily (true == 5, 0 == "abc") can find values
+ * equal that hash differently, so unordered containers compare keys with
+ * VariantKeyEqual, as VariantHashMap does.
+ *
+ * @return size_t
+ */
+size_t Variant::hash() const
+{
+    switch (type) {
+    case D_NULL:
+        return 0;
+    case D_POINTER:
+        return isNull() ? 0 : hashInteger(static_cast<long long>(
+                reinterpret_cast<uintptr_t>(data.pointer)));
+    case D_STRING:
+    case D_BLOB:
+    {
+        size_t length;
+        auto string = bytes(&length);
+        return hashString(string, length);
+    }
+    case D_STRINGVECTOR:
+    {
+        auto &vector = sharedValue<std::vector<std::string>>();
+        if (vector.size() == 1) {
+            return hashString(vector[0].data(), vector[0].size());
+        }
+
+        size_t hash = vector.size();
+        for (auto it = vector.begin(); it != vector.end(); ++it) {
+            hash = combineHash(hash, hashString(it->data(), it->size()));
+        }
+        return hash;
+    }
+    case D_VARIANTVECTOR:
+    {
+        auto &vector = sharedValue<VariantVector>();
+        if (vector.size() == 1) {
+            return vector[0].hash();
+        }
+
+        size_t hash = vector.size();
+        for (auto it = vector.begin(); it != vector.end(); ++it) {
+            hash = combineHash(hash, it->hash());
+        }
+        return hash;
+    }
+    case D_VARIANTMAP:
+    {
+        // Entries are summed so that the result doesn't depend on order,
+        // matching hash maps with the same contents
+        size_t hash = 0;
+        auto &map = sharedValue<VariantMap>();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            hash += combineHash(hashString(it->first.data(), it->first.size()),
+                                it->second.hash());
+        }
+        return hash;
+    }
+    case D_VARIANTHASHMAP:
+    {
+        size_t hash = 0;
+        auto &map = sharedValue<VariantHashMap>();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            hash += combineHash(it->first.hash(), it->second.hash());
+        }
+        return hash;
+    }
+    case D_BOOLEAN:
+        return hashInteger(data.boolean ? 1 : 0);
+    case D_SHORT:
+    case D_USHORT:
+    case D_INT:
+    case D_UINT:
+    case D_LONG:
+    case D_LONGLONG:
+        return hashInteger(toLongLong());
+    case D_ULONG:
+    case D_ULONGLONG:
+    {
+        auto value = toULongLong();
+        if (value > static_cast<unsigned long long>(
+                    std::numeric_limits<long long>::max())) {
+            return hashNumber(static_cast<double>(value));
+        }
+        return hashInteger(static_cast<long long>(value));
+    }
+    case D_FLOAT:
+    case D_DOUBLE:
+        return hashNumber(toDouble());
+    case D_DECIMAL:
+        if (data.decimalValue.compare(Decimal{data.decimalValue.truncate(), 0})
+                == 0) {
+            return hashInteger(data.decimalValue.truncate());
+        }
+        return hashNumber(data.decimalValue.toDouble());
+    case D_DATETIME:
+        return hashInteger(data.longLongValue >> 1);
+    case D_QUERYRESULT:
+        return asQueryResult()->uid.hash();
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * Mixes the bits of an integer (the splitmix64 finalizer)
+ *
+ * @param value The value to hash
+ * @return size_t
+ */
+size_t Variant::hashInteger(long long value)
+{
+    auto hash = static_cast<unsigned long long>(value);
+
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+
+    return static_cast<size_t>(hash);
+}
+
+/**
+ *
+ * Hashes a floating point number. Integral values hash as integers; others
+ * are reduced to float precision first.
+ *
+ * @param value The value to hash
+ * @return size_t
+ */
+size_t Variant::hashNumber(double value)
+{
+    // Within the range of long long, as integers compare with doubles
+    if (value == std::floor(value) && value >= -9223372036854775808.0
+            && value < 9223372036854775808.0) {
+
+        return hashInteger(static_cast<long long>(value));
+    }
+
+    float reduced = static_cast<float>(value);
+    uint32_t bits;
+    memcpy(&bits, &reduced, sizeof(bits));
+
+    return hashInteger(bits);
+}
+
+/**
+ *
+ * Hashes the contents of a string. Numbers, dates and booleans hash as their
+ * value; anything else hashes its bytes (FNV-1a).
+ *
+ * @param string The characters to hash
+ * @param length The number of characters in string
+ * @return size_t
+ */
+size_t Variant::hashString(const char *string, size_t length)
+{
+    double number;
+    size_t end;
+    DateTime date;
+
+    if (NumericConversion::parseDouble(string, length, number, &end)
+            && end == length) {
+        return hashNumber(number);
+    } else if (DateTime::parse(string, length, date)) {
+        return hashInteger(date.pack() >> 1);
+    } else if (length == 4 && ::tolower(string[0]) == 't'
+               && ::tolower(string[1]) == 'r' && ::tolower(string[2]) == 'u'
+               && ::tolower(string[3]) == 'e') {
+        return hashInteger(1);
+    } else if (length == 5 && ::tolower(string[0]) == 'f'
+               && ::tolower(string[1]) == 'a' && ::tolower(string[2]) == 'l'
+               && ::tolower(string[3]) == 's' && ::tolower(string[4]) == 'e') {
+        return hashInteger(0);
+    }
+
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(string[i]);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+/**
+ *
+ * Combines two hashes in an order dependent way
+ *
+ * @param hash The hash so far
+ * @param value The hash to add
+ * @return size_t
+ */
+size_t Variant::combineHash(size_t hash, size_t value)
+{
+    return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * Compares two strings byte by byte without copying them. Both this and value
+ * must be strings.
+ *
+ * @param value The string to compare against
+ * @return int Less than, equal to or greater than 0 if this string is less
+ * than, equal to or greater than value
+ */
+int Variant::compareString(const Variant &value) const
+{
+    size_t leftLength, rightLength;
+    auto left = bytes(&leftLength);
+    auto right = value.bytes(&rightLength);
+
+    auto result = memcmp(left, right, std::min(leftLength, rightLength));
+
+    if (result != 0) {
+
+        return result;
+    }
+
+    return leftLength < rightLength ? -1 : (leftLength > rightLength ? 1 : 0);
+}
+
+/**
+ * Returns this variant as a pointer, but only if that is already what it was.
+ * If not, returns nullptr.
+ *
+ * @return ArbitraryPointer *
+ */
+ArbitraryPointer *Variant::toPointer() const
+{
+    if (type == D_POINTER) {
+
+        return static_cast<ArbitraryPointer *>(data.pointer);
+    }
+
+    return nullptr;
+}
+
+/**
+ *
+ * Converts our data to the type identified by T
+ *
+ * @return a numeric-type cast of data
+ */
+template<typename T>
+T Variant::numericCast() const
+{
+    switch (type) {
     case D_STRING:
-        return toString() < value.toString();
+    {
+        size_t length;
+        auto string = asString(&length);
+        return parseNumber<T>(string, length);
+    }
     case D_STRINGVECTOR:
-        return toStringVector() < value.toStringVector();
     case D_VARIANTVECTOR:
-        return toVariantVector() < value.toVariantVector();
-    case D_VARIANTMAP:
-        return toVariantMap() < value.toVariantMap();
+    {
+        auto string = toString();
+        return parseNumber<T>(string.data(), string.size());
+    }
+    case D_BLOB:
+    {
+        size_t length;
+        auto string = bytes(&length);
+        return parseNumber<T>(string, length);
+    }
+    case D_BOOLEAN:
+        return data.boolean;
     case D_DOUBLE:
-        return toDouble() < value.toDouble();
+        return data.doubleValue;
     case D_FLOAT:
-        return toFloat() < value.toFloat();
+        return data.floatValue;
     case D_SHORT:
-        return toShort() < value.toShort();
+        return data.shortValue;
     case D_USHORT:
-        return toUShort() < value.toUShort();
-    case D_BOOLEAN:
-        return toBool() < value.toBool();
+        return data.ushortValue;
     case D_INT:
-        return toInt() < value.toInt();
+        return data.intValue;
     case D_UINT:
-        return toUInt() < value.toUInt();
+        return data.uintValue;
     case D_LONG:
-        return toLong() < value.toLong();
-    case D_LONGLONG:
-        return toLongLong() < value.toLongLong();
+        return data.longValue;
     case D_ULONG:
-        return toULong() < value.toULong();
+        return data.ulongValue;
+    case D_LONGLONG:
+        return data.longLongValue;
     case D_ULONGLONG:
-        return toULongLong() < value.toULongLong();
-    case D_QUERYRESULT:
-        return toQueryResult().uid < value.toQueryResult().uid;
+        return data.ulongLongValue;
+    case D_DATETIME:
+        return DateTime::unpack(data.longLongValue).toNumber();
+    case D_DECIMAL:
+        if (std::is_floating_point<T>::value) {
+            return data.decimalValue.toDouble();
+        }
+        return data.decimalValue.truncate();
     case D_NULL:
-        return value.isNull();
+    case D_POINTER:
+    default:
+        return 0;
     }
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if this
- * is greater than or equal to value (based on their data as converted to the
- * type of this object). Else false.
  *
- * @param value The value to compare
- * @return True if this object is greater than value, else false
+ * Parses string as the numeric type T. Values outside the range of T are
+ * clamped, as std::istream does.
+ *
+ * @param string The characters to parse (need not be null-terminated)
+ * @param length The number of characters in string
+ * @return The parsed number, or 0 if string doesn't start with one
  */
-bool Variant::operator!=(const Variant &value) const
+template<typename T>
+T Variant::parseNumber(const char *string, size_t length)
 {
-    return !(*this == value);
+    if (std::is_floating_point<T>::value) {
+
+        double value;
+        NumericConversion::parseDouble(string, length, value);
+
+        if (value > static_cast<double>(std::numeric_limits<T>::max())) {
+            return std::numeric_limits<T>::max();
+        } else if (value < static_cast<double>(
+                       std::numeric_limits<T>::lowest())) {
+            return std::numeric_limits<T>::lowest();
+        }
+
+        return static_cast<T>(value);
+    } else if (std::is_signed<T>::value) {
+
+        long long value;
+        NumericConversion::parseInteger(string, length, value);
+
+        if (value > static_cast<long long>(std::numeric_limits<T>::max())) {
+            return std::numeric_limits<T>::max();
+        } else if (value < static_cast<long long>(
+                       std::numeric_limits<T>::min())) {
+            return std::numeric_limits<T>::min();
+        }
+
+        return static_cast<T>(value);
+    } else {
+
+        unsigned long long value;
+        NumericConversion::parseUnsigned(string, length, value);
+
+        if (value > static_cast<unsigned long long>(
+                    std::numeric_limits<T>::max())) {
+            return std::numeric_limits<T>::max();
+        }
+
+        return static_cast<T>(value);
+    }
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if this
- * is less than or equal to value (based on their data as converted to the type
- * of this object). Else false.
  *
- * @param value The value to compare
- * @return True if this object is greater than or equal to value, else false
+ * Returns the type of this variant
+ *
+ * @return The type
  */
-bool Variant::operator>=(const Variant &value) const
+const DataType Variant::getType() const
 {
-    return (*this == value || (*this) > value);
+    return type;
 }
 
 /**
- * Compares this variant with the one identified by value. Returns true if this
- * is greater than or equal to value (their data comparisons return true).
- * Else false.
  *
- * @param value The value to compare
- * @return True if this object is less than or equal to value, else false
+ * Writes our data to the provided variant list.
+ *
+ * @param variant A variant object
+ * @return The original variant
  */
-bool Variant::operator<=(const Variant &value) const
+VariantVector &VariantVector::operator<<(const Variant &variant) &
+{
+    // Add to collection
+    push_back(variant);
+
+    // Return the list
+    return *this;
+}
+
+/**
+ *
+ * Moves a variant onto the end of the list.
+ *
+ * @param variant A variant object
+ * @return The original variant
+ */
+VariantVector &VariantVector::operator<<(Variant &&variant) &
 {
-    return (*this == value || (*this) < value);
+    // Add to collection
+    push_back(std::move(variant));
+
+    // Return the list
+    return *this;
 }
 
 /**
  *
- * Checks if this variant represents nullptr. Returns true if so else false.
+ * Writes our data to a temporary variant list. The list is returned as an
+ * rvalue so that it may be moved into its final destination.
  *
- * @return bool
+ * @param variant A variant object
+ * @return The original variant
  */
-const bool Variant::isNull() const
+VariantVector &&VariantVector::operator<<(const Variant &variant) &&
 {
-    return type == D_NULL || data == nullptr;
+    // Add to collection
+    push_back(variant);
+
+    // Return the list
+    return std::move(*this);
 }
 
 /**
  *
- * Converts this variant to a string. In the event if a vector, the first
- * element will be returned.
+ * Moves a variant onto the end of a temporary variant list. The list is
+ * returned as an rvalue so that it may be moved into its final destination.
  *
- * @return The string representation of this variant
+ * @param variant A variant object
+ * @return The original variant
  */
-const std::string Variant::toString() const
+VariantVector &&VariantVector::operator<<(Variant &&variant) &&
 {
-    std::stringstream stream;
+    // Add to collection
+    push_back(std::move(variant));
+
+    // Return the list
+    return std::move(*this);
+}
+
+/**
+ *
+ * Converts this to a Variant and returns the newly created object
+ *
+ * @return Variant the return variant
+ */
+const Variant VariantVector::toVariant()
+{
+    return Variant(*this);
+}
 
+/**
+ * De-initializes the data. This frees any allocated memory.
+ */
+void Variant::deinit()
+{
     switch (type) {
-    case D_POINTER:
-        return "";
-    case D_STRING:
-        return *static_cast<std::string *>(data);
-    case D_VARIANTVECTOR:
-    {
-        VariantVector vector(*static_cast<VariantVector *>(data));
-        if (vector.size() == 0) {
-            return "";
-        }
-        return vector.at(0).toString();
+        case D_NULL:
+        case D_LONG:
+        case D_LONGLONG:
+        case D_ULONG:
+        case D_ULONGLONG:
+        case D_INT:
+        case D_UINT:
+        case D_SHORT:
+        case D_USHORT:
+        case D_BOOLEAN:
+        case D_DOUBLE:
+        case D_FLOAT:
+        case D_DATETIME:
+        case D_DECIMAL:
+            // Stored inline
+            break;
+        case D_POINTER:
+            delete reinterpret_cast<ArbitraryPointer *>(data.pointer);
+            break;
+        case D_STRING:
+        case D_BLOB:
+        case D_STRINGVECTOR:
+        case D_VARIANTVECTOR:
+        case D_VARIANTMAP:
+        case D_VARIANTHASHMAP:
+        case D_QUERYRESULT:
+            if (deleteData) {
+                release();
+            }
+            break;
     }
-    case D_STRINGVECTOR:
-    {
-        std::vector<std::string> vector(
-                    *static_cast<std::vector<std::string> *>(data));
-        if (vector.size() == 0) {
-            return "";
-        }
-        return vector.at(0);
+}
+
+/**
+ * Returns the value held by our heap payload. Expects the payload to hold a T.
+ *
+ * @return const T &
+ */
+template<typename T>
+const T &Variant::sharedValue() const
+{
+    return static_cast<SharedPayload<T> *>(data.pointer)->value;
+}
+
+/**
+ * Drops our reference to the heap payload, freeing it if we were the last
+ * variant using it.
+ *
+ * @return void
+ */
+void Variant::release()
+{
+    auto payload = static_cast<Payload *>(data.pointer);
+
+    if (payload->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+
+        // Still in use elsewhere
+        return;
     }
-    case D_DOUBLE:
-        stream << *static_cast<double *>(data);
-        return stream.str();
-    case D_FLOAT:
-        stream << *static_cast<float *>(data);
-        return stream.str();
-    case D_SHORT:
-        stream << *static_cast<short *>(data);
-        return stream.str();
-    case D_USHORT:
-        stream << *static_cast<unsigned short *>(data);
-        return stream.str();
-    case D_BOOLEAN:
-        if (*static_cast<bool *>(data)) {
-            return "true";
-        } else {
-            return "false";
-        }
-    case D_INT:
-        stream << *static_cast<int *>(data);
-        return stream.str();
-    case D_UINT:
-        stream << *static_cast<unsigned int *>(data);
-        return stream.str();
-    case D_LONG:
-        stream << *static_cast<long *>(data);
-        return stream.str();
-    case D_ULONG:
-        stream << *static_cast<unsigned long *>(data);
-        return stream.str();
-    case D_NULL:
-    case D_VARIANTMAP:
-    default:
-        return "";
+
+    switch (type) {
+        case D_STRING:
+        case D_BLOB:
+            StringPayload::destroy(static_cast<StringPayload *>(payload));
+            break;
+        case D_STRINGVECTOR:
+            delete static_cast<SharedPayload<std::vector<std::string>> *>(
+                    payload);
+            break;
+        case D_VARIANTVECTOR:
+            delete static_cast<SharedPayload<VariantVector> *>(payload);
+            break;
+        case D_VARIANTMAP:
+            delete static_cast<SharedPayload<VariantMap> *>(payload);
+            break;
+        case D_VARIANTHASHMAP:
+            delete static_cast<SharedPayload<VariantHashMap> *>(payload);
+            break;
+        case D_QUERYRESULT:
+            delete static_cast<SharedPayload<QueryResult> *>(payload);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * This object is being destroyed. Lets free up the memory used by our internal
+ * data
+ *
+ * @return void
+ */
+Variant::~Variant()
+{
+    if (deleteData) {
+        deinit();
+    }
+}
+
+/**
+ *
+ * Creates an empty map
+ *
+ */
+VariantMap::VariantMap()
+{
+}
+
+/**
+ *
+ * Creates a map from a list of key/value pairs. Later duplicates are ignored,
+ * as with std::map.
+ *
+ * @param values The pairs to insert
+ */
+VariantMap::VariantMap(std::initializer_list<value_type> values)
+{
+    elements.reserve(values.size());
+
+    for (auto &value : values) {
+        insert(value);
+    }
+}
+
+/**
+ *
+ * Returns the value for key, inserting a null variant if it isn't present
+ *
+ * @param key The key to look up
+ * @return Variant&
+ */
+Variant &VariantMap::operator[](const std::string &key)
+{
+    return emplace(key).first->second;
+}
+
+/**
+ *
+ * Returns the value for key, inserting a null variant if it isn't present
+ *
+ * @param key The key to look up
+ * @return Variant&
+ */
+Variant &VariantMap::operator[](std::string &&key)
+{
+    auto it = lowerBound(key);
+
+    if (it == elements.end() || it->first != key) {
+        it = elements.emplace(it, std::move(key), Variant());
+    }
+
+    return it->second;
+}
+
+/**
+ *
+ * Returns the value for key
+ *
+ * @throws std::out_of_range if key isn't present
+ * @param key The key to look up
+ * @return Variant&
+ */
+Variant &VariantMap::at(const std::string &key)
+{
+    auto it = find(key);
+
+    if (it == elements.end()) {
+        throw std::out_of_range("VariantMap::at");
+    }
+
+    return it->second;
+}
+
+/**
+ *
+ * Returns the value for key
+ *
+ * @throws std::out_of_range if key isn't present
+ * @param key The key to look up
+ * @return const Variant&
+ */
+const Variant &VariantMap::at(const std::string &key) const
+{
+    auto it = find(key);
+
+    if (it == elements.end()) {
+        throw std::out_of_range("VariantMap::at");
     }
+
+    return it->second;
 }
 
 /**
  *
- * Converts this variant to a string vector. If the data happens to be a variant
- * vector, it is iterated and each element converted. Other data types will be
- * inserted into a new vector as the first element.
+ * Returns the element for key, or end() if it isn't present
  *
- * @return The string vector representation of this variant
+ * @param key The key to look up
+ * @return iterator
  */
-const std::vector<std::string> Variant::toStringVector() const
+VariantMap::iterator VariantMap::find(const std::string &key)
 {
-    std::vector<std::string> vector;
+    if (elements.size() > LINEAR_SEARCH_LIMIT) {
+        auto it = lowerBound(key);
 
-    switch (type) {
-    case D_STRINGVECTOR:
-        return *static_cast<std::vector<std::string> *>(data);
-    case D_VARIANTVECTOR:
-    {
-        VariantVector variantVector = *static_cast<VariantVector *>(data);
-        for (VariantVector::iterator it = variantVector.begin();
-                it != variantVector.end(); ++it) {
-            vector.push_back((*it).toString());
-        }
-        break;
+        return it != elements.end() && it->first == key ? it : elements.end();
     }
-    case D_POINTER:
-    case D_NULL:
-    case D_VARIANTMAP:
-        break;
-    default:
-        vector.push_back(toString());
-        break;
+
+    // Small maps are quicker to scan than to bisect
+    for (auto it = elements.begin(); it != elements.end(); ++it) {
+
+        if (it->first == key) {
+            return it;
+        }
     }
 
-    return vector;
+    return elements.end();
 }
 
 /**
  *
- * Converts this variant to a variant vector. If the data happens to be a string
- * vector, it is iterated and each element converted. Other data types will be
- * inserted into a new vector as the first element.
+ * Returns the element for key, or end() if it isn't present
  *
- * @return The variant vector representation of this variant
+ * @param key The key to look up
+ * @return const_iterator
  */
-const VariantVector Variant::toVariantVector() const
+VariantMap::const_iterator VariantMap::find(const std::string &key) const
 {
-    VariantVector vector;
+    if (elements.size() > LINEAR_SEARCH_LIMIT) {
+        auto it = lowerBound(key);
 
-    switch (type) {
-    case D_VARIANTVECTOR:
-        return *static_cast<VariantVector *>(data);
-    case D_STRINGVECTOR:
-    {
-        std::vector<std::string> stringVector = *static_cast<std::vector<
-                std::string> *>(data);
-        for (std::vector<std::string>::iterator it = stringVector.begin();
-                it != stringVector.end(); ++it) {
-            vector.push_back(Variant(*it));
-        }
-        break;
+        return it != elements.end() && it->first == key ? it : elements.end();
     }
-    case D_POINTER:
-    case D_NULL:
-    case D_VARIANTMAP:
-        break;
-    default:
-        vector.push_back(*this);
-        break;
+
+    // Small maps are quicker to scan than to bisect
+    for (auto it = elements.begin(); it != elements.end(); ++it) {
+
+        if (it->first == key) {
+            return it;
+        }
     }
 
-    return vector;
+    return elements.end();
 }
 
 /**
  *
- * Converts this variant to a float. In the event if a vector, the first
- * element will be returned.
+ * Returns 1 if key is present, otherwise 0
  *
- * @return The float representation of this object
+ * @param key The key to look up
+ * @return size_type
  */
-const float Variant::toFloat() const
+VariantMap::size_type VariantMap::count(const std::string &key) const
 {
-    return numericCast<float>();
+    return find(key) != elements.end() ? 1 : 0;
 }
 
 /**
  *
- * Converts this variant to a double. In the event if a vector, the first
- * element will be returned.
+ * Inserts value unless its key is already present
  *
- * @return The double representation of this object
+ * @param value The pair to insert
+ * @return The element for the key and whether it was inserted
  */
-const double Variant::toDouble() const
+std::pair<VariantMap::iterator, bool> VariantMap::insert(
+        const value_type &value)
 {
-    return numericCast<double>();
+    return emplace(value.first, value.second);
 }
 
 /**
  *
- * Converts this variant to a long. In the event if a vector, the first
- * element will be returned.
+ * Inserts value unless its key is already present
  *
- * @return The long representation of this object
+ * @param value The pair to insert
+ * @return The element for the key and whether it was inserted
  */
-const long Variant::toLong() const
+std::pair<VariantMap::iterator, bool> VariantMap::insert(value_type &&value)
 {
-    return numericCast<long>();
+    auto it = lowerBound(value.first);
+
+    if (it != elements.end() && it->first == value.first) {
+
+        // Already present
+        return std::make_pair(it, false);
+    }
+
+    return std::make_pair(elements.insert(it, std::move(value)), true);
 }
 
 /**
  *
- * Converts this variant to a long long. In the event if a vector, the first
- * element will be returned.
+ * Removes the element at position
  *
- * @return The long representation of this object
+ * @param position The element to remove
+ * @return The element following the removed one
  */
-const long long Variant::toLongLong() const
+VariantMap::iterator VariantMap::erase(const_iterator position)
 {
-    return numericCast<long long>();
+    return elements.erase(position);
 }
 
 /**
  *
- * Converts this variant to an unsigned long. In the event if a vector, the
- * first element will be returned.
+ * Removes the element for key if present
  *
- * @return The unsigned long representation of this object
+ * @param key The key to remove
+ * @return The number of elements removed
  */
-const unsigned long Variant::toULong() const
+VariantMap::size_type VariantMap::erase(const std::string &key)
 {
-    return numericCast<unsigned long>();
+    auto it = find(key);
+
+    if (it == elements.end()) {
+        return 0;
+    }
+
+    elements.erase(it);
+
+    return 1;
 }
 
 /**
  *
- * Converts this variant to an unsigned long long. In the event if a vector, the
- * first element will be returned.
+ * Returns an iterator to the first element in key order
  *
- * @return The unsigned long representation of this object
+ * @return iterator
  */
-const unsigned long long Variant::toULongLong() const
+VariantMap::iterator VariantMap::begin()
 {
-    return numericCast<unsigned long long>();
+    return elements.begin();
 }
 
 /**
  *
- * Converts this variant to an integer. In the event if a vector, the first
- * element will be returned.
+ * Returns an iterator past the last element
  *
- * @return The int representation of this object
+ * @return iterator
  */
-const int Variant::toInt() const
+VariantMap::iterator VariantMap::end()
 {
-    return numericCast<int>();
+    return elements.end();
 }
 
 /**
  *
- * Converts this variant to an unsigned integer. In the event if a vector, the
- * first element will be returned.
+ * Returns an iterator to the first element in key order
  *
- * @return The unsigned int representation of this object
+ * @return const_iterator
  */
-const unsigned int Variant::toUInt() const
+VariantMap::const_iterator VariantMap::begin() const
 {
-    return numericCast<unsigned int>();
+    return elements.begin();
 }
 
 /**
  *
- * Converts this variant to a short. In the event if a vector, the first element
- * will be returned.
+ * Returns an iterator past the last element
  *
- * @return The short representation of this object
+ * @return const_iterator
  */
-const short Variant::toShort() const
+VariantMap::const_iterator VariantMap::end() const
 {
-    return numericCast<short>();
+    return elements.end();
 }
 
 /**
  *
- * Converts this variant to an unsigned short. In the event if a vector, the
- * first element will be returned.
+ * Returns an iterator to the first element in key order
  *
- * @return The unsigned short representation of this object
+ * @return const_iterator
  */
-const unsigned short Variant::toUShort() const
+VariantMap::const_iterator VariantMap::cbegin() const
 {
-    return numericCast<unsigned short>();
+    return elements.cbegin();
 }
 
 /**
  *
- * Converts this variant to a bool. In the event if a vector, the first element
- * will be returned.
+ * Returns an iterator past the last element
  *
- * @return The unsigned short representation of this object
+ * @return const_iterator
  */
-const bool Variant::toBool() const
+VariantMap::const_iterator VariantMap::cend() const
 {
-    if (type == D_BOOLEAN) {
-
-        // Cast to bool
-        return numericCast<bool>();
-    }
-    auto data = toString();
-
-    // Convert to lowercase
-    std::transform(data.begin(), data.end(), data.begin(), ::tolower);
-
-    if (data == "true") {
-
-        return true;
-    } else {
-
-        // Return true if numeric cast evaluates to true
-        return numericCast<bool>();
-    }
+    return elements.cend();
 }
 
 /**
  *
- * Converts this variant to a query result. If the stored type is not a query
- * result, returns an empty QueryResult
+ * Returns the number of elements
  *
- * @return The QueryResult representation of this object
+ * @return size_type
  */
-const QueryResult Variant::toQueryResult() const
+VariantMap::size_type VariantMap::size() const
 {
-    if (type == D_QUERYRESULT) {
-
-        return *static_cast<QueryResult *>(data);
-    }
-
-    return QueryResult();
+    return elements.size();
 }
 
 /**
  *
- * Converts this variant to a variant map. If the stored type is not a variant
- * map, returns an empty variant map
+ * Returns true if there are no elements
  *
- * @return The variant map representation of this object
+ * @return bool
  */
-const VariantMap Variant::toVariantMap() const
+bool VariantMap::empty() const
 {
-    if (type == D_VARIANTMAP) {
-
-        return *static_cast<VariantMap *>(data);
-    }
-
-    return VariantMap();
+    return elements.empty();
 }
 
 /**
- * Returns this variant as a pointer, but only if that is already what it was.
- * If not, returns nullptr.
  *
- * @return ArbitraryPointer *
+ * Removes all elements
+ *
+ * @return void
  */
-ArbitraryPointer *Variant::toPointer() const
+void VariantMap::clear()
 {
-    return static_cast<ArbitraryPointer *>(data);
+    elements.clear();
 }
 
 /**
  *
- * Converts our data to the type identified by T
+ * Reserves room for count elements so that inserting them won't reallocate
  *
- * @return a numeric-type cast of data
+ * @param count The number of elements to reserve room for
+ * @return void
  */
-template<typename T>
-T Variant::numericCast() const
+void VariantMap::reserve(size_type count)
 {
-    switch (type) {
-    case D_STRING:
-    case D_STRINGVECTOR:
-    case D_VARIANTVECTOR:
-    {
-        T number;
-        std::istringstream stream(toString());
-        stream >> number;
-        return number;
-    }
-    case D_DOUBLE:
-        return *static_cast<double *>(data);
-    case D_FLOAT:
-        return *static_cast<float *>(data);
-    case D_SHORT:
-        return *static_cast<short *>(data);
-    case D_USHORT:
-        return *static_cast<unsigned short *>(data);
-    case D_INT:
-        return *static_cast<int *>(data);
-    case D_UINT:
-        return *static_cast<unsigned int *>(data);
-    case D_LONG:
-        return *static_cast<long *>(data);
-    case D_ULONG:
-        return *static_cast<unsigned long *>(data);
-    case D_NULL:
-    case D_POINTER:
-    default:
-        return 0;
-    }
+    elements.reserve(count);
 }
 
 /**
  *
- * Returns the type of this variant
+ * Returns true if both maps hold equal keys and values
  *
- * @return The type
+ * @param value The map to compare
+ * @return bool
  */
-const DataType Variant::getType() const
+bool VariantMap::operator==(const VariantMap &value) const
 {
-    return type;
+    return elements == value.elements;
 }
 
 /**
  *
- * Writes our data to the provided variant list.
+ * Returns true if the maps differ
  *
- * @param variant A variant object
- * @return The original variant
+ * @param value The map to compare
+ * @return bool
  */
-VariantVector &VariantVector::operator<<(const Variant &variant)
+bool VariantMap::operator!=(const VariantMap &value) const
 {
-    // Add to collection
-    push_back(variant);
+    return elements != value.elements;
+}
 
-    // Return the list
-    return *this;
+/**
+ *
+ * Compares the maps lexicographically, as std::map does
+ *
+ * @param value The map to compare
+ * @return bool
+ */
+bool VariantMap::operator<(const VariantMap &value) const
+{
+    return elements < value.elements;
 }
 
 /**
  *
- * Converts this to a Variant and returns the newly created object
+ * Compares the maps lexicographically, as std::map does
  *
- * @return Variant the return variant
+ * @param value The map to compare
+ * @return bool
  */
-const Variant VariantVector::toVariant()
+bool VariantMap::operator>(const VariantMap &value) const
 {
-    return Variant(*this);
+    return elements > value.elements;
 }
 
 /**
- * De-initializes the data. This frees any allocated memory.
+ *
+ * Returns the first element whose key isn't less than key. Keys usually
+ * arrive in order (files and result sets are written sorted), so the last
+ * element is checked before searching.
+ *
+ * @param key The key to look up
+ * @return iterator
  */
-void Variant::deinit()
+VariantMap::iterator VariantMap::lowerBound(const std::string &key)
 {
-    switch (type) {
-        case D_NULL:
-            break;
-        case D_POINTER:
-            delete reinterpret_cast<ArbitraryPointer *>(data);
-            break;
-        case D_STRING:
-            delete reinterpret_cast<std::string *>(data);
-            break;
-        case D_STRINGVECTOR:
-            delete reinterpret_cast<std::vector<std::string> *>(data);
-            break;
-        case D_VARIANTVECTOR:
-            delete reinterpret_cast<VariantVector *>(data);
-            break;
-        case D_VARIANTMAP:
-            delete reinterpret_cast<VariantMap *>(data);
-            break;
-        case D_QUERYRESULT:
-            delete reinterpret_cast<QueryResult *>(data);
-            break;
-        case D_LONG:
-            delete reinterpret_cast<long *>(data);
-            break;
-        case D_LONGLONG:
-            delete reinterpret_cast<long long *>(data);
-            break;
-        case D_ULONG:
-            delete reinterpret_cast<unsigned long *>(data);
-            break;
-        case D_ULONGLONG:
-            delete reinterpret_cast<unsigned long long *>(data);
-            break;
-        case D_INT:
-            delete reinterpret_cast<int *>(data);
-            break;
-        case D_UINT:
-            delete reinterpret_cast<unsigned int *>(data);
-            break;
-        case D_SHORT:
-            delete reinterpret_cast<short *>(data);
-            break;
-        case D_USHORT:
-            delete reinterpret_cast<unsigned short *>(data);
-            break;
-        case D_BOOLEAN:
-            delete reinterpret_cast<bool *>(data);
-            break;
-        case D_DOUBLE:
-            delete reinterpret_cast<double *>(data);
-            break;
-        case D_FLOAT:
-            delete reinterpret_cast<float *>(data);
-            break;
+    if (elements.empty() || elements.back().first < key) {
+        return elements.end();
     }
+
+    return std::lower_bound(elements.begin(), elements.end(), key,
+                            [](const value_type &element,
+                               const std::string &search) {
+        return element.first.compare(search) < 0;
+    });
 }
 
 /**
- * This object is being destroyed. Lets free up the memory used by our internal
- * data
  *
- * @return void
+ * Returns the first element whose key isn't less than key
+ *
+ * @param key The key to look up
+ * @return const_iterator
  */
-Variant::~Variant()
+VariantMap::const_iterator VariantMap::lowerBound(
+        const std::string &key) const
 {
-    if (deleteData) {
-        deinit();
+    if (elements.empty() || elements.back().first < key) {
+        return elements.end();
     }
+
+    return std::lower_bound(elements.begin(), elements.end(), key,
+                            [](const value_type &element,
+                               const std::string &search) {
+        return element.first.compare(search) < 0;
+    });
 }
 
 } // namespace RabidSQL
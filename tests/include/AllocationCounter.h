@@ -0,0 +1,44 @@
+#ifndef RABIDSQL_ALLOCATIONCOUNTER_H
+#define RABIDSQL_ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace RabidSQL {
+
+// Counts heap allocations (and the bytes requested) made through the global
+// operator new while an instance is alive. Only one counter should be active
+// at a time.
+class AllocationCounter
+{
+public:
+    static std::atomic_int count;
+    static std::atomic<size_t> byteCount;
+    static std::atomic_bool tracking;
+
+    AllocationCounter()
+    {
+        AllocationCounter::count = 0;
+        AllocationCounter::byteCount = 0;
+        AllocationCounter::tracking = true;
+    }
+
+    int allocations()
+    {
+        return AllocationCounter::count;
+    }
+
+    size_t bytes()
+    {
+        return AllocationCounter::byteCount;
+    }
+
+    ~AllocationCounter()
+    {
+        AllocationCounter::tracking = false;
+    }
+};
+
+} // namespace RabidSQL
+
+#endif //RABIDSQL_ALLOCATIONCOUNTER_H
@@ -0,0 +1,45 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace RabidSQL {
+
+std::atomic_int AllocationCounter::count(0);
+std::atomic<size_t> AllocationCounter::byteCount(0);
+std::atomic_bool AllocationCounter::tracking(false);
+
+} // namespace RabidSQL
+
+// Replace the global allocation functions so tests can count heap usage
+
+void *operator new(std::size_t size)
+{
+    if (RabidSQL::AllocationCounter::tracking) {
+        RabidSQL::AllocationCounter::count++;
+        RabidSQL::AllocationCounter::byteCount += size;
+    }
+
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
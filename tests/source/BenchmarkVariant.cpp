@@ -0,0 +1,487 @@
+#include "AllocationCounter.h"
+#include "BinaryFileStream.h"
+#include "ColumnStats.h"
+#include "ConnectionSettings.h"
+#include "QueryResult.h"
+#include "ResultRows.h"
+#include "Variant.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <list>
+#include <map>
+#include <sstream>
+
+// Benchmarks are disabled by default. Run them with
+// --gtest_filter=*Benchmark* --gtest_also_run_disabled_tests
+
+namespace RabidSQL {
+
+static const int ITERATIONS = 1000000;
+
+// Runs function ITERATIONS times and prints the cost of each call
+template<typename Function>
+static void measure(const char *name, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        function(i);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+    printf("%-32s %8.1f ns/cell\n", name,
+           static_cast<double>(elapsed) / ITERATIONS);
+}
+
+// Runs function once and prints the cost per record
+template<typename Function>
+static void measureOnce(const char *name, int records, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    function();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+    printf("%-32s %8.1f ns/record\n", name,
+           static_cast<double>(elapsed) / records);
+}
+
+// Compares numeric to string conversion against the old stringstream kernel
+TEST(BenchmarkVariant, DISABLED_NumberToString) {
+    size_t total = 0;
+
+    measure("stringstream int", [&](int i) {
+        std::stringstream stream;
+        stream << i;
+        total += stream.str().size();
+    });
+    measure("toString int", [&](int i) {
+        total += Variant(i).toString().size();
+    });
+    measure("stringstream double", [&](int i) {
+        std::stringstream stream;
+        stream << i * 0.01;
+        total += stream.str().size();
+    });
+    measure("toString double", [&](int i) {
+        total += Variant(i * 0.01).toString().size();
+    });
+
+    EXPECT_GT(total, 0u);
+}
+
+// Compares string to numeric conversion against the old istringstream kernel
+TEST(BenchmarkVariant, DISABLED_StringToNumber) {
+    Variant integer("1234567");
+    Variant decimal("124.08");
+    double total = 0;
+
+    measure("istringstream int", [&](int) {
+        int number;
+        std::istringstream stream(integer.toString());
+        stream >> number;
+        total += number;
+    });
+    measure("toInt", [&](int) {
+        total += integer.toInt();
+    });
+    measure("istringstream double", [&](int) {
+        double number;
+        std::istringstream stream(decimal.toString());
+        stream >> number;
+        total += number;
+    });
+    measure("toDouble", [&](int) {
+        total += decimal.toDouble();
+    });
+
+    EXPECT_GT(total, 0);
+}
+
+// Times sorting a 1M cell column of each common type
+TEST(BenchmarkVariant, DISABLED_SortColumn) {
+    const int cells = 1000000;
+    std::vector<Variant> integers, doubles, strings;
+
+    for (int i = 0; i < cells; i++) {
+        int value = static_cast<int>((i * 2654435761u) % cells);
+        integers.emplace_back(value);
+        doubles.emplace_back(value * 0.01);
+        strings.emplace_back("row " + std::to_string(value));
+    }
+
+    measureOnce("sort int column", cells, [&]() {
+        std::sort(integers.begin(), integers.end());
+    });
+    measureOnce("sort double column", cells, [&]() {
+        std::sort(doubles.begin(), doubles.end());
+    });
+    measureOnce("sort string column", cells, [&]() {
+        std::sort(strings.begin(), strings.end());
+    });
+
+    EXPECT_TRUE(std::is_sorted(integers.begin(), integers.end()));
+    EXPECT_TRUE(std::is_sorted(strings.begin(), strings.end()));
+}
+
+// Compares a 1M row result of an int, a double and a text column stored as a
+// list of rows (as QueryResult used to) with columnar storage
+TEST(BenchmarkVariant, DISABLED_ResultLayout) {
+    const int rowCount = 1000000;
+    std::string text = "a text cell too long to be inline #";
+    auto rowList = new std::list<VariantVector>();
+    auto result = new QueryResult();
+    long long total = 0;
+
+    {
+        AllocationCounter counter;
+        measureOnce("row list build", rowCount, [&]() {
+            for (int i = 0; i < rowCount; i++) {
+                rowList->push_back(VariantVector() << i << i * 0.5 << text);
+            }
+        });
+        printf("%-32s %8.1f bytes/row\n", "row list allocated",
+               static_cast<double>(counter.bytes()) / rowCount);
+    }
+    {
+        AllocationCounter counter;
+        measureOnce("columnar build", rowCount, [&]() {
+            result->rows.setColumnCount(3);
+
+            for (int i = 0; i < rowCount; i++) {
+                result->rows.addRow();
+                result->rows.appendTo(0).append(i);
+                result->rows.appendTo(1).append(i * 0.5);
+                result->rows.appendTo(2).appendString(text.data(),
+                                                      text.size());
+            }
+        });
+        printf("%-32s %8.1f bytes/row\n", "columnar allocated",
+               static_cast<double>(counter.bytes()) / rowCount);
+        printf("%-32s %8.1f bytes/row\n", "columnar memory",
+               static_cast<double>(result->rows.memoryUsage()) / rowCount);
+    }
+
+    measureOnce("row list column scan", rowCount, [&]() {
+        for (auto &row : *rowList) {
+            total += row[0].toInt();
+        }
+    });
+    measureOnce("columnar column scan", rowCount, [&]() {
+        for (size_t block = 0; block < result->rows.blockCount(); block++) {
+            auto &column = result->rows.column(block, 0);
+            auto values = column.integers();
+
+            for (size_t i = 0; i < column.size(); i++) {
+                total -= values[i];
+            }
+        }
+    });
+    measureOnce("row list seek to middle", 1, [&]() {
+        total += std::next(rowList->begin(), rowCount / 2)->front().toInt();
+    });
+    measureOnce("columnar seek to middle", 1, [&]() {
+        total -= result->rows.at(rowCount / 2, 0).toInt();
+    });
+    // Columnar first; freeing its large buffers makes malloc consolidate any
+    // small chunks the row list has just released
+    measureOnce("columnar teardown", rowCount, [&]() {
+        delete result;
+    });
+    measureOnce("row list teardown", rowCount, [&]() {
+        delete rowList;
+    });
+
+    EXPECT_EQ(0, total);
+}
+
+// Compares building string columns of few and of mostly distinct values
+TEST(BenchmarkVariant, DISABLED_DictionaryColumns) {
+    const int rowCount = 1000000;
+    const std::vector<std::string> countries = {
+        "Australia", "Brazil", "Canada", "Germany", "India", "Japan",
+        "Mexico", "Norway", "Spain", "United Kingdom", "United States"
+    };
+    std::vector<std::string> names;
+    ResultRows lowCardinality;
+    ResultRows distinct;
+
+    for (int i = 0; i < rowCount; i++) {
+        names.push_back("customer " + std::to_string(i));
+    }
+
+    measureOnce("low cardinality build", rowCount, [&]() {
+        lowCardinality.setColumnCount(1);
+
+        for (int i = 0; i < rowCount; i++) {
+            auto &country = countries[i % countries.size()];
+            lowCardinality.addRow();
+            lowCardinality.appendTo(0).appendString(country.data(),
+                                                    country.size());
+        }
+    });
+    printf("%-32s %8.1f bytes/row\n", "low cardinality memory",
+           static_cast<double>(lowCardinality.memoryUsage()) / rowCount);
+    printf("%-32s %8.1f bytes/row\n", "low cardinality saved",
+           static_cast<double>(lowCardinality.dictionarySavings()) / rowCount);
+
+    measureOnce("distinct build", rowCount, [&]() {
+        distinct.setColumnCount(1);
+
+        for (int i = 0; i < rowCount; i++) {
+            distinct.addRow();
+            distinct.appendTo(0).appendString(names[i].data(),
+                                              names[i].size());
+        }
+    });
+    printf("%-32s %8.1f bytes/row\n", "distinct memory",
+           static_cast<double>(distinct.memoryUsage()) / rowCount);
+
+    EXPECT_EQ(countries[5], lowCardinality.at(5, 0).toString());
+    EXPECT_EQ(names[5], distinct.at(5, 0).toString());
+}
+
+// Compares reading column statistics when a result completes with scanning
+// every column for them
+TEST(BenchmarkVariant, DISABLED_ColumnStatistics) {
+    const int rowCount = 1000000;
+    const std::vector<std::string> countries = {
+        "Australia", "Brazil", "Canada", "Germany", "India", "Japan"
+    };
+    std::vector<ColumnStats> completed;
+    std::vector<ColumnStats> scanned;
+    ResultRows rows;
+
+    measureOnce("build with statistics", rowCount, [&]() {
+        rows.setColumnCount(3);
+
+        for (int i = 0; i < rowCount; i++) {
+            auto &country = countries[i % countries.size()];
+            rows.addRow();
+            rows.appendTo(0).append(i);
+            rows.appendTo(1).append(i * 0.5);
+            rows.appendTo(2).appendString(country.data(), country.size());
+        }
+    });
+    measureOnce("statistics at completion", rowCount, [&]() {
+        completed = rows.statistics();
+    });
+    measureOnce("statistics by full scan", rowCount, [&]() {
+        scanned.resize(rows.columnCount());
+
+        for (size_t block = 0; block < rows.blockCount(); block++) {
+            for (size_t i = 0; i < rows.columnCount(); i++) {
+                scanned[i].add(rows.column(block, i));
+            }
+        }
+    });
+
+    ASSERT_EQ(3u, completed.size());
+    EXPECT_EQ(Variant(rowCount - 1), completed[0].maximum());
+    EXPECT_EQ(scanned[0].distinctCount(), completed[0].distinctCount());
+    EXPECT_EQ(countries.size(), completed[2].distinctCount());
+}
+
+// Compares storing the cells of a wide numeric table as the text getString()
+// returns with storing them as their own types, the way the MySQL driver
+// reads BIGINT, DOUBLE, DECIMAL and DATETIME columns
+TEST(BenchmarkVariant, DISABLED_WideNumericFetch) {
+    const int rowCount = 200000;
+    const int groups = 4;
+    std::vector<std::string> decimals;
+    std::vector<std::string> dates;
+    ResultRows text;
+    ResultRows typed;
+
+    for (int i = 0; i < rowCount; i++) {
+        decimals.push_back(std::to_string(i) + "." + std::to_string(i % 100));
+        dates.push_back("2021-" + std::to_string(10 + i % 3) + "-1"
+                        + std::to_string(i % 10) + " 12:34:"
+                        + std::to_string(10 + i % 50));
+    }
+
+    // Each group is a BIGINT, DOUBLE, DECIMAL and DATETIME column
+    measureOnce("text fetch", rowCount, [&]() {
+        text.setColumnCount(groups * 4);
+
+        for (int i = 0; i < rowCount; i++) {
+            text.addRow();
+
+            for (int group = 0; group < groups; group++) {
+                std::string number = std::to_string(i * 1000003ll);
+                std::string real = std::to_string(i * 0.25);
+                text.appendTo(group * 4).appendString(number.data(),
+                                                      number.size());
+                text.appendTo(group * 4 + 1).appendString(real.data(),
+                                                          real.size());
+                text.appendTo(group * 4 + 2).appendString(
+                    decimals[i].data(), decimals[i].size());
+                text.appendTo(group * 4 + 3).appendString(dates[i].data(),
+                                                          dates[i].size());
+            }
+        }
+    });
+    printf("%-32s %8.1f bytes/row\n", "text memory",
+           static_cast<double>(text.memoryUsage()) / rowCount);
+
+    measureOnce("typed fetch", rowCount, [&]() {
+        typed.setColumnCount(groups * 4);
+
+        for (int i = 0; i < rowCount; i++) {
+            typed.addRow();
+
+            for (int group = 0; group < groups; group++) {
+                Decimal decimal;
+                DateTime date;
+                Decimal::parse(decimals[i].data(), decimals[i].size(),
+                               decimal);
+                DateTime::parse(dates[i].data(), dates[i].size(), date);
+                typed.appendTo(group * 4).append(i * 1000003ll);
+                typed.appendTo(group * 4 + 1).append(i * 0.25);
+                typed.appendTo(group * 4 + 2).append(decimal);
+                typed.appendTo(group * 4 + 3).append(date);
+            }
+        }
+    });
+    printf("%-32s %8.1f bytes/row\n", "typed memory",
+           static_cast<double>(typed.memoryUsage()) / rowCount);
+
+    EXPECT_EQ(D_LONGLONG, typed.at(7, 0).getType());
+    EXPECT_EQ(D_DATETIME, typed.at(7, 3).getType());
+    EXPECT_EQ(text.at(7, 3).toString(), typed.at(7, 3).toString());
+    EXPECT_EQ(text.at(7, 2).toString(), typed.at(7, 2).toString());
+}
+
+// Times saving and loading a columnar result to and from a binary file
+TEST(BenchmarkVariant, DISABLED_ResultFileIO) {
+    const int rowCount = 1000000;
+    const char *filename = "/tmp/rabidsql-benchmark-result";
+    std::string text = "a text cell too long to be inline #";
+    QueryResult result;
+    Variant loaded;
+    BinaryFileStream stream;
+
+    result.columns = {"id", "price", "name"};
+    result.rows.setColumnCount(3);
+    for (int i = 0; i < rowCount; i++) {
+        result.rows.addRow();
+        result.rows.appendTo(0).append(i);
+        result.rows.appendTo(1).append(i * 0.5);
+        result.rows.appendTo(2).appendString(text.data(), text.size());
+    }
+    result.num_rows = rowCount;
+
+    Variant variant(result);
+    measureOnce("result binary write", rowCount, [&]() {
+        stream.open(filename, std::ios::out);
+        stream << variant;
+        stream.close();
+    });
+    measureOnce("result binary read", rowCount, [&]() {
+        stream.open(filename, std::ios::in);
+        stream >> loaded;
+        stream.close();
+    });
+    std::remove(filename);
+
+    ASSERT_EQ(D_QUERYRESULT, loaded.getType());
+    EXPECT_EQ(static_cast<size_t>(rowCount),
+              loaded.asQueryResult()->rows.size());
+    EXPECT_EQ(text, loaded.asQueryResult()->rows.at(rowCount - 1, 2)
+              .toString());
+}
+
+// The keys of a typical saved connection
+static const std::vector<std::string> SETTING_KEYS = {
+    "database", "hostname", "name", "password", "port", "socket", "type",
+    "username", "uuid", "compression"
+};
+static const int CONNECTIONS = 10000;
+
+// Fills a settings record the way loading a connection does
+template<typename Map>
+static void fillSettings(Map &map, int connection)
+{
+    for (auto &key : SETTING_KEYS) {
+        map[key] = Variant(connection);
+    }
+}
+
+// Compares building and searching 10k settings records in std::map and
+// VariantMap
+TEST(BenchmarkVariant, DISABLED_SettingsMap) {
+    std::vector<std::map<std::string, Variant>> trees(CONNECTIONS);
+    std::vector<VariantMap> flats(CONNECTIONS);
+    long long total = 0;
+
+    measureOnce("std::map build", CONNECTIONS, [&]() {
+        for (int i = 0; i < CONNECTIONS; i++) {
+            fillSettings(trees[i], i);
+        }
+    });
+    measureOnce("VariantMap build", CONNECTIONS, [&]() {
+        for (int i = 0; i < CONNECTIONS; i++) {
+            fillSettings(flats[i], i);
+        }
+    });
+    measureOnce("std::map lookup", CONNECTIONS, [&]() {
+        for (auto &map : trees) {
+            for (auto &key : SETTING_KEYS) {
+                total += map.find(key)->second.toInt();
+            }
+        }
+    });
+    measureOnce("VariantMap lookup", CONNECTIONS, [&]() {
+        for (auto &map : flats) {
+            for (auto &key : SETTING_KEYS) {
+                total += map.find(key)->second.toInt();
+            }
+        }
+    });
+
+    EXPECT_GT(total, 0);
+}
+
+// Times loading a 10k connection settings file
+TEST(BenchmarkVariant, DISABLED_SettingsLoad) {
+    std::string filename = "/tmp/rabidsql-benchmark-connection-settings";
+    std::vector<ConnectionSettings *> connections;
+
+    for (int i = 0; i < CONNECTIONS; i++) {
+        auto connection = new ConnectionSettings();
+
+        for (auto &key : SETTING_KEYS) {
+            connection->set(key, Variant(i));
+        }
+
+        connections.push_back(connection);
+    }
+
+    ConnectionSettings::save(connections, BINARY, filename);
+
+    for (auto connection : connections) {
+        delete connection;
+    }
+
+    measureOnce("ConnectionSettings::load", CONNECTIONS, [&]() {
+        connections = ConnectionSettings::load(BINARY, filename);
+    });
+
+    EXPECT_EQ(static_cast<size_t>(CONNECTIONS), connections.size());
+
+    for (auto connection : connections) {
+        delete connection;
+    }
+
+    std::remove(filename.c_str());
+}
+
+} // namespace RabidSQL
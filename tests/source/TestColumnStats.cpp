@@ -0,0 +1,159 @@
+#include "ColumnStats.h"
+#include "ResultRows.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace RabidSQL {
+
+// Tests counts and the range of typed columns
+TEST(TestColumnStats, Range) {
+    ResultColumn integers;
+    ResultColumn unsignedIntegers;
+    ResultColumn doubles;
+    ResultColumn nulls;
+    ColumnStats stats;
+
+    integers.appendNull();
+    integers.append(7);
+    integers.append(-3);
+    integers.append(7);
+    stats.add(integers);
+
+    EXPECT_EQ(4u, stats.count());
+    EXPECT_EQ(1u, stats.nullCount());
+    EXPECT_EQ(Variant(-3), stats.minimum());
+    EXPECT_EQ(Variant(7), stats.maximum());
+    EXPECT_EQ(2u, stats.distinctCount());
+
+    stats = ColumnStats();
+    unsignedIntegers.append(18446744073709551615ull);
+    unsignedIntegers.append(1ull);
+    stats.add(unsignedIntegers);
+    EXPECT_EQ(Variant(1ull), stats.minimum());
+    EXPECT_EQ(Variant(18446744073709551615ull), stats.maximum());
+
+    stats = ColumnStats();
+    doubles.append(2.5);
+    doubles.append(-0.0);
+    doubles.append(0.0);
+    stats.add(doubles);
+    EXPECT_EQ(Variant(-0.0), stats.minimum());
+    EXPECT_EQ(Variant(2.5), stats.maximum());
+    EXPECT_EQ(2u, stats.distinctCount());
+
+    stats = ColumnStats();
+    nulls.appendNull();
+    nulls.appendNull();
+    stats.add(nulls);
+    EXPECT_EQ(2u, stats.nullCount());
+    EXPECT_TRUE(stats.minimum().isNull());
+    EXPECT_EQ(0u, stats.distinctCount());
+}
+
+// Tests strings are ordered by their bytes, encoded or not
+TEST(TestColumnStats, Strings) {
+    const char *values[] = {"pear", "apple", "", "banana", "apple"};
+    ResultColumn encoded;
+    ResultColumn plain;
+    ColumnStats encodedStats;
+    ColumnStats plainStats;
+
+    for (size_t i = 0; i < 100; i++) {
+        const char *value = values[i % 5];
+        encoded.appendString(value, std::string(value).size());
+    }
+
+    encoded.appendNull();
+    ASSERT_NE(nullptr, encoded.codes());
+    encodedStats.add(encoded);
+
+    EXPECT_EQ(101u, encodedStats.count());
+    EXPECT_EQ(1u, encodedStats.nullCount());
+    EXPECT_EQ(Variant(""), encodedStats.minimum());
+    EXPECT_EQ(Variant("pear"), encodedStats.maximum());
+    EXPECT_EQ(4u, encodedStats.distinctCount());
+
+    for (size_t i = 0; i < 200; i++) {
+        std::string value = "value" + std::to_string(1000 + i);
+        plain.appendString(value.data(), value.size());
+    }
+
+    plain.finish();
+    ASSERT_EQ(nullptr, plain.codes());
+    plainStats.add(plain);
+
+    EXPECT_EQ(Variant("value1000"), plainStats.minimum());
+    EXPECT_EQ(Variant("value1199"), plainStats.maximum());
+    EXPECT_EQ(200u, plainStats.distinctCount());
+
+    // Ranges of different types can't be combined
+    ResultColumn integers;
+    integers.append(1);
+    plainStats.add(integers);
+    EXPECT_TRUE(plainStats.minimum().isNull());
+    EXPECT_TRUE(plainStats.maximum().isNull());
+    EXPECT_EQ(201u, plainStats.count());
+}
+
+// Tests the distinct estimate of many values, and of merged parts
+TEST(TestColumnStats, Distinct) {
+    ResultColumn first;
+    ResultColumn second;
+    ColumnStats stats;
+    ColumnStats other;
+
+    for (long long i = 0; i < 100000; i++) {
+        first.append(i * 7919);
+        second.append((i + 50000) * 7919);
+    }
+
+    stats.add(first);
+    EXPECT_NEAR(100000.0, static_cast<double>(stats.distinctCount()), 3000.0);
+
+    other.add(second);
+    stats.merge(other);
+    EXPECT_EQ(200000u, stats.count());
+    EXPECT_NEAR(150000.0, static_cast<double>(stats.distinctCount()), 4500.0);
+    EXPECT_EQ(Variant(0ll), stats.minimum());
+    EXPECT_EQ(Variant(149999ll * 7919), stats.maximum());
+}
+
+// Tests result rows gather statistics over every block
+TEST(TestColumnStats, ResultRows) {
+    ResultRows rows;
+    size_t count = ResultRows::BLOCK_ROWS * 2 + 10;
+
+    rows.setColumnCount(2);
+
+    for (size_t i = 0; i < count; i++) {
+        rows.addRow();
+        rows.appendTo(0).append(static_cast<long long>(i));
+
+        if (i % 2 == 0) {
+            rows.appendTo(1).appendNull();
+        } else {
+            rows.appendTo(1).appendString("odd", 3);
+        }
+    }
+
+    std::vector<ColumnStats> stats = rows.statistics();
+    ASSERT_EQ(2u, stats.size());
+    EXPECT_EQ(count, stats[0].count());
+    EXPECT_EQ(0u, stats[0].nullCount());
+    EXPECT_EQ(Variant(0ll), stats[0].minimum());
+    EXPECT_EQ(Variant(static_cast<long long>(count - 1)), stats[0].maximum());
+    EXPECT_EQ(count / 2, stats[1].nullCount());
+    EXPECT_EQ(1u, stats[1].distinctCount());
+
+    // A wider row adds a column of nulls to the earlier rows
+    rows.push_back(VariantVector() << 1ll << "even" << 2.5);
+    stats = ResultRows(rows).statistics();
+    ASSERT_EQ(3u, stats.size());
+    EXPECT_EQ(count + 1, stats[2].count());
+    EXPECT_EQ(count, stats[2].nullCount());
+    EXPECT_EQ(Variant(2.5), stats[2].maximum());
+    EXPECT_EQ(Variant("odd"), stats[1].maximum());
+}
+
+} // namespace RabidSQL
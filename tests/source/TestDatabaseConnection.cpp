@@ -1,8 +1,13 @@
 #include "ConnectionSettings.h"
 #include "DatabaseConnection.h"
 #include "DatabaseConnectionFactory.h"
+#include "SmartObject.h"
+#include "mysql/include/DatabaseConnection.h"
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <thread>
+
 namespace RabidSQL {
 
 // @TODO: Change all MySQL-specific tests that aren't testing specific
@@ -86,4 +91,495 @@ TEST(TestDatabaseConnection, GetData) {
     ASSERT_EQ("test", result.rows.front().front().toString());
 }
 
+// Tests MySQL data fetching without buffering the result. The third row
+// fails, which an unbuffered result only finds after reading the first two.
+TEST(TestDatabaseConnection, GetDataUnbuffered) {
+    const char *sql = "SELECT IF(n = 3, (SELECT n UNION ALL SELECT n), n) "
+                      "FROM (SELECT 1 AS n UNION ALL SELECT 2 "
+                      "UNION ALL SELECT 3) AS t";
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    QueryResult buffered;
+    QueryResult unbuffered;
+    QueryResult parameters;
+    VariantMap options;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+    settings.set("unbuffered", true);
+
+    // Make connection
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+
+    // Unbuffered by the connection setting
+    unbuffered = connection->execute(VariantVector() << sql);
+
+    // Buffered by the query option
+    options["unbuffered"] = false;
+    buffered = connection->execute(VariantVector() << sql << options);
+
+    // Prepared statements are always buffered
+    parameters = connection->execute(VariantVector() << sql + std::string(
+                                     " WHERE n > ?") << 0);
+
+    // Free memory
+    delete connection;
+
+    ASSERT_TRUE(unbuffered.error.isError);
+    ASSERT_EQ(2, unbuffered.rows.size());
+    EXPECT_EQ(2, unbuffered.rows.back().front().toInt());
+    ASSERT_TRUE(buffered.error.isError);
+    EXPECT_EQ(0, buffered.rows.size());
+    ASSERT_TRUE(parameters.error.isError);
+    EXPECT_EQ(0, parameters.rows.size());
+}
+
+// Tests MySQL column metadata and null cells
+TEST(TestDatabaseConnection, ColumnInfo) {
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    QueryResult result;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+
+    // Make connection
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+
+    result = connection->execute(VariantVector()
+        << "SELECT CAST(1.5 AS DECIMAL(5, 2)) AS amount, NULL AS nothing");
+
+    // Free memory
+    delete connection;
+
+    ASSERT_FALSE(result.error.isError);
+    ASSERT_EQ(2, result.columnInfo.size());
+    EXPECT_EQ("amount", result.columnInfo[0].name);
+    EXPECT_EQ(D_DECIMAL, result.columnInfo[0].type);
+    EXPECT_EQ(2u, result.columnInfo[0].decimals);
+    EXPECT_TRUE(result.columnInfo[1].nullable);
+    EXPECT_TRUE(result.rows.at(0, 1).isNull());
+}
+
+// Tests MySQL numeric columns are read as their own types
+TEST(TestDatabaseConnection, NumericColumns) {
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    QueryResult result;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+
+    // Make connection
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+
+    connection->execute(VariantVector() << "CREATE TEMPORARY TABLE "
+        "test.numbers (a INT UNSIGNED, b FLOAT, c BIT(64), d BIGINT)");
+    connection->execute(VariantVector() << "INSERT INTO test.numbers VALUES "
+        "(4294967295, 0.1, b'1111111111111111111111111111111111111111111111111"
+        "111111111111111', -9223372036854775808)");
+    result = connection->execute(VariantVector()
+                                 << "SELECT a, b, c, d FROM test.numbers");
+
+    // Free memory
+    delete connection;
+
+    ASSERT_FALSE(result.error.isError);
+    ASSERT_EQ(1, result.rows.size());
+    EXPECT_EQ(D_UINT, result.columnInfo[0].type);
+    EXPECT_EQ(4294967295u, result.rows.at(0, 0).toUInt());
+    EXPECT_EQ(D_FLOAT, result.columnInfo[1].type);
+    EXPECT_EQ("0.1", result.rows.at(0, 1).toString());
+    EXPECT_EQ(18446744073709551615ull, result.rows.at(0, 2).toULongLong());
+    EXPECT_EQ(D_LONGLONG, result.columnInfo[3].type);
+    EXPECT_EQ(-9223372036854775807ll - 1, result.rows.at(0, 3).toLongLong());
+}
+
+// Tests MySQL parameters are bound as their own types
+TEST(TestDatabaseConnection, TypedParameters) {
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    QueryResult result;
+    unsigned char bytes[] = {0, 1, 255};
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+
+    // Make connection
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+
+    result = connection->execute(VariantVector()
+        << "SELECT ? + 1 AS number, ? AS nothing, ? AS data"
+        << 9007199254740993ll << Variant() << Variant(bytes, 3));
+
+    // Free memory
+    delete connection;
+
+    ASSERT_FALSE(result.error.isError);
+    EXPECT_EQ(D_LONGLONG, result.columnInfo[0].type);
+    EXPECT_EQ(9007199254740994ll, result.rows.at(0, 0).toLongLong());
+    EXPECT_TRUE(result.rows.at(0, 1).isNull());
+    EXPECT_EQ(std::vector<unsigned char>(bytes, bytes + 3),
+              result.rows.at(0, 2).toBlob());
+}
+
+// Tests repeated MySQL queries reuse their prepared statement
+TEST(TestDatabaseConnection, StatementCache) {
+    ConnectionSettings settings;
+    MySQLDriver::DatabaseConnection *connection;
+    QueryResult first;
+    QueryResult second;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+    settings.set("statement_cache_size", 2);
+
+    // Make connection
+    connection = dynamic_cast<MySQLDriver::DatabaseConnection *>(
+        DatabaseConnectionFactory::makeConnection(&settings));
+    ASSERT_NE(nullptr, connection);
+
+    first = connection->execute(VariantVector() << "SELECT ?" << 1);
+    second = connection->execute(VariantVector() << "SELECT ?" << 2);
+    EXPECT_EQ(1u, connection->getStatementCacheHits());
+
+    // Two other statements evict it from a cache of two
+    connection->execute(VariantVector() << "SELECT 3");
+    connection->execute(VariantVector() << "SELECT 4");
+    connection->execute(VariantVector() << "SELECT ?" << 5);
+    EXPECT_EQ(1u, connection->getStatementCacheHits());
+
+    // Reconnecting starts over
+    connection->disconnect();
+    unsigned long long misses = connection->getStatementCacheMisses();
+    connection->execute(VariantVector() << "SELECT ?" << 6);
+    EXPECT_EQ(1u, connection->getStatementCacheHits());
+    EXPECT_LT(misses, connection->getStatementCacheMisses());
+
+    // Free memory
+    delete connection;
+
+    ASSERT_FALSE(second.error.isError);
+    EXPECT_EQ("1", first.rows.at(0, 0).toString());
+    EXPECT_EQ("2", second.rows.at(0, 0).toString());
+}
+
+// Tests a MySQL connection dropped by the server is made again
+TEST(TestDatabaseConnection, Reconnect) {
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    DatabaseConnection *killer;
+    QueryResult result;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+
+    // Make connections
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+    killer = DatabaseConnectionFactory::makeConnection(&settings);
+
+    result = connection->execute(VariantVector() << "SELECT CONNECTION_ID()");
+    killer->execute(VariantVector() << "KILL CONNECTION "
+                    + result.rows.at(0, 0).toString());
+
+    // Lost while it ran, so it isn't run again
+    connection->execute(VariantVector() << "SELECT 1");
+    result = connection->execute(VariantVector() << "SELECT ?" << 2);
+
+    ASSERT_FALSE(result.error.isError);
+    EXPECT_EQ(2, result.rows.at(0, 0).toInt());
+
+    // Lost inside a transaction, so the server has rolled it back and the
+    // statement isn't run again on its own
+    connection->execute(VariantVector() << "START TRANSACTION");
+    result = connection->execute(VariantVector() << "SELECT CONNECTION_ID()");
+    killer->execute(VariantVector() << "KILL CONNECTION "
+                    + result.rows.at(0, 0).toString());
+    result = connection->execute(VariantVector() << "SELECT ?" << 3);
+
+    EXPECT_TRUE(result.error.isError);
+
+    // A new session outside any transaction
+    result = connection->execute(VariantVector() << "SELECT ?" << 4);
+
+    // Free memory
+    delete killer;
+    delete connection;
+
+    ASSERT_FALSE(result.error.isError);
+    EXPECT_EQ(4, result.rows.at(0, 0).toInt());
+}
+
+// Tests a MySQL batch reports the rows each statement affected, and that the
+// connection is usable after a script fails
+TEST(TestDatabaseConnection, ExecuteBatchMySQL) {
+    ConnectionSettings settings;
+    DatabaseConnection *connection;
+    std::vector<VariantVector> statements;
+    std::vector<QueryResult> results;
+    std::vector<QueryResult> failed;
+    QueryResult after;
+
+    // Configure connection settings
+    settings.set("type", MYSQL);
+    settings.set("hostname", "localhost");
+    settings.set("username", "test");
+    settings.set("multi_statements", true);
+
+    // Make connection
+    connection = DatabaseConnectionFactory::makeConnection(&settings);
+
+    statements.push_back(VariantVector()
+                         << "CREATE TEMPORARY TABLE test.batch (a INT)");
+    statements.push_back(VariantVector()
+                         << "INSERT INTO test.batch VALUES (?), (?)" << 1 << 2);
+    statements.push_back(VariantVector() << "UPDATE test.batch SET a = a + 1");
+    statements.push_back(VariantVector() << "SELECT SUM(a) FROM test.batch");
+    results = connection->executeBatch(statements, true);
+
+    statements.clear();
+    statements.push_back(VariantVector() << "SELECT 1");
+    statements.push_back(VariantVector() << "SELECT * FROM test.missing");
+    statements.push_back(VariantVector() << "SELECT 3");
+    failed = connection->executeBatch(statements, true);
+    after = connection->execute(VariantVector() << "SELECT ?" << 4);
+
+    // Free memory
+    delete connection;
+
+    ASSERT_EQ(4u, results.size());
+
+    for (auto &result : results) {
+        ASSERT_FALSE(result.error.isError) << result.error.string;
+    }
+
+    EXPECT_EQ(2, results[1].affected_rows);
+    EXPECT_EQ(2, results[2].affected_rows);
+    EXPECT_EQ(5, results[3].rows.at(0, 0).toInt());
+
+    ASSERT_EQ(2u, failed.size());
+    EXPECT_FALSE(failed[0].error.isError);
+    EXPECT_TRUE(failed[1].error.isError);
+    ASSERT_FALSE(after.error.isError);
+    EXPECT_EQ(4, after.rows.at(0, 0).toInt());
+}
+
+// Reads a fixed number of rows the way a driver does
+class StreamingConnection : public DatabaseConnection {
+public:
+    StreamingConnection(size_t count) :
+        DatabaseConnection(nullptr),
+        count(count) {}
+
+    void disconnect() {}
+    QueryResult connect() { return QueryResult(); }
+    QueryResult getDatabases(std::vector<std::string>) { return QueryResult(); }
+    QueryResult getTables(std::string) { return QueryResult(); }
+    QueryResult selectDatabase(std::string) { return QueryResult(); }
+    QueryResult killQuery(std::string) { return QueryResult(); }
+    DatabaseConnection *clone(DatabaseConnectionManager *) { return nullptr; }
+    using DatabaseConnection::call;
+
+    QueryResult execute(VariantVector) {
+        QueryResult result;
+        result.columns.push_back("id");
+        result.rows.setColumnCount(1);
+
+        for (size_t i = 0; i < count; i++) {
+            result.rows.addRow();
+            result.rows.appendTo(0).append(static_cast<long long>(i));
+            streamRows(result);
+        }
+
+        return result;
+    }
+
+    size_t count;
+};
+
+// Collects the batches of a streamed query
+class BatchReceiver : public SmartObject {
+public:
+    void processQueueItem(const int id, const VariantVector &arguments) {
+        QueryResult result = arguments[2].toQueryResult();
+
+        if (id == DatabaseConnection::EXECUTED) {
+            executed = result;
+            finished = true;
+            return;
+        }
+
+        EXPECT_EQ(rows, arguments[3].toULongLong());
+        EXPECT_EQ("id", result.columns.front());
+
+        for (const auto &row : result.rows) {
+            EXPECT_EQ(rows++, row.front().toULongLong());
+        }
+
+        batches++;
+    }
+
+    QueryResult executed;
+    unsigned long long rows = 0;
+    int batches = 0;
+    bool finished = false;
+};
+
+// Tests a streamed query arrives in batches followed by the totals
+TEST(TestDatabaseConnection, StreamQuery) {
+    const size_t count = DatabaseConnection::STREAM_BATCH_ROWS * 2 + 100;
+    StreamingConnection connection(count);
+    BatchReceiver receiver;
+
+    connection.connectQueue(DatabaseConnection::ROWS_FETCHED, &receiver);
+    connection.connectQueue(DatabaseConnection::EXECUTED, &receiver);
+    connection.start();
+    connection.call(Variant("query"), STREAM_QUERY,
+                    VariantVector() << "SELECT id");
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!receiver.finished && std::chrono::steady_clock::now() - start
+           < std::chrono::seconds(10)) {
+        receiver.processQueue();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    connection.stop();
+
+    ASSERT_TRUE(receiver.finished);
+    EXPECT_LE(3, receiver.batches);
+    EXPECT_EQ(count, receiver.rows);
+    EXPECT_EQ(static_cast<int>(count), receiver.executed.num_rows);
+    EXPECT_TRUE(receiver.executed.rows.empty());
+}
+
+// Records the statements it is asked to run
+class RecordingConnection : public StreamingConnection {
+public:
+    RecordingConnection() : StreamingConnection(0) {}
+
+    QueryResult execute(VariantVector arguments) {
+        QueryResult result;
+        std::string sql = arguments.front().toString();
+        statements.push_back(sql);
+
+        if (sql.find("FAIL") != std::string::npos) {
+            result.error.isError = true;
+            result.error.string = "failed";
+        } else {
+            result.affected_rows = static_cast<int>(arguments.size());
+        }
+
+        return result;
+    }
+
+    std::vector<std::string> statements;
+};
+
+// Collects the results of a batch
+class ExecutedReceiver : public SmartObject {
+public:
+    void processQueueItem(const int, const VariantVector &arguments) {
+        summary = arguments[2].toQueryResult();
+        results = arguments[3].toVariantVector();
+        finished = true;
+    }
+
+    QueryResult summary;
+    VariantVector results;
+    bool finished = false;
+};
+
+// Tests a batch runs in a transaction and stops at the first error
+TEST(TestDatabaseConnection, ExecuteBatch) {
+    RecordingConnection connection;
+    ExecutedReceiver receiver;
+    VariantMap options;
+
+    options["transaction"] = true;
+    connection.connectQueue(DatabaseConnection::EXECUTED, &receiver);
+    connection.start();
+    connection.call(Variant("batch"), EXECUTE_BATCH, VariantVector()
+                    << (VariantVector() << "INSERT INTO t VALUES (?)" << 1)
+                    << (VariantVector() << "UPDATE t SET a = 2")
+                    << (VariantVector() << "FAIL")
+                    << (VariantVector() << "DELETE FROM t")
+                    << options);
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!receiver.finished && std::chrono::steady_clock::now() - start
+           < std::chrono::seconds(10)) {
+        receiver.processQueue();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    connection.stop();
+
+    ASSERT_TRUE(receiver.finished);
+    ASSERT_EQ(5u, connection.statements.size());
+    EXPECT_EQ("START TRANSACTION", connection.statements[0]);
+    EXPECT_EQ("FAIL", connection.statements[3]);
+    EXPECT_EQ("ROLLBACK", connection.statements[4]);
+    EXPECT_FALSE(receiver.summary.is_valid);
+    EXPECT_EQ("failed", receiver.summary.error.string);
+    EXPECT_EQ(3, receiver.summary.affected_rows);
+    ASSERT_EQ(3u, receiver.results.size());
+    EXPECT_EQ(2, receiver.results[0].toQueryResult().affected_rows);
+    EXPECT_TRUE(receiver.results[2].toQueryResult().error.isError);
+}
+
+// Fails to end its transactions
+class RollbackFailingConnection : public RecordingConnection {
+protected:
+    QueryResult endTransaction(bool) {
+        QueryResult result;
+        result.error.isError = true;
+        result.error.string = "lock wait timeout";
+        return result;
+    }
+};
+
+// Tests a failed rollback is reported after the error that caused it
+TEST(TestDatabaseConnection, ExecuteBatchRollbackFailure) {
+    RollbackFailingConnection connection;
+    ExecutedReceiver receiver;
+    VariantMap options;
+
+    options["transaction"] = true;
+    connection.connectQueue(DatabaseConnection::EXECUTED, &receiver);
+    connection.start();
+    connection.call(Variant("batch"), EXECUTE_BATCH, VariantVector()
+                    << (VariantVector() << "FAIL")
+                    << options);
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!receiver.finished && std::chrono::steady_clock::now() - start
+           < std::chrono::seconds(10)) {
+        receiver.processQueue();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    connection.stop();
+
+    ASSERT_TRUE(receiver.finished);
+    EXPECT_FALSE(receiver.summary.is_valid);
+    EXPECT_EQ("failed; ROLLBACK failed: lock wait timeout",
+              receiver.summary.error.string);
+}
+
 } // namespace RabidSQL
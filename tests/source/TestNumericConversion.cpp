@@ -0,0 +1,175 @@
+#include "AllocationCounter.h"
+#include "NumericConversion.h"
+#include "Variant.h"
+#include "gtest/gtest.h"
+
+#include <climits>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+namespace RabidSQL {
+
+// Formats value the way Variant::toString used to
+template<typename T>
+static std::string streamFormat(T value)
+{
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+}
+
+// Parses value the way Variant::numericCast used to
+template<typename T>
+static T streamParse(const std::string &value)
+{
+    T number = 0;
+    std::istringstream stream(value);
+    stream >> number;
+    return number;
+}
+
+static std::string formatDouble(double value)
+{
+    char buffer[NumericConversion::BUFFER_SIZE];
+    return std::string(buffer, NumericConversion::formatDouble(buffer, value));
+}
+
+// Tests integer formatting, including the extremes
+TEST(TestNumericConversion, FormatInteger) {
+    char buffer[NumericConversion::BUFFER_SIZE];
+    long long values[] = {0, 1, -1, 9, 10, -10, 123456789, LLONG_MAX,
+                          LLONG_MIN};
+
+    for (auto value : values) {
+        EXPECT_EQ(streamFormat(value), std::string(buffer,
+                NumericConversion::formatInteger(buffer, value)));
+    }
+
+    EXPECT_EQ(streamFormat(ULLONG_MAX), std::string(buffer,
+            NumericConversion::formatUnsigned(buffer, ULLONG_MAX)));
+}
+
+// Tests double formatting matches std::ostream
+TEST(TestNumericConversion, FormatDouble) {
+    double values[] = {0.0, -0.0, 1.0, -1.5, 0.1, 124.08, 1e-5, 0.0001,
+                       123456.0, 1234567.0, 999999.5, 9999995.0, 0.5,
+                       2.5e-300, 1.7976931348623157e308, 1e22, 1e23,
+                       3.14159265358979, 100.0, 1e6, 1e-4};
+
+    for (auto value : values) {
+        EXPECT_EQ(streamFormat(value), formatDouble(value)) << value;
+    }
+
+    EXPECT_EQ(streamFormat(INFINITY), formatDouble(INFINITY));
+    EXPECT_EQ(streamFormat(-INFINITY), formatDouble(-INFINITY));
+
+    // Random values across a wide range of magnitudes
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> mantissa(-10.0, 10.0);
+    std::uniform_int_distribution<int> exponent(-30, 30);
+
+    for (int i = 0; i < 100000; i++) {
+        double value = mantissa(generator) * std::pow(10.0,
+                                                      exponent(generator));
+        ASSERT_EQ(streamFormat(value), formatDouble(value)) << value;
+    }
+}
+
+// Tests integer parsing follows std::istream
+TEST(TestNumericConversion, ParseInteger) {
+    const char *values[] = {"0", "42", "-42", "+7", "  12", "12abc", "124.08",
+                            "1e3", "9223372036854775807",
+                            "9223372036854775808", "-9223372036854775808",
+                            "-99999999999999999999"};
+
+    for (auto value : values) {
+        long long number;
+        EXPECT_TRUE(NumericConversion::parseInteger(value, strlen(value),
+                                                    number));
+        EXPECT_EQ(streamParse<long long>(value), number) << value;
+    }
+
+    long long number = 1;
+    EXPECT_FALSE(NumericConversion::parseInteger("abc", 3, number));
+    EXPECT_EQ(0, number);
+    EXPECT_FALSE(NumericConversion::parseInteger("- 5", 3, number));
+    EXPECT_FALSE(NumericConversion::parseInteger("", 0, number));
+
+    // The length is honoured without a null terminator
+    EXPECT_TRUE(NumericConversion::parseInteger("12345", 2, number));
+    EXPECT_EQ(12, number);
+
+    unsigned long long unsignedNumber;
+    EXPECT_TRUE(NumericConversion::parseUnsigned("-1", 2, unsignedNumber));
+    EXPECT_EQ(ULLONG_MAX, unsignedNumber);
+}
+
+// Tests double parsing follows std::istream
+TEST(TestNumericConversion, ParseDouble) {
+    const char *values[] = {"0", "1", "-1.5", "124.08", "  .5", "5.", "1e3",
+                            "2.5E-3", "0.1", "3.141592653589793",
+                            "123456789012345678901234567890", "1e300",
+                            "4.9e-324", "0.000000000000000000000001",
+                            "12.5abc"};
+
+    for (auto value : values) {
+        double number;
+        EXPECT_TRUE(NumericConversion::parseDouble(value, strlen(value),
+                                                   number));
+        EXPECT_EQ(streamParse<double>(value), number) << value;
+    }
+
+    double number = 1;
+    EXPECT_FALSE(NumericConversion::parseDouble(".", 1, number));
+    EXPECT_EQ(0, number);
+    EXPECT_FALSE(NumericConversion::parseDouble("1e", 2, number));
+    EXPECT_EQ(streamParse<double>("1e"), number);
+}
+
+// Tests formatting then parsing random integers round trips
+TEST(TestNumericConversion, IntegerRoundTrip) {
+    std::mt19937_64 generator(7);
+    char buffer[NumericConversion::BUFFER_SIZE];
+
+    for (int i = 0; i < 10000; i++) {
+        long long value = static_cast<long long>(generator());
+        long long parsed;
+        size_t length = NumericConversion::formatInteger(buffer, value);
+
+        ASSERT_TRUE(NumericConversion::parseInteger(buffer, length, parsed));
+        ASSERT_EQ(value, parsed);
+    }
+}
+
+// Tests variant numeric conversions don't allocate
+TEST(TestNumericConversion, VariantConversionAllocationFree) {
+    Variant string("124.08");
+    Variant integer(1234);
+    double number;
+
+    AllocationCounter counter;
+    number = string.toDouble();
+    EXPECT_EQ(124.08, number);
+    EXPECT_EQ(124, string.toInt());
+    EXPECT_TRUE(integer.toBool());
+    EXPECT_EQ(0, counter.allocations());
+}
+
+// Tests variant conversions between strings and numbers
+TEST(TestNumericConversion, VariantConversions) {
+    EXPECT_EQ("124.08", Variant(124.08).toString());
+    EXPECT_EQ("-12", Variant(-12).toString());
+    EXPECT_EQ("4294967295", Variant(4294967295u).toString());
+    EXPECT_EQ(SHRT_MAX, Variant("99999").toShort());
+    EXPECT_EQ(SHRT_MIN, Variant("-99999").toShort());
+    EXPECT_EQ(UINT_MAX, Variant("-1").toUInt());
+    EXPECT_TRUE(Variant(true).toBool());
+    EXPECT_FALSE(Variant(false).toBool());
+    EXPECT_TRUE(Variant("TRUE").toBool());
+    EXPECT_TRUE(Variant("1").toBool());
+    EXPECT_FALSE(Variant("0").toBool());
+    EXPECT_FALSE(Variant("false").toBool());
+}
+
+} // namespace RabidSQL
@@ -0,0 +1,227 @@
+#include "QueryResult.h"
+#include "ResultCache.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace RabidSQL {
+
+// Makes a one-column result holding value
+static QueryResult makeResult(long long value, size_t rows = 1)
+{
+    QueryResult result;
+    result.is_valid = true;
+    result.columns.push_back("value");
+    result.rows.setColumnCount(1);
+
+    for (size_t i = 0; i < rows; i++) {
+        result.rows.addRow();
+        result.rows.appendTo(0).append(value);
+    }
+
+    return result;
+}
+
+// Caches a query's result and returns its key
+static std::string cacheQuery(ResultCache &cache, const std::string &sql,
+                              long long value)
+{
+    VariantVector arguments = VariantVector() << sql;
+    std::string key = cache.makeKey(EXECUTE_QUERY, arguments, "test");
+    cache.insert(key, EXECUTE_QUERY, arguments, makeResult(value),
+                 cache.generation());
+
+    return key;
+}
+
+// Tests statements are classified and their tables found
+TEST(TestResultCache, Parse) {
+    auto select = ResultCache::parse(
+        "SELECT a.id FROM `test`.`Items` AS a JOIN orders o ON a.id = o.item "
+        "WHERE a.id IN (SELECT item FROM returns)");
+    EXPECT_EQ(ResultCache::READ, select.type);
+    EXPECT_TRUE(select.cacheable);
+    EXPECT_FALSE(select.metadata);
+    EXPECT_EQ((std::vector<std::string> {"items", "orders", "returns"}),
+              select.tables);
+
+    EXPECT_FALSE(ResultCache::parse("SELECT NOW()").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SELECT CURRENT_TIMESTAMP").cacheable);
+    EXPECT_FALSE(ResultCache::parse(
+        "SELECT * FROM t WHERE d < current_date").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SELECT CURRENT_USER, 1").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SELECT LOCALTIME").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SELECT * FROM t FOR UPDATE").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SELECT 1 INTO @a").cacheable);
+    EXPECT_TRUE(ResultCache::parse("SELECT 'now()' FROM t").cacheable);
+    EXPECT_TRUE(ResultCache::parse(
+        "SELECT * FROM information_schema.tables").metadata);
+    EXPECT_TRUE(ResultCache::parse("SHOW TABLES FROM test").cacheable);
+    EXPECT_FALSE(ResultCache::parse("SHOW PROCESSLIST").cacheable);
+
+    auto insert = ResultCache::parse(
+        "INSERT IGNORE INTO items (id) SELECT id FROM staging");
+    EXPECT_EQ(ResultCache::WRITE, insert.type);
+    EXPECT_EQ(std::vector<std::string> {"items"}, insert.tables);
+
+    auto update = ResultCache::parse(
+        "UPDATE items i JOIN orders o ON i.id = o.item SET i.sold = 1");
+    EXPECT_EQ((std::vector<std::string> {"items", "orders"}), update.tables);
+
+    auto remove = ResultCache::parse("DELETE FROM `items` WHERE id = 1");
+    EXPECT_EQ(ResultCache::WRITE, remove.type);
+    EXPECT_EQ(std::vector<std::string> {"items"}, remove.tables);
+
+    auto drop = ResultCache::parse("DROP TABLE IF EXISTS items, orders");
+    EXPECT_EQ(ResultCache::SCHEMA, drop.type);
+    EXPECT_EQ((std::vector<std::string> {"items", "orders"}), drop.tables);
+
+    auto use = ResultCache::parse("USE `shop`");
+    EXPECT_EQ(ResultCache::SESSION, use.type);
+    EXPECT_EQ("shop", use.database);
+
+    EXPECT_EQ(ResultCache::OTHER, ResultCache::parse("CALL refresh()").type);
+}
+
+// Tests keys ignore layout but not parameters, options or the database
+TEST(TestResultCache, Keys) {
+    ResultCache cache;
+    VariantVector arguments = VariantVector() << "SELECT * FROM t WHERE a = ?"
+                                              << 1;
+    VariantMap options;
+
+    EXPECT_EQ("", cache.makeKey(EXECUTE_QUERY, arguments, "test"));
+
+    cache.setLimits(1024 * 1024, 1000);
+    std::string key = cache.makeKey(EXECUTE_QUERY, arguments, "test");
+    EXPECT_NE("", key);
+
+    EXPECT_EQ(key, cache.makeKey(EXECUTE_QUERY, VariantVector()
+                                 << " SELECT *\n  FROM t WHERE a = ?;" << 1,
+                                 "test"));
+    EXPECT_NE(key, cache.makeKey(EXECUTE_QUERY, VariantVector()
+                                 << "SELECT * FROM t WHERE a = ?" << 2,
+                                 "test"));
+    EXPECT_NE(key, cache.makeKey(EXECUTE_QUERY, arguments, "other"));
+
+    // Parameters that convert to the same string bind differently
+    std::vector<std::pair<Variant, Variant>> parameters = {
+        {Variant(), ""},
+        {1, "1"},
+        {true, 1},
+        {Variant("ab", 2), Variant(reinterpret_cast<const unsigned char *>(
+                                   "ab"), 2)},
+    };
+
+    for (auto &pair : parameters) {
+        EXPECT_NE(cache.makeKey(EXECUTE_QUERY, VariantVector()
+                                << "SELECT ?" << pair.first, "test"),
+                  cache.makeKey(EXECUTE_QUERY, VariantVector()
+                                << "SELECT ?" << pair.second, "test"))
+                << pair.second.toString();
+    }
+    EXPECT_EQ("SELECT 'a  b' FROM t",
+              ResultCache::normalize("SELECT   'a  b'\tFROM t ; "));
+
+    options["unbuffered"] = true;
+    EXPECT_EQ(key, cache.makeKey(EXECUTE_QUERY, VariantVector(arguments)
+                                 << options, "test"));
+    options["cache_ttl"] = 0;
+    EXPECT_EQ("", cache.makeKey(EXECUTE_QUERY, VariantVector(arguments)
+                                << options, "test"));
+
+    EXPECT_EQ("", cache.makeKey(EXECUTE_QUERY,
+                                VariantVector() << "DELETE FROM t", "test"));
+    EXPECT_NE("", cache.makeKey(LIST_TABLES, VariantVector() << "test", ""));
+    EXPECT_EQ("", cache.makeKey(KILL_QUERY, VariantVector() << "uuid", ""));
+}
+
+// Tests cached results are found until they expire
+TEST(TestResultCache, Expiry) {
+    ResultCache cache;
+    QueryResult result;
+
+    cache.setLimits(1024 * 1024, 50);
+    std::string key = cacheQuery(cache, "SELECT value FROM t", 42);
+
+    ASSERT_TRUE(cache.find(key, result));
+    EXPECT_EQ(42, result.rows.at(0, 0).toInt());
+    EXPECT_EQ("value", result.columns.front());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+
+    EXPECT_FALSE(cache.find(key, result));
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.memoryUsage());
+}
+
+// Tests the least recently used results are evicted to fit the memory limit
+TEST(TestResultCache, Eviction) {
+    ResultCache cache;
+    QueryResult result;
+
+    cache.setLimits(1024 * 1024, 60000);
+    std::string first = cacheQuery(cache, "SELECT 1 FROM a", 1);
+    size_t entryBytes = cache.memoryUsage();
+
+    cache.setLimits(entryBytes * 2 + entryBytes / 2, 60000);
+    std::string second = cacheQuery(cache, "SELECT 2 FROM a", 2);
+
+    // Use the first, so the second is evicted by the third
+    ASSERT_TRUE(cache.find(first, result));
+    std::string third = cacheQuery(cache, "SELECT 3 FROM a", 3);
+
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_LE(cache.memoryUsage(), entryBytes * 2 + entryBytes / 2);
+    EXPECT_TRUE(cache.find(first, result));
+    EXPECT_FALSE(cache.find(second, result));
+    EXPECT_TRUE(cache.find(third, result));
+
+    // Results larger than the whole limit aren't cached
+    VariantVector arguments = VariantVector() << "SELECT * FROM big";
+    std::string key = cache.makeKey(EXECUTE_QUERY, arguments, "test");
+    cache.insert(key, EXECUTE_QUERY, arguments, makeResult(1, 100000),
+                 cache.generation());
+    EXPECT_FALSE(cache.find(key, result));
+    EXPECT_EQ(2u, cache.size());
+}
+
+// Tests writes drop only the results of the tables they touch
+TEST(TestResultCache, Invalidation) {
+    ResultCache cache;
+    QueryResult result;
+
+    cache.setLimits(1024 * 1024, 60000);
+    std::string items = cacheQuery(cache, "SELECT * FROM items", 1);
+    std::string orders = cacheQuery(cache, "SELECT * FROM test.orders", 2);
+    std::string tables = cacheQuery(cache, "SHOW TABLES", 3);
+
+    cache.invalidate("SELECT * FROM items");
+    cache.invalidate("SET @a = 1");
+    EXPECT_EQ(3u, cache.size());
+
+    cache.invalidate("UPDATE `ITEMS` SET sold = 1");
+    EXPECT_FALSE(cache.find(items, result));
+    EXPECT_TRUE(cache.find(orders, result));
+    EXPECT_TRUE(cache.find(tables, result));
+
+    // Schema changes also drop metadata
+    cache.invalidate("CREATE TABLE customers (id INT)");
+    EXPECT_TRUE(cache.find(orders, result));
+    EXPECT_FALSE(cache.find(tables, result));
+
+    // Statements the cache can't attribute drop everything
+    cache.invalidate("CALL refresh_orders()");
+    EXPECT_EQ(0u, cache.size());
+
+    // A result read while a write ran isn't cached
+    VariantVector arguments = VariantVector() << "SELECT * FROM items";
+    unsigned long long generation = cache.generation();
+    cache.invalidate("DELETE FROM items");
+    cache.insert(items, EXECUTE_QUERY, arguments, makeResult(1), generation);
+    EXPECT_FALSE(cache.find(items, result));
+}
+
+} // namespace RabidSQL
@@ -0,0 +1,310 @@
+#include "QueryResult.h"
+#include "ResultRows.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace RabidSQL {
+
+// Tests integer cells are stored in a typed array and come back as appended
+TEST(TestResultRows, IntegerColumn) {
+    ResultColumn column;
+    column.appendNull();
+    column.append(7);
+    column.appendNull();
+    column.append(-3);
+
+    EXPECT_EQ(4u, column.size());
+    EXPECT_EQ(D_INT, column.getType());
+    ASSERT_NE(nullptr, column.integers());
+    EXPECT_EQ(nullptr, column.doubles());
+    EXPECT_EQ(0, column.integers()[0]);
+    EXPECT_EQ(7, column.integers()[1]);
+    EXPECT_TRUE(column.isNull(0));
+    EXPECT_FALSE(column.isNull(1));
+    EXPECT_TRUE(column.at(2).isNull());
+    EXPECT_EQ(D_INT, column.at(3).getType());
+    EXPECT_EQ(Variant(-3), column.at(3));
+}
+
+// Tests each scalar type survives a round trip with its type intact
+TEST(TestResultRows, ScalarTypes) {
+    DateTime date;
+    Decimal decimal;
+    ASSERT_TRUE(DateTime::parse("2021-02-03 04:05:06", 19, date));
+    ASSERT_TRUE(Decimal::parse("-1.25", 5, decimal));
+
+    std::vector<Variant> values = {
+        true, (short) -2, (unsigned short) 2, 3u, -4l, 4ul, -5ll,
+        18446744073709551615ull, 1.5f, 2.25, date, decimal
+    };
+
+    for (auto &value : values) {
+        ResultColumn column;
+        column.append(value);
+        column.appendNull();
+
+        EXPECT_EQ(value.getType(), column.at(0).getType());
+        EXPECT_EQ(value, column.at(0)) << value.toString();
+        EXPECT_TRUE(column.at(1).isNull());
+    }
+}
+
+// Tests strings and blobs share one buffer and are read without copying
+TEST(TestResultRows, StringColumn) {
+    ResultColumn strings;
+    std::string longText(100, 'x');
+    strings.appendString("abc", 3);
+    strings.appendNull();
+    strings.append(longText);
+
+    size_t length;
+    const char *string = strings.asString(0, &length);
+    EXPECT_EQ(D_STRING, strings.getType());
+    EXPECT_EQ(std::string("abc"), std::string(string, length));
+    EXPECT_TRUE(strings.at(1).isNull());
+    EXPECT_EQ(Variant(longText), strings.at(2));
+
+    ResultColumn blobs;
+    const unsigned char bytes[] = {0, 1, 2, 0};
+    blobs.appendBlob(bytes, sizeof(bytes));
+
+    EXPECT_EQ(D_BLOB, blobs.at(0).getType());
+    EXPECT_EQ(std::vector<unsigned char>(bytes, bytes + sizeof(bytes)),
+              blobs.at(0).toBlob());
+}
+
+// Tests a column falls back to variants when its cells differ in type
+TEST(TestResultRows, MixedColumn) {
+    ResultColumn column;
+    column.append(1);
+    column.appendNull();
+    column.appendString("two", 3);
+    column.append(3.5);
+
+    EXPECT_EQ(D_NULL, column.getType());
+    EXPECT_EQ(nullptr, column.integers());
+    EXPECT_EQ(D_INT, column.at(0).getType());
+    EXPECT_TRUE(column.at(1).isNull());
+    EXPECT_EQ(Variant("two"), column.at(2));
+    EXPECT_EQ(Variant(3.5), column.at(3));
+}
+
+// Tests rows can still be added and read a row at a time
+TEST(TestResultRows, RowView) {
+    QueryResult result;
+    result.rows.push_back(VariantVector() << 1 << "one");
+    result.rows.push_back(VariantVector() << 2);
+    result.rows.push_back(VariantVector() << 3 << "three" << 3.0);
+
+    EXPECT_EQ(3u, result.rows.size());
+    EXPECT_EQ(3u, result.rows.columnCount());
+    EXPECT_EQ(VariantVector() << 1 << "one" << Variant(), result.rows.front());
+    EXPECT_TRUE(result.rows[1][1].isNull());
+    EXPECT_TRUE(result.rows.at(0, 2).isNull());
+    EXPECT_EQ(Variant("three"), result.rows.back()[1]);
+
+    int total = 0;
+    for (const auto &row : result.rows) {
+        total += row[0].toInt();
+    }
+    EXPECT_EQ(6, total);
+
+    // Copies are independent
+    QueryResult copy = result;
+    result.rows.clear();
+    EXPECT_TRUE(result.rows.empty());
+    EXPECT_EQ(3u, copy.rows.size());
+}
+
+// Tests columnar storage is compact
+TEST(TestResultRows, MemoryUsage) {
+    ResultRows rows;
+    rows.setColumnCount(2);
+    rows.reserve(10000);
+
+    for (int i = 0; i < 10000; i++) {
+        rows.addRow();
+        rows.appendTo(0).append(i);
+        rows.appendTo(1).appendString("0123456789", 10);
+    }
+
+    EXPECT_EQ(10000u, rows.size());
+
+    // 8 bytes per integer, 10 characters and an offset per string, and a bit
+    // per cell for nulls
+    EXPECT_GT(40u * 10000, rows.memoryUsage());
+}
+
+// Tests rows spanning several blocks are found directly and stay in place
+TEST(TestResultRows, Blocks) {
+    const size_t count = ResultRows::BLOCK_ROWS * 2 + 10;
+    ResultRows rows;
+    const long long *first = nullptr;
+
+    for (size_t i = 0; i < count; i++) {
+        rows.push_back(VariantVector() << static_cast<long long>(i));
+
+        if (i == ResultRows::BLOCK_ROWS - 1) {
+            first = rows.column(0, 0).integers();
+        }
+    }
+
+    EXPECT_EQ(count, rows.size());
+    EXPECT_EQ(3u, rows.blockCount());
+    EXPECT_EQ(Variant(static_cast<long long>(ResultRows::BLOCK_ROWS + 5)),
+              rows.at(ResultRows::BLOCK_ROWS + 5, 0));
+    EXPECT_EQ(10u, rows.column(2, 0).size());
+    EXPECT_TRUE(rows.at(count, 0).isNull());
+
+    // The first block was full before the rest were added
+    EXPECT_EQ(first, rows.column(0, 0).integers());
+    EXPECT_EQ(5, first[5]);
+
+    // New columns are backfilled in every block
+    rows.setColumnCount(2);
+    EXPECT_EQ(ResultRows::BLOCK_ROWS, rows.column(1, 1).size());
+    EXPECT_TRUE(rows.at(count - 1, 1).isNull());
+}
+
+// Tests reserving sizes blocks to the rows expected
+TEST(TestResultRows, Reserve) {
+    ResultRows rows;
+    rows.setColumnCount(1);
+    rows.reserve(100);
+
+    rows.addRow();
+    rows.appendTo(0).append(1.5);
+    const double *values = rows.column(0, 0).doubles();
+
+    for (int i = 1; i < 100; i++) {
+        rows.addRow();
+        rows.appendTo(0).append(i * 1.5);
+    }
+
+    EXPECT_EQ(values, rows.column(0, 0).doubles());
+    EXPECT_GT(100 * sizeof(double) * 2, rows.memoryUsage());
+}
+
+// Tests blocks past the memory limit are spilled and read back unchanged
+TEST(TestResultRows, Spill) {
+    const size_t count = ResultRows::BLOCK_ROWS * 3 + 7;
+    Decimal decimal;
+    ASSERT_TRUE(Decimal::parse("2.50", 4, decimal));
+
+    ResultRows rows;
+    rows.setMemoryLimit(1);
+    rows.setColumnCount(5);
+
+    for (size_t i = 0; i < count; i++) {
+        std::string text = "text " + std::to_string(i);
+        rows.addRow();
+        rows.appendTo(0).append(static_cast<long long>(i));
+        rows.appendTo(1).append(i * 0.5);
+        rows.appendTo(2).appendString(text.data(), text.size());
+
+        if (i % 3 == 0) {
+            rows.appendTo(3).appendNull();
+        } else {
+            rows.appendTo(3).append(static_cast<int>(i));
+        }
+
+        rows.appendTo(4).append(decimal);
+    }
+
+    // Every full block is over the limit; decimals stay in memory
+    EXPECT_TRUE(rows.column(0, 0).isSpilled());
+    EXPECT_TRUE(rows.column(2, 2).isSpilled());
+    EXPECT_FALSE(rows.column(0, 4).isSpilled());
+    EXPECT_FALSE(rows.column(3, 0).isSpilled());
+
+    ResultRows copy = rows;
+
+    for (size_t i = 0; i < count; i += 997) {
+        size_t length;
+        std::string text = "text " + std::to_string(i);
+        const ResultColumn &column = rows.column(i / ResultRows::BLOCK_ROWS, 2);
+        const char *string = column.asString(i % ResultRows::BLOCK_ROWS,
+                                             &length);
+
+        EXPECT_EQ(static_cast<long long>(i), rows.at(i, 0).toLongLong());
+        EXPECT_EQ(i * 0.5, rows.at(i, 1).toDouble());
+        EXPECT_EQ(text, std::string(string, length));
+        EXPECT_EQ(i % 3 == 0, copy.at(i, 3).isNull());
+        EXPECT_EQ(Variant(decimal), copy.at(i, 4));
+    }
+
+    // Spilled blocks can still take new columns
+    rows.setColumnCount(6);
+    EXPECT_TRUE(rows.at(5, 5).isNull());
+    EXPECT_EQ(Variant(5), rows.at(5, 3));
+    EXPECT_EQ(Variant(5ll), copy.at(5, 0));
+}
+
+// Tests repeated strings share a dictionary, and columns of mostly distinct
+// strings store every value
+TEST(TestResultRows, Dictionary) {
+    const size_t count = ResultRows::BLOCK_ROWS * 2 + 10;
+    const std::vector<std::string> states = {"open", "closed", "pending"};
+
+    ResultRows rows;
+    rows.setMemoryLimit(1);
+    rows.setColumnCount(2);
+
+    for (size_t i = 0; i < count; i++) {
+        std::string name = "name " + std::to_string(i);
+        rows.addRow();
+
+        if (i % 5 == 0) {
+            rows.appendTo(0).appendNull();
+        } else {
+            rows.appendTo(0).append(states[i % 3]);
+        }
+
+        rows.appendTo(1).appendString(name.data(), name.size());
+    }
+
+    const ResultColumn &status = rows.column(2, 0);
+    size_t length;
+    ASSERT_NE(nullptr, status.codes());
+    EXPECT_EQ(4u, status.dictionarySize());
+    EXPECT_EQ(D_STRING, status.getType());
+    EXPECT_TRUE(status.isNull(2));
+    EXPECT_EQ(0u, status.codes()[2]);
+    EXPECT_EQ("", std::string(status.dictionaryValue(0, &length), length));
+    EXPECT_EQ(nullptr, status.dictionaryValue(4));
+    EXPECT_TRUE(rows.column(0, 0).isSpilled());
+
+    // Distinct names aren't worth a dictionary
+    EXPECT_EQ(nullptr, rows.column(0, 1).codes());
+    EXPECT_EQ(0u, rows.column(0, 1).dictionarySize());
+
+    for (size_t i = 0; i < count; i++) {
+
+        if (i % 5 == 0) {
+            ASSERT_TRUE(rows.at(i, 0).isNull());
+        } else {
+            ASSERT_EQ(states[i % 3], rows.at(i, 0).toString());
+        }
+
+        ASSERT_EQ("name " + std::to_string(i), rows.at(i, 1).toString());
+    }
+
+    // Codes take 4 bytes a row in place of an 8 byte offset and the text
+    EXPECT_LT(count * 8, rows.dictionarySavings());
+
+    // Values added to a spilled block join its dictionary
+    ResultColumn column = rows.column(0, 0);
+    column.append("closed");
+    column.append("merged");
+    EXPECT_EQ(5u, column.dictionarySize());
+    EXPECT_EQ(Variant("closed"), column.at(ResultRows::BLOCK_ROWS));
+    EXPECT_EQ(Variant("merged"), column.at(ResultRows::BLOCK_ROWS + 1));
+
+    // Blobs of another type turn it into variants
+    column.appendBlob(reinterpret_cast<const unsigned char *>("x"), 1);
+    EXPECT_EQ(nullptr, column.codes());
+    EXPECT_EQ(Variant("merged"), column.at(ResultRows::BLOCK_ROWS + 1));
+}
+
+} // namespace RabidSQL
@@ -1,3 +1,4 @@
+#include "AllocationCounter.h"
 #include "BinaryFileStream.h"
 #include "JsonFileStream.h"
 #include "QueryResult.h"
@@ -5,6 +6,12 @@
 #include "Variant.h"
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
 namespace RabidSQL {
 
 class TestVariant : public ::testing::Test {
@@ -326,6 +333,117 @@ TEST_F(TestVariant, OperatorLTFloatString) {
     EXPECT_LT(v1, v2);
 }
 
+// Tests compare() agrees with itself when the sides are swapped and with the
+// comparison operators, for every pair of types
+TEST_F(TestVariant, CompareSymmetric) {
+    Decimal decimal;
+    DateTime date;
+    ASSERT_TRUE(Decimal::parse("12.50", 5, decimal));
+    ASSERT_TRUE(DateTime::parse("2020-01-01", 10, date));
+    const unsigned char blob[] = {1, 2, 3};
+    VariantMap map;
+    map["a"] = 1;
+    VariantHashMap hashMap;
+    hashMap["a"] = 1;
+
+    std::vector<Variant> values = {
+        Variant(), "12.5", "abc", std::vector<std::string>({"a", "b"}),
+        VariantVector() << 1 << "a", map, hashMap, 12ul, 12ull, -12l,
+        -12ll, 12u, 12, (unsigned short) 12, (short) -12, 12.5f, 12.5, true,
+        false, date, decimal, Variant(blob, sizeof(blob)), std::string(40, 'z')
+    };
+
+    for (auto &left : values) {
+        for (auto &right : values) {
+            int forward = left.compare(right);
+            int backward = right.compare(left);
+
+            EXPECT_EQ(forward < 0, backward > 0) << left.getType() << " "
+                                                 << right.getType();
+            EXPECT_EQ(forward == 0, left == right);
+            EXPECT_EQ(forward != 0, left != right);
+            EXPECT_EQ(forward < 0, left < right);
+            EXPECT_EQ(forward > 0, left > right);
+            EXPECT_EQ(forward <= 0, left <= right);
+            EXPECT_EQ(forward >= 0, left >= right);
+        }
+    }
+}
+
+// Tests numbers of different widths and signedness compare by value
+TEST_F(TestVariant, CompareMixedIntegers) {
+    std::vector<std::pair<Variant, Variant>> unequal = {
+        {5000000000ll, 705032704},
+        {-1, 18446744073709551615ull},
+        {-1ll, 4294967295u},
+        {(short) 1, 65537},
+        {(unsigned short) 1, 65537u},
+        {true, 5},
+        {9007199254740993ll, 9007199254740992.0},
+        {16777217, 16777216.0f},
+        {18446744073709551615ull, 18446744073709551616.0},
+    };
+
+    for (auto &pair : unequal) {
+        EXPECT_NE(pair.first, pair.second) << pair.first.toString();
+        EXPECT_NE(pair.second, pair.first) << pair.first.toString();
+    }
+
+    EXPECT_LT(Variant(-1), Variant(18446744073709551615ull));
+    EXPECT_GT(Variant(18446744073709551615ull), Variant(-1ll));
+    EXPECT_LT(Variant(705032704), Variant(5000000000ll));
+    EXPECT_LT(Variant(-2.5), Variant(-2ll));
+    EXPECT_GT(Variant(-2ll), Variant(-2.5f));
+    EXPECT_LT(Variant(3u), Variant(3.5));
+    EXPECT_LT(Variant(-1), Variant(0u));
+
+    std::vector<std::pair<Variant, Variant>> equal = {
+        {5000000000ll, 5000000000ull},
+        {(short) -7, -7ll},
+        {65537u, 65537ll},
+        {true, 1ull},
+        {false, (short) 0},
+        {9007199254740992ll, 9007199254740992.0},
+        {18446744073709551615ull, 18446744073709551615ull},
+        {-3, -3.0f},
+    };
+
+    for (auto &pair : equal) {
+        EXPECT_EQ(pair.first, pair.second) << pair.first.toString();
+        EXPECT_EQ(pair.first.hash(), pair.second.hash())
+                << pair.first.toString();
+    }
+
+    // Sorting needs a strict weak ordering across the types
+    std::vector<Variant> column = {
+        5000000000ll, 705032704, -1, 18446744073709551615ull, (short) 1,
+        2.5, true
+    };
+    std::sort(column.begin(), column.end());
+    EXPECT_EQ(Variant(-1), column[0]);
+    EXPECT_EQ(Variant(2.5), column[3]);
+    EXPECT_EQ(Variant(18446744073709551615ull), column[6]);
+}
+
+// Tests nulls only equal nulls and sort before everything else
+TEST_F(TestVariant, CompareNullsFirst) {
+    Variant null;
+
+    EXPECT_EQ(0, null.compare(Variant()));
+    EXPECT_FALSE(null < Variant());
+    EXPECT_FALSE(null > Variant());
+    EXPECT_LT(null, Variant(-5));
+    EXPECT_LT(null, Variant(""));
+    EXPECT_GT(Variant(-5), null);
+
+    std::vector<Variant> column = {3, Variant(), 1, Variant(), 2};
+    std::sort(column.begin(), column.end());
+    EXPECT_TRUE(column[0].isNull());
+    EXPECT_TRUE(column[1].isNull());
+    EXPECT_EQ(Variant(1), column[2]);
+    EXPECT_EQ(Variant(3), column[4]);
+}
+
 // Tests pointer memory management
 TEST_F(TestVariant, PointerCleanup) {
     TrackedPointer *p1 = new TrackedPointer();
@@ -359,6 +477,449 @@ TEST_F(TestVariant, PointerCleanup) {
     EXPECT_EQ(0, TrackedPointer::count);
 }
 
+// Tests that scalar variants are created, copied and destroyed without touching
+// the heap
+TEST_F(TestVariant, ScalarAllocationFree) {
+    AllocationCounter counter;
+    {
+        Variant v1(124);
+        Variant v2(v1);
+        Variant v3;
+        v3 = v2;
+        Variant v4((double) 124.8);
+        Variant v5(true);
+        Variant v6(nullptr);
+        v6 = v4;
+    }
+    EXPECT_EQ(0, counter.allocations());
+}
+
+// Tests that short strings are stored inline and long strings still work
+TEST_F(TestVariant, SmallStringStorage) {
+    std::string longString(100, 'x');
+    {
+        AllocationCounter counter;
+        Variant v1("short");
+        Variant v2(v1);
+        Variant v3;
+        v3 = v1;
+        EXPECT_EQ(0, counter.allocations());
+    }
+    Variant v1("short");
+    Variant v2(longString);
+    Variant v3(v2);
+    EXPECT_EQ("short", v1.toString());
+    EXPECT_EQ(longString, v2.toString());
+    EXPECT_EQ(longString, v3.toString());
+    v3 = v1;
+    EXPECT_EQ("short", v3.toString());
+    v1 = v2;
+    EXPECT_EQ(longString, v1.toString());
+}
+
+// Tests that moving a variant hands over its payload without copying it
+TEST_F(TestVariant, MoveConstructor) {
+    VariantVector vector;
+    for (int i = 0; i < 100; i++) {
+        vector << i;
+    }
+    Variant v1(vector);
+    {
+        AllocationCounter counter;
+        Variant v2(std::move(v1));
+        EXPECT_EQ(0, counter.allocations());
+        EXPECT_TRUE(v1.isNull());
+        EXPECT_EQ(v2, vector);
+    }
+}
+
+// Tests that move assignment hands over the payload and frees the old one
+TEST_F(TestVariant, MoveAssignment) {
+    TrackedPointer *pointer = new TrackedPointer();
+    Variant v1(VariantVector() << "abc" << 123);
+    Variant v2(pointer, true);
+    {
+        AllocationCounter counter;
+        v2 = std::move(v1);
+        EXPECT_EQ(0, counter.allocations());
+    }
+    EXPECT_EQ(0, TrackedPointer::count);
+    EXPECT_TRUE(v1.isNull());
+    EXPECT_EQ(v2, VariantVector() << "abc" << 123);
+
+    // Move an element of the held vector over the vector itself
+    VariantVector vector(VariantVector() << VariantVector() << "abc");
+    Variant v3(vector);
+    v3 = Variant(vector.front());
+    EXPECT_EQ(0, v3.toVariantVector().size());
+}
+
+// Tests that containers and query results are moved into variants
+TEST_F(TestVariant, MoveContainers) {
+    QueryResult result;
+    result.columns.push_back("column");
+    for (int i = 0; i < 100; i++) {
+        result.rows.push_back(VariantVector() << i);
+    }
+    VariantVector arguments;
+    arguments.reserve(2);
+    {
+        AllocationCounter counter;
+
+        // Only the new heap holder for the result may be allocated
+        arguments << 1 << std::move(result);
+        EXPECT_EQ(1, counter.allocations());
+    }
+    EXPECT_TRUE(result.rows.empty());
+    EXPECT_EQ(100, arguments.back().toQueryResult().rows.size());
+
+    VariantVector vector;
+    vector.append("abc").append(123);
+    EXPECT_EQ(Variant(vector), VariantVector() << "abc" << 123);
+}
+
+// Tests that copies of heap payloads are shared rather than deep copied
+TEST_F(TestVariant, SharedPayloadCopy) {
+    std::string longString(100, 'x');
+    VariantMap map;
+    map["abc"] = longString;
+    Variant v1(VariantVector() << longString << map << QueryResult());
+    {
+        AllocationCounter counter;
+        Variant v2(v1);
+        Variant v3;
+        v3 = v2;
+        Variant v4(longString);
+        Variant v5(v4);
+        EXPECT_EQ(1, counter.allocations());
+    }
+    EXPECT_EQ(longString, v1.toVariantVector().front().toString());
+    EXPECT_EQ(longString, v1.toVariantVector().at(1).toVariantMap().at("abc")
+        .toString());
+}
+
+// Tests that shared payloads survive being copied and released from multiple
+// threads at once
+TEST_F(TestVariant, SharedPayloadThreads) {
+    Variant value(VariantVector() << std::string(100, 'x') << 123);
+    std::vector<std::thread *> threads;
+
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(new std::thread([&value]() {
+            for (int j = 0; j < 10000; j++) {
+                Variant copy(value);
+                VariantVector vector;
+                vector << copy << copy;
+            }
+        }));
+    }
+
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        (*it)->join();
+        delete *it;
+    }
+
+    EXPECT_EQ(value, VariantVector() << std::string(100, 'x') << 123);
+}
+
+// Tests that the borrowing accessors return the held data only for their own
+// type
+TEST_F(TestVariant, BorrowingAccessors) {
+    std::vector<std::string> strings;
+    strings.push_back("abc");
+    strings.push_back("def");
+    VariantMap map;
+    map["abc"] = 123;
+
+    Variant string("test");
+    Variant stringVector(strings);
+    Variant variantVector(VariantVector() << 1 << "abc");
+    Variant variantMap(map);
+    Variant queryResult((QueryResult()));
+    Variant integer(123);
+
+    size_t length = 0;
+    EXPECT_STREQ("test", string.asString(&length));
+    EXPECT_EQ(4, length);
+    EXPECT_EQ(nullptr, integer.asString());
+    EXPECT_EQ(strings, *stringVector.asStringVector());
+    EXPECT_EQ(nullptr, string.asStringVector());
+    EXPECT_EQ(2, variantVector.asVariantVector()->size());
+    EXPECT_EQ(nullptr, stringVector.asVariantVector());
+    EXPECT_EQ(1, variantMap.asVariantMap()->size());
+    EXPECT_EQ(nullptr, variantVector.asVariantMap());
+    EXPECT_NE(nullptr, queryResult.asQueryResult());
+    EXPECT_EQ(nullptr, integer.asQueryResult());
+}
+
+// Tests the size and at helpers
+TEST_F(TestVariant, SizeAndAt) {
+    std::vector<std::string> strings;
+    strings.push_back("abc");
+    strings.push_back("def");
+
+    EXPECT_EQ(0, Variant().size());
+    EXPECT_EQ(1, Variant(123).size());
+    EXPECT_EQ(2, Variant(strings).size());
+    EXPECT_EQ(3, Variant(VariantVector() << 1 << 2 << 3).size());
+
+    EXPECT_EQ("def", Variant(strings).at(1).toString());
+    EXPECT_EQ(3, Variant(VariantVector() << 1 << 2 << 3).at(2).toInt());
+    EXPECT_EQ(123, Variant(123).at(0).toInt());
+    EXPECT_TRUE(Variant(123).at(1).isNull());
+    EXPECT_TRUE(Variant(strings).at(2).isNull());
+}
+
+// Tests that comparing containers of the same type does not copy them
+TEST_F(TestVariant, ComparisonAllocationFree) {
+    std::string longString(100, 'x');
+    Variant v1(VariantVector() << longString << 123 << "abc");
+    Variant v2(VariantVector() << longString << 123 << "abc");
+    Variant v3(longString);
+    Variant v4(longString);
+    {
+        AllocationCounter counter;
+        EXPECT_TRUE(v1 == v2);
+        EXPECT_FALSE(v1 < v2);
+        EXPECT_TRUE(v3 == v4);
+        EXPECT_TRUE(v3 <= v4);
+        EXPECT_EQ(0, counter.allocations());
+    }
+}
+
+// Tests 64 bit integers convert to and from strings
+TEST_F(TestVariant, LongLongConversions) {
+    Variant big(9223372036854775807LL);
+    Variant unsignedBig(18446744073709551615ULL);
+
+    EXPECT_EQ("9223372036854775807", big.toString());
+    EXPECT_EQ("18446744073709551615", unsignedBig.toString());
+    EXPECT_EQ(9223372036854775807LL, Variant("9223372036854775807")
+              .toLongLong());
+    EXPECT_EQ(18446744073709551615ULL, unsignedBig.toULongLong());
+    EXPECT_EQ(big, Variant("9223372036854775807"));
+    EXPECT_EQ(D_ULONG, Variant(5ul).getType());
+    EXPECT_EQ(5ul, Variant(5ul).toULong());
+}
+
+// Tests dates are stored packed and convert to and from strings
+TEST_F(TestVariant, DateTimeStorage) {
+    DateTime date;
+    ASSERT_TRUE(DateTime::parse("2020-02-29 13:45:07.25", 22, date));
+
+    AllocationCounter counter;
+    Variant value(date);
+    Variant copy(value);
+    EXPECT_EQ(0, counter.allocations());
+
+    EXPECT_EQ(D_DATETIME, value.getType());
+    EXPECT_EQ("2020-02-29 13:45:07.250000", value.toString());
+    EXPECT_EQ(20200229134507LL, value.toLongLong());
+    EXPECT_EQ(value, Variant("2020-02-29 13:45:07.250000"));
+    EXPECT_TRUE(value < Variant("2020-03-01"));
+    EXPECT_TRUE(value > Variant("2020-02-29 13:45:07"));
+
+    ASSERT_TRUE(DateTime::parse("2020-02-29", 10, date));
+    EXPECT_EQ("2020-02-29", Variant(date).toString());
+    EXPECT_EQ(20200229LL, Variant(date).toLongLong());
+    EXPECT_EQ(Variant(date), Variant("2020-02-29 00:00:00"));
+
+    ASSERT_TRUE(DateTime::parse("0000-00-00 00:00:00", 19, date));
+    EXPECT_EQ("0000-00-00 00:00:00", Variant(date).toString());
+
+    EXPECT_FALSE(DateTime::parse("2020-02-29x", 11, date));
+    EXPECT_FALSE(DateTime::parse("2020-13-01", 10, date));
+    EXPECT_FALSE(DateTime::parse("124.08", 6, date));
+}
+
+// Tests fixed-point decimals are stored exactly
+TEST_F(TestVariant, DecimalStorage) {
+    Decimal decimal;
+    ASSERT_TRUE(Decimal::parse("-12345.678", 10, decimal));
+
+    AllocationCounter counter;
+    Variant value(decimal);
+    EXPECT_EQ(0, counter.allocations());
+
+    EXPECT_EQ(D_DECIMAL, value.getType());
+    EXPECT_EQ("-12345.678", value.toString());
+    EXPECT_EQ(-12345, value.toInt());
+    EXPECT_DOUBLE_EQ(-12345.678, value.toDouble());
+    EXPECT_EQ(value, Variant("-12345.678"));
+    EXPECT_EQ(value, Variant("-12345.67800"));
+    EXPECT_EQ(value, Variant(-12345.678));
+    EXPECT_TRUE(value < Variant(-12345));
+    EXPECT_TRUE(value > Variant("-12345.679"));
+
+    ASSERT_TRUE(Decimal::parse("0.05", 4, decimal));
+    EXPECT_EQ("0.05", Variant(decimal).toString());
+    ASSERT_TRUE(Decimal::parse("-.5", 3, decimal));
+    EXPECT_EQ("-0.5", Variant(decimal).toString());
+    ASSERT_TRUE(Decimal::parse("100", 3, decimal));
+    EXPECT_EQ("100", Variant(decimal).toString());
+
+    EXPECT_FALSE(Decimal::parse("1234567890123456789", 19, decimal));
+    EXPECT_FALSE(Decimal::parse("1e5", 3, decimal));
+    EXPECT_FALSE(Decimal::parse("-", 1, decimal));
+}
+
+// Tests blobs keep arbitrary bytes, including nulls
+TEST_F(TestVariant, BlobStorage) {
+    const unsigned char bytes[] = {0x00, 0xff, 0x10, 0x00, 0x7f};
+    std::string longBytes(100, '\0');
+    size_t length;
+
+    Variant value(bytes, sizeof(bytes));
+    Variant longValue(reinterpret_cast<const unsigned char *>(
+                          longBytes.data()), longBytes.size());
+
+    EXPECT_EQ(D_BLOB, value.getType());
+    EXPECT_EQ(nullptr, value.asString());
+    ASSERT_NE(nullptr, value.asBlob(&length));
+    EXPECT_EQ(sizeof(bytes), length);
+    EXPECT_EQ(0, memcmp(bytes, value.asBlob(), sizeof(bytes)));
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(bytes),
+                          sizeof(bytes)), value.toString());
+    EXPECT_EQ(std::vector<unsigned char>(bytes, bytes + sizeof(bytes)),
+              value.toBlob());
+    EXPECT_EQ(value, Variant(bytes, sizeof(bytes)));
+    EXPECT_FALSE(value == Variant(bytes, sizeof(bytes) - 1));
+
+    Variant copy(longValue);
+    EXPECT_EQ(longValue.asBlob(), copy.asBlob());
+    EXPECT_EQ(longBytes, copy.toString());
+}
+
+// Tests that variants which compare equal hash equally
+TEST_F(TestVariant, HashConsistentWithEquality) {
+    Decimal decimal;
+    DateTime date;
+    ASSERT_TRUE(Decimal::parse("1.50", 4, decimal));
+    ASSERT_TRUE(DateTime::parse("2020-01-01 10:00:00", 19, date));
+
+    std::vector<std::pair<Variant, Variant>> pairs = {
+        {1, "1"},
+        {1, 1.0},
+        {1, 1ll},
+        {(unsigned short) 7, 7ul},
+        {1.5f, 1.5},
+        {0.1f, 0.1},
+        {true, 1},
+        {true, "TRUE"},
+        {false, "false"},
+        {decimal, "1.5"},
+        {decimal, 1.5},
+        {date, "2020-01-01 10:00:00"},
+        {std::string(100, 'x'), std::string(100, 'x')},
+        {"a", VariantVector() << "a"},
+        {VariantVector() << 1 << "a", VariantVector() << "1" << "a"},
+        {VariantVector() << "b" << "c", std::vector<std::string>({"b", "c"})},
+    };
+
+    for (auto &pair : pairs) {
+        ASSERT_EQ(pair.first, pair.second) << pair.first.toString();
+        EXPECT_EQ(pair.first.hash(), pair.second.hash())
+                << pair.first.toString();
+    }
+
+    EXPECT_NE(Variant("a").hash(), Variant("b").hash());
+    EXPECT_NE(Variant(1).hash(), Variant(2).hash());
+    EXPECT_EQ(std::hash<Variant>()(Variant(5)), Variant("5").hash());
+}
+
+// Tests looking up and storing variant hash maps
+TEST_F(TestVariant, VariantHashMapLookup) {
+    VariantHashMap map;
+    map[1] = "one";
+    map["two"] = 2;
+    map[std::string(40, 'k')] = "long";
+
+    EXPECT_EQ(Variant("one"), map.at("1"));
+    EXPECT_EQ(Variant(2), map.at("two"));
+    EXPECT_EQ(map.end(), map.find("three"));
+
+    Variant value(map);
+    EXPECT_EQ(D_VARIANTHASHMAP, value.getType());
+    EXPECT_EQ(3u, value.size());
+    ASSERT_NE(nullptr, value.asVariantHashMap());
+    EXPECT_EQ(map, *value.asVariantHashMap());
+
+    // Copies share the map
+    Variant copy(value);
+    EXPECT_EQ(value.asVariantHashMap(), copy.asVariantHashMap());
+
+    // Values that only compare equal through a lossy conversion are
+    // different keys, whichever is looked up
+    std::vector<std::pair<Variant, Variant>> lossy = {
+        {0, "abc"},
+        {1, "1abc"},
+        {false, "no"},
+    };
+
+    for (auto &pair : lossy) {
+        VariantHashMap keys;
+        ASSERT_EQ(pair.first, pair.second) << pair.first.toString();
+        keys[pair.first] = 1;
+        keys[pair.second] = 2;
+
+        ASSERT_EQ(2u, keys.size()) << pair.first.toString();
+        EXPECT_EQ(Variant(1), keys.at(pair.first)) << pair.first.toString();
+        EXPECT_EQ(Variant(2), keys.at(pair.second)) << pair.first.toString();
+    }
+
+    // Converting to and from VariantMap turns keys into strings
+    auto stringMap = value.toVariantMap();
+    EXPECT_EQ(Variant("one"), stringMap["1"]);
+    EXPECT_EQ(value, Variant(stringMap));
+    EXPECT_EQ(value.hash(), Variant(stringMap).hash());
+}
+
+// Tests VariantMap keeps keys sorted and unique like std::map
+TEST_F(TestVariant, VariantMapOrdering) {
+    VariantMap map;
+    map["port"] = 3306;
+    map["hostname"] = "localhost";
+    map["username"] = "root";
+    map["hostname"] = "example.com";
+
+    std::vector<std::string> keys;
+    for (auto &pair : map) {
+        keys.push_back(pair.first);
+    }
+
+    EXPECT_EQ(std::vector<std::string>({"hostname", "port", "username"}),
+              keys);
+    EXPECT_EQ(Variant("example.com"), map.at("hostname"));
+    EXPECT_EQ(1u, map.count("port"));
+    EXPECT_EQ(map.end(), map.find("password"));
+    EXPECT_THROW(map.at("password"), std::out_of_range);
+    EXPECT_FALSE(map.insert(std::make_pair("port", Variant(1))).second);
+    EXPECT_EQ(Variant(3306), map["port"]);
+
+    EXPECT_EQ(1u, map.erase("port"));
+    EXPECT_EQ(0u, map.erase("port"));
+    map.erase(map.find("hostname"));
+    EXPECT_EQ(1u, map.size());
+    EXPECT_EQ("username", map.begin()->first);
+
+    // Comparisons follow std::map
+    VariantMap other = {{"username", "root"}};
+    EXPECT_EQ(map, other);
+    other["username"] = "admin";
+    EXPECT_TRUE(other < map);
+    EXPECT_TRUE(map > other);
+
+    // A reserved map of short keys is filled without allocating
+    VariantMap small;
+    small.reserve(3);
+    AllocationCounter counter;
+    small["c"] = 3;
+    small["a"] = "one";
+    small["b"] = 2.0;
+    EXPECT_EQ(0, counter.allocations());
+    EXPECT_EQ("a", small.begin()->first);
+}
+
 // This test macro is the same for all single type tests. It is very similar to
 // the multi-type test (VariantFileIO.BinaryIOMultipleTypes). Please see that
 // for functionality comments.
@@ -416,6 +977,19 @@ TEST_F(TestVariant, FileIOBinaryIOVariantMap) {
     TEST_BINARY_SINGLE(VariantMap, map);
 }
 
+// Tests reading and writing of a single Variant hash map variant from and to
+// binary files
+TEST_F(TestVariant, FileIOBinaryIOVariantHashMap) {
+    VariantHashMap map;
+    map[123] = "int key";
+    map["bool"] = false;
+    map["string"] = "test";
+
+    TEST_BINARY_SINGLE(VariantHashMap, map);
+    ASSERT_NE(nullptr, variant.asVariantHashMap());
+    EXPECT_EQ(D_INT, variant.asVariantHashMap()->find(123)->first.getType());
+}
+
 // Tests reading and writing of a single long variant from and to binary files
 TEST_F(TestVariant, FileIOBinaryIOULong) {
     TEST_BINARY_SINGLE(unsigned long, 1);
@@ -466,11 +1040,163 @@ TEST_F(TestVariant, FileIOBinaryIODouble) {
     TEST_BINARY_SINGLE(float, 1);
 }
 
+// Tests reading and writing of a single long long variant from and to binary
+// files
+TEST_F(TestVariant, FileIOBinaryIOLongLong) {
+    TEST_BINARY_SINGLE(long long, -9223372036854775807LL);
+}
+
+// Tests reading and writing of a single unsigned long long variant from and to
+// binary files
+TEST_F(TestVariant, FileIOBinaryIOULongLong) {
+    TEST_BINARY_SINGLE(unsigned long long, 18446744073709551615ULL);
+}
+
+// Tests reading and writing of a single date variant from and to binary files
+TEST_F(TestVariant, FileIOBinaryIODateTime) {
+    DateTime date;
+    ASSERT_TRUE(DateTime::parse("2038-01-19 03:14:08.123456", 26, date));
+    TEST_BINARY_SINGLE(DateTime, date);
+}
+
+// Tests reading and writing of a single decimal variant from and to binary
+// files
+TEST_F(TestVariant, FileIOBinaryIODecimal) {
+    Decimal decimal;
+    ASSERT_TRUE(Decimal::parse("99999999999.9999999", 19, decimal));
+    TEST_BINARY_SINGLE(Decimal, decimal);
+}
+
+// Tests reading and writing of a single blob variant from and to binary files
+TEST_F(TestVariant, FileIOBinaryIOBlob) {
+    BinaryFileStream stream;
+    const char raw[] = "\0\1\2 binary data longer than sixteen bytes";
+    std::string bytes(raw, sizeof(raw) - 1);
+    Variant variant(reinterpret_cast<const unsigned char *>(bytes.data()),
+                    bytes.size());
+
+    stream.open(filename, std::ios::out);
+    stream << variant;
+    stream.close();
+    variant = "a value that must not conflict with the tests";
+    stream.open(filename, std::ios::in);
+    stream >> variant;
+    stream.close();
+
+    EXPECT_EQ(D_BLOB, variant.getType());
+    EXPECT_EQ(bytes, variant.toString());
+}
+
 // Tests reading and writing of a single long variant from and to binary files
 TEST_F(TestVariant, FileIOBinaryIOQueryResult) {
     TEST_BINARY_SINGLE(QueryResult, QueryResult());
 }
 
+// Tests reading and writing of a query result with rows from and to binary
+// files
+TEST_F(TestVariant, FileIOBinaryIOQueryResultRows) {
+    BinaryFileStream stream;
+    QueryResult result;
+    ColumnInfo info;
+    size_t count = ResultRows::BLOCK_ROWS + 100;
+
+    result.uid = "result";
+    result.is_valid = true;
+    result.affected_rows = 3;
+    result.num_rows = static_cast<int>(count);
+    result.event = EXECUTE_QUERY;
+    result.error.isError = true;
+    result.error.code = 1064;
+    result.error.string = "syntax error";
+    result.columns = {"id", "price", "name", "mixed", "status"};
+    info.name = "price";
+    info.table = "items";
+    info.sqlType = "DOUBLE";
+    info.type = D_DOUBLE;
+    info.nullable = false;
+    info.length = 22;
+    info.decimals = 2;
+    result.columnInfo.push_back(info);
+
+    result.rows.setColumnCount(5);
+    for (size_t i = 0; i < count; i++) {
+        result.rows.addRow();
+        result.rows.appendTo(0).append(static_cast<long long>(i));
+        result.rows.appendTo(1).append(i * 0.5);
+
+        if (i % 7 == 0) {
+            result.rows.appendTo(2).appendNull();
+        } else {
+            result.rows.appendTo(2).append("name " + std::to_string(i));
+        }
+
+        if (i % 2 == 0) {
+            result.rows.appendTo(3).append(static_cast<long long>(i));
+        } else {
+            result.rows.appendTo(3).append(std::to_string(i));
+        }
+
+        result.rows.appendTo(4).append(i % 3 == 0 ? "open" : "closed");
+    }
+
+    stream.open(filename, std::ios::out);
+    stream << Variant(result);
+    stream.close();
+
+    Variant variant;
+    stream.open(filename, std::ios::in);
+    stream >> variant;
+    stream.close();
+
+    ASSERT_EQ(D_QUERYRESULT, variant.getType());
+    const QueryResult *loaded = variant.asQueryResult();
+
+    EXPECT_EQ(result.uid, loaded->uid);
+    EXPECT_TRUE(loaded->is_valid);
+    EXPECT_EQ(3, loaded->affected_rows);
+    EXPECT_EQ(result.num_rows, loaded->num_rows);
+    EXPECT_EQ(EXECUTE_QUERY, loaded->event);
+    EXPECT_TRUE(loaded->error.isError);
+    EXPECT_EQ(1064, loaded->error.code.toInt());
+    EXPECT_EQ("syntax error", loaded->error.string);
+    EXPECT_EQ(result.columns, loaded->columns);
+    ASSERT_EQ(1u, loaded->columnInfo.size());
+    EXPECT_EQ("price", loaded->columnInfo[0].name);
+    EXPECT_EQ("items", loaded->columnInfo[0].table);
+    EXPECT_EQ("DOUBLE", loaded->columnInfo[0].sqlType);
+    EXPECT_EQ(D_DOUBLE, loaded->columnInfo[0].type);
+    EXPECT_FALSE(loaded->columnInfo[0].nullable);
+    EXPECT_EQ(22u, loaded->columnInfo[0].length);
+    EXPECT_EQ(2u, loaded->columnInfo[0].decimals);
+
+    ASSERT_EQ(count, loaded->rows.size());
+    ASSERT_EQ(5u, loaded->rows.columnCount());
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < 5; j++) {
+            ASSERT_EQ(result.rows.at(i, j), loaded->rows.at(i, j));
+            ASSERT_EQ(result.rows.at(i, j).getType(),
+                      loaded->rows.at(i, j).getType());
+        }
+    }
+
+    // Truncated data loads as an empty result
+    std::string data;
+    std::ifstream in(filename, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size() / 2);
+    out.close();
+
+    stream.open(filename, std::ios::in);
+    stream >> variant;
+    stream.close();
+
+    ASSERT_EQ(D_QUERYRESULT, variant.getType());
+    EXPECT_TRUE(variant.asQueryResult()->rows.empty());
+}
+
 // Tests reading and writing of a single long variant from and to binary files
 TEST_F(TestVariant, FileIOBinaryIOMultipleTypes) {
     BinaryFileStream stream;
@@ -582,6 +1308,17 @@ TEST_F(TestVariant, FileIOJsonIOVariantMap) {
     TEST_JSON_SINGLE(VariantMap, map);
 }
 
+// Tests writing of a single Variant hash map variant to json files. JSON keys
+// are strings, so it reads back as an equal VariantMap.
+TEST_F(TestVariant, FileIOJsonIOVariantHashMap) {
+    VariantHashMap map;
+    map["int"] = 123;
+    map["bool"] = false;
+    map["string"] = "test";
+
+    TEST_JSON_SINGLE(VariantHashMap, map);
+}
+
 // Tests reading and writing of a single long variant from and to json files
 TEST_F(TestVariant, FileIOJsonIOULong) {
     TEST_JSON_SINGLE(unsigned long, 1);